@@ -0,0 +1,269 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "block_pool.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Whether this core has the exclusive access instructions
+#if defined(__CORTEX_M) && (__CORTEX_M >= 3)
+# define BLOCK_POOL_HAS_EXCLUSIVES 1
+#else
+# define BLOCK_POOL_HAS_EXCLUSIVES 0
+#endif
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The list of pools, most recently constructed first
+static BlockPoolBase * gpFirstPool = NULL;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Atomically add delta to *pValue, returning the new value
+static uint32_t atomicAdd(volatile uint32_t *pValue, int32_t delta)
+{
+    uint32_t value;
+
+#if BLOCK_POOL_HAS_EXCLUSIVES
+    do
+    {
+        value = __LDREXW(pValue) + delta;
+    } while (__STREXW(value, pValue) != 0);
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    value = *pValue + delta;
+    *pValue = value;
+    __set_PRIMASK(primask);
+#endif
+
+    return value;
+}
+
+// Atomically raise *pValue to value if it is lower
+static void atomicMax(volatile uint32_t *pValue, uint32_t value)
+{
+#if BLOCK_POOL_HAS_EXCLUSIVES
+    do
+    {
+        if (__LDREXW(pValue) >= value)
+        {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(value, pValue) != 0);
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (*pValue < value)
+    {
+        *pValue = value;
+    }
+    __set_PRIMASK(primask);
+#endif
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up a pool, threading the free list through the blocks
+BlockPoolBase::BlockPoolBase(const char *pName, void *pStorage, size_t blockSizeBytes,
+                             size_t strideBytes, uint32_t numBlocks)
+{
+    char *pBlock;
+
+    _pName = pName;
+    _pStorage = (char *) pStorage;
+    _blockSizeBytes = blockSizeBytes;
+    _strideBytes = strideBytes;
+    _numBlocks = numBlocks;
+    _numUsed = 0;
+    _peakUsed = 0;
+    _numFailures = 0;
+
+    _pFree = NULL;
+    for (uint32_t x = numBlocks; x > 0; x--)
+    {
+        pBlock = _pStorage + ((x - 1) * strideBytes);
+        *(void **) pBlock = _pFree;
+        _pFree = pBlock;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _pNext = gpFirstPool;
+    gpFirstPool = this;
+    __set_PRIMASK(primask);
+}
+
+// Remove a pool from the list
+BlockPoolBase::~BlockPoolBase()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (BlockPoolBase **ppPool = &gpFirstPool; *ppPool != NULL; ppPool = &(*ppPool)->_pNext)
+    {
+        if (*ppPool == this)
+        {
+            *ppPool = _pNext;
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+// Take a block from the head of the free list
+void * BlockPoolBase::alloc()
+{
+    void *pBlock;
+
+#if BLOCK_POOL_HAS_EXCLUSIVES
+    // If anything else gets in between the load and the store, even if
+    // it leaves the same block at the head, the store fails; reading
+    // the link of a block that has been taken meanwhile is harmless
+    do
+    {
+        pBlock = (void *) __LDREXW((volatile uint32_t *) &_pFree);
+        if (pBlock == NULL)
+        {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW((uint32_t) *(void **) pBlock, (volatile uint32_t *) &_pFree) != 0);
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pBlock = _pFree;
+    if (pBlock != NULL)
+    {
+        _pFree = *(void **) pBlock;
+    }
+    __set_PRIMASK(primask);
+#endif
+
+    if (pBlock != NULL)
+    {
+        atomicMax(&_peakUsed, atomicAdd(&_numUsed, 1));
+    }
+    else
+    {
+        atomicAdd(&_numFailures, 1);
+    }
+
+    return pBlock;
+}
+
+// Put a block back on the head of the free list
+bool BlockPoolBase::free(void *pBlock)
+{
+    if (pBlock == NULL)
+    {
+        return true;
+    }
+    if (!contains(pBlock) || ((((char *) pBlock - _pStorage) % _strideBytes) != 0))
+    {
+        return false;
+    }
+
+#if BLOCK_POOL_HAS_EXCLUSIVES
+    void *pFree;
+    do
+    {
+        pFree = (void *) __LDREXW((volatile uint32_t *) &_pFree);
+        *(void **) pBlock = pFree;
+    } while (__STREXW((uint32_t) pBlock, (volatile uint32_t *) &_pFree) != 0);
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *(void **) pBlock = _pFree;
+    _pFree = pBlock;
+    __set_PRIMASK(primask);
+#endif
+
+    atomicAdd(&_numUsed, -1);
+
+    return true;
+}
+
+// Whether a pointer is in this pool
+bool BlockPoolBase::contains(const void *pMem) const
+{
+    return ((const char *) pMem >= _pStorage) &&
+           ((const char *) pMem < _pStorage + (_numBlocks * _strideBytes));
+}
+
+// Get the statistics for this pool
+void BlockPoolBase::getStats(BlockPoolStats_t *pStats) const
+{
+    if (pStats != NULL)
+    {
+        pStats->pName = _pName;
+        pStats->blockSizeBytes = _blockSizeBytes;
+        pStats->numBlocks = _numBlocks;
+        pStats->numUsed = _numUsed;
+        pStats->peakUsed = _peakUsed;
+        pStats->numFailures = _numFailures;
+    }
+}
+
+// Walk the free list, which is left as it is
+bool BlockPoolBase::check() const
+{
+    const void *pBlock;
+    uint32_t numFree = 0;
+    uint32_t expectedFree;
+    bool success = true;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    expectedFree = _numBlocks - _numUsed;
+    pBlock = _pFree;
+    // A block that is on the list twice makes it endless, so stop one
+    // past the number expected
+    while (success && (pBlock != NULL) && (numFree <= expectedFree))
+    {
+        success = contains(pBlock) && ((((const char *) pBlock - _pStorage) % _strideBytes) == 0);
+        if (success)
+        {
+            numFree++;
+            pBlock = *(void * const *) pBlock;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return success && (pBlock == NULL) && (numFree == expectedFree);
+}
+
+// The first pool in the list
+BlockPoolBase * BlockPoolBase::first()
+{
+    return gpFirstPool;
+}
+
+// The next pool in the list
+BlockPoolBase * BlockPoolBase::next() const
+{
+    return _pNext;
+}
@@ -0,0 +1,141 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BLOCK_POOL_H_
+#define _BLOCK_POOL_H_
+
+#include "mbed.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The alignment of every block handed out, as malloc() would give
+#define BLOCK_POOL_ALIGNMENT 8
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// Statistics on a pool
+typedef struct
+{
+    const char * pName;
+    size_t blockSizeBytes;     // As asked for, not rounded up
+    uint32_t numBlocks;
+    uint32_t numUsed;          // Blocks currently allocated
+    uint32_t peakUsed;         // The most numUsed has been
+    uint32_t numFailures;      // Calls to alloc() with no block free
+} BlockPoolStats_t;
+
+// ----------------------------------------------------------------
+// CLASSES
+// ----------------------------------------------------------------
+
+// A pool of fixed-size blocks to sit beside malloc() for buffers of a
+// few well-known sizes (serial frames, AT command lines, UDP payloads,
+// ...): alloc() and free() take constant time and can be called from
+// any context, including interrupts, without locking.  The free
+// blocks form a singly-linked list through their first word; on
+// Cortex-M3 and above it is updated with LDREX/STREX, which an
+// interrupt in between makes fail and retry, so the list can't be
+// corrupted (the "ABA" problem doesn't arise either, since any
+// intervening exception clears the exclusive monitor), elsewhere
+// interrupts are masked for the few instructions of the update.
+// Every pool is added to a list on construction so that its usage can
+// be reported.  Declare pools with BlockPool<>, below.
+class BlockPoolBase
+{
+public:
+    // Take a block, returns NULL if there are none free
+    void * alloc();
+
+    // Give a block back; returns false, doing nothing, if pBlock is
+    // not one of this pool's (NULL is ignored and returns true).
+    // Freeing a block twice is not detected.
+    bool free(void *pBlock);
+
+    // Whether pMem points into one of this pool's blocks
+    bool contains(const void *pMem) const;
+
+    // Get the statistics for this pool
+    void getStats(BlockPoolStats_t *pStats) const;
+
+    // Check the free list, without taking any block or touching the
+    // statistics: every free block must be one of this pool's and
+    // there must be exactly as many as are not in use.  Interrupts are
+    // masked while the list is walked.
+    bool check() const;
+
+    // Walk the list of pools, returns NULL at the end
+    static BlockPoolBase * first();
+    BlockPoolBase * next() const;
+
+    // Remove this pool from the list of pools
+    ~BlockPoolBase();
+
+protected:
+    // Set up a pool of numBlocks blocks, strideBytes apart, in the
+    // memory at pStorage, and add it to the list of pools
+    BlockPoolBase(const char *pName, void *pStorage, size_t blockSizeBytes,
+                  size_t strideBytes, uint32_t numBlocks);
+
+private:
+    // Not to be copied, since a copy would share the original's free
+    // list and storage; declared but not defined
+    BlockPoolBase(const BlockPoolBase &);
+    BlockPoolBase & operator=(const BlockPoolBase &);
+
+    const char * _pName;
+    char * _pStorage;
+    size_t _blockSizeBytes;
+    size_t _strideBytes;
+    uint32_t _numBlocks;
+    void * volatile _pFree;
+    volatile uint32_t _numUsed;
+    volatile uint32_t _peakUsed;
+    volatile uint32_t _numFailures;
+    BlockPoolBase * _pNext;
+};
+
+// A pool of NUM_BLOCKS blocks of BLOCK_SIZE bytes, with its storage
+// inside it, e.g.:
+//
+// static BlockPool<64, 8> gFramePool("serial frames");
+template <size_t BLOCK_SIZE, uint32_t NUM_BLOCKS>
+class BlockPool : public BlockPoolBase
+{
+public:
+    BlockPool(const char *pName) :
+        BlockPoolBase(pName, _storage, BLOCK_SIZE, STRIDE_BYTES, NUM_BLOCKS) {}
+
+private:
+    // Each block must at least hold the free list pointer and is
+    // rounded up to the alignment
+    enum
+    {
+        MIN_BYTES = (BLOCK_SIZE > sizeof (void *)) ? BLOCK_SIZE : sizeof (void *),
+        STRIDE_BYTES = (MIN_BYTES + BLOCK_POOL_ALIGNMENT - 1) & ~(BLOCK_POOL_ALIGNMENT - 1)
+    };
+
+    // Fails to compile if there are no blocks
+    typedef char NumBlocksMustNotBeZero[(NUM_BLOCKS > 0) ? 1 : -1];
+
+    uint64_t _storage[(STRIDE_BYTES / sizeof (uint64_t)) * NUM_BLOCKS];
+};
+
+#endif // _BLOCK_POOL_H_
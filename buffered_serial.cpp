@@ -0,0 +1,129 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "buffered_serial.h"
+#include "event_trace.h"
+
+// ----------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// ----------------------------------------------------------------
+
+// Receive interrupt: move everything the UART has into the buffer
+void BufferedRawSerial::rxIrq()
+{
+    uint32_t count = 0;
+
+    EVENT_TRACE_BEGIN(EVENT_TRACE_ID_SERIAL_RX_IRQ, 0);
+    while (_pSerial->readable())
+    {
+        if (!_rx.put((uint8_t) _pSerial->getc()))
+        {
+            _rxOverflows++;
+        }
+        count++;
+    }
+    EVENT_TRACE_END(EVENT_TRACE_ID_SERIAL_RX_IRQ, count);
+    (void) count;
+}
+
+// Transmit interrupt: feed the UART from the buffer and switch the
+// interrupt off when there is nothing left to send
+void BufferedRawSerial::txIrq()
+{
+    uint8_t c;
+    uint32_t count = 0;
+
+    EVENT_TRACE_BEGIN(EVENT_TRACE_ID_SERIAL_TX_IRQ, 0);
+    while (_pSerial->writeable() && _tx.get(&c))
+    {
+        _pSerial->putc(c);
+        count++;
+    }
+
+    if (_tx.used() == 0)
+    {
+        _pSerial->attach(Callback<void()>(), SerialBase::TxIrq);
+    }
+    EVENT_TRACE_END(EVENT_TRACE_ID_SERIAL_TX_IRQ, count);
+    (void) count;
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Constructor
+BufferedRawSerial::BufferedRawSerial(RawSerial *pSerial) :
+    _pSerial(pSerial), _rxOverflows(0)
+{
+    _pSerial->attach(callback(this, &BufferedRawSerial::rxIrq), SerialBase::RxIrq);
+}
+
+// Read received bytes
+int BufferedRawSerial::read(char *pBuf, int size)
+{
+    int count = 0;
+
+    if ((pBuf != NULL) && (size > 0))
+    {
+        count = (int) _rx.read((uint8_t *) pBuf, (uint32_t) size);
+    }
+
+    return count;
+}
+
+// Queue bytes for transmission
+int BufferedRawSerial::write(const char *pBuf, int size)
+{
+    uint32_t primask;
+    int count = 0;
+
+    if ((pBuf != NULL) && (size > 0))
+    {
+        count = (int) _tx.write((const uint8_t *) pBuf, (uint32_t) size);
+        if (count > 0)
+        {
+            // Make sure the transmit interrupt is on; this must not
+            // race with txIrq() switching it off
+            primask = __get_PRIMASK();
+            __disable_irq();
+            _pSerial->attach(callback(this, &BufferedRawSerial::txIrq), SerialBase::TxIrq);
+            __set_PRIMASK(primask);
+        }
+    }
+
+    return count;
+}
+
+// Bytes waiting to be read
+int BufferedRawSerial::readable() const
+{
+    return (int) _rx.used();
+}
+
+// Space for bytes to be queued
+int BufferedRawSerial::writeable() const
+{
+    return (int) _tx.space();
+}
+
+// Receive overflows
+uint32_t BufferedRawSerial::rxOverflows() const
+{
+    return _rxOverflows;
+}
@@ -0,0 +1,80 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BUFFERED_SERIAL_H_
+#define _BUFFERED_SERIAL_H_
+
+#include "mbed.h"
+#include "ring_buffer.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The sizes of the receive and transmit buffers, which must be
+// powers of two
+#ifndef BUFFERED_SERIAL_RX_SIZE
+# define BUFFERED_SERIAL_RX_SIZE 256
+#endif
+#ifndef BUFFERED_SERIAL_TX_SIZE
+# define BUFFERED_SERIAL_TX_SIZE 256
+#endif
+
+// ----------------------------------------------------------------
+// CLASSES
+// ----------------------------------------------------------------
+
+// Interrupt-driven buffering on top of a RawSerial: the receive
+// interrupt fills one ring buffer and the transmit interrupt drains
+// another, so that the caller need neither poll nor block and can
+// sleep between interrupts.  One context (e.g. the main loop) should
+// do all of the reading and one all of the writing.
+class BufferedRawSerial
+{
+public:
+    // Take over the interrupts of the given serial port
+    BufferedRawSerial(RawSerial *pSerial);
+
+    // Read up to size bytes that have been received, without blocking.
+    // Returns the number of bytes read.
+    int read(char *pBuf, int size);
+
+    // Queue up to size bytes for transmission, without blocking.
+    // Returns the number of bytes queued.
+    int write(const char *pBuf, int size);
+
+    // The number of bytes waiting to be read
+    int readable() const;
+
+    // The number of bytes that can be queued for transmission
+    int writeable() const;
+
+    // The number of received bytes thrown away because the receive
+    // buffer was full
+    uint32_t rxOverflows() const;
+
+private:
+    void rxIrq();
+    void txIrq();
+
+    RawSerial * _pSerial;
+    RingBuffer<BUFFERED_SERIAL_RX_SIZE> _rx;
+    RingBuffer<BUFFERED_SERIAL_TX_SIZE> _tx;
+    volatile uint32_t _rxOverflows;
+};
+
+#endif // _BUFFERED_SERIAL_H_
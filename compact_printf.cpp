@@ -0,0 +1,666 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "compact_printf.h"
+#include "cycle_counter.h"
+#include "stack_paint.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of calls of each formatter that compactPrintfBenchmark()
+// times for each format
+#ifndef COMPACT_PRINTF_BENCHMARK_ITERATIONS
+# define COMPACT_PRINTF_BENCHMARK_ITERATIONS 100
+#endif
+
+// The most stack compactPrintfBenchmark() looks for a formatter
+// using, which must be free below the benchmark
+#ifndef COMPACT_PRINTF_BENCHMARK_STACK_BYTES
+# define COMPACT_PRINTF_BENCHMARK_STACK_BYTES 1024
+#endif
+
+// The size of the buffer the benchmark formats into
+#define COMPACT_PRINTF_BENCHMARK_BUFFER_BYTES 128
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The widest integers that are converted
+#if COMPACT_PRINTF_LONG_LONG
+typedef unsigned long long CompactUint_t;
+typedef long long CompactInt_t;
+#else
+typedef unsigned long CompactUint_t;
+typedef long CompactInt_t;
+#endif
+
+// What compactVsnprintf() writes to
+typedef struct
+{
+    char *pBuf;
+    size_t size;               // Room for characters, leaving the terminator
+    size_t length;             // Characters written
+} CompactBuffer_t;
+
+// A formatter for the benchmark: snprintf() or compactSnprintf()
+typedef int (*CompactFormatter_t)(char *pBuf, size_t size, const char *pFormat, ...);
+
+// A format the benchmark times
+typedef struct
+{
+    const char *pName;
+    int (*pFormat)(CompactFormatter_t pFormatter, char *pBuf, size_t size);
+} CompactBenchmarkCase_t;
+
+// A call made by stackPaintMeasureCall() for the benchmark
+typedef struct
+{
+    const CompactBenchmarkCase_t *pCase;
+    CompactFormatter_t pFormatter;
+    char *pBuf;
+} CompactBenchmarkCall_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Where compactPrintf() writes to
+static int (*gpWrite)(void *pParam, const char *pBuf, int size) = NULL;
+static void *gpWriteParam = NULL;
+
+// Padding, written in runs of up to this length
+static const char gSpaces[] = "                ";
+#if COMPACT_PRINTF_WIDTH
+static const char gZeros[] = "0000000000000000";
+#endif
+
+#if COMPACT_PRINTF_SPEED
+// The decimal digits of 0 to 99
+static const char gDigitPairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                  "8081828384858687888990919293949596979899";
+#endif
+
+// The buffers the benchmark formats into, kept off the stack so as
+// not to be counted in it
+static char gBenchmarkBuffers[2][COMPACT_PRINTF_BENCHMARK_BUFFER_BYTES];
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Get an unsigned argument with numLongs 'l' length modifiers
+static CompactUint_t getUnsigned(va_list *pArgs, uint32_t numLongs)
+{
+#if COMPACT_PRINTF_LONG_LONG
+    if (numLongs > 1)
+    {
+        return va_arg(*pArgs, unsigned long long);
+    }
+#endif
+    if (numLongs > 0)
+    {
+        return va_arg(*pArgs, unsigned long);
+    }
+
+    return va_arg(*pArgs, unsigned int);
+}
+
+#if COMPACT_PRINTF_SIGNED
+// Get a signed argument with numLongs 'l' length modifiers, returning
+// its magnitude and setting *pNegative
+static CompactUint_t getSigned(va_list *pArgs, uint32_t numLongs, bool *pNegative)
+{
+    CompactInt_t value;
+
+#if COMPACT_PRINTF_LONG_LONG
+    if (numLongs > 1)
+    {
+        value = va_arg(*pArgs, long long);
+    }
+    else
+#endif
+    if (numLongs > 0)
+    {
+        value = va_arg(*pArgs, long);
+    }
+    else
+    {
+        value = va_arg(*pArgs, int);
+    }
+
+    *pNegative = (value < 0);
+
+    return *pNegative ? 0 - (CompactUint_t) value : (CompactUint_t) value;
+}
+#endif
+
+// Skip the argument of a conversion that is known but has been left
+// out, with numLongs 'l' length modifiers, so that the arguments after
+// it stay in step; that of a conversion not known is left alone.
+static void skipArgument(va_list *pArgs, char conversion, uint32_t numLongs)
+{
+    switch (conversion)
+    {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (numLongs > 1)
+            {
+                (void) va_arg(*pArgs, long long);
+            }
+            else if (numLongs > 0)
+            {
+                (void) va_arg(*pArgs, long);
+            }
+            else
+            {
+                (void) va_arg(*pArgs, int);
+            }
+            break;
+        case 'p':
+        case 's':
+            (void) va_arg(*pArgs, void *);
+            break;
+        case 'c':
+            (void) va_arg(*pArgs, int);
+            break;
+        default:
+            break;
+    }
+}
+
+// Convert value to digits ending at pEnd, in hex or decimal.
+// Returns a pointer to the first digit.
+static char * formatUnsigned(char *pEnd, CompactUint_t value, bool hex, bool upperCase)
+{
+    char *p = pEnd;
+
+#if COMPACT_PRINTF_HEX
+    if (hex)
+    {
+        const char *pDigits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+        do
+        {
+            *--p = pDigits[value & 0x0f];
+            value >>= 4;
+        }
+        while (value != 0);
+
+        return p;
+    }
+#else
+    (void) hex;
+    (void) upperCase;
+#endif
+
+#if COMPACT_PRINTF_SPEED
+    uint32_t index;
+
+    while (value >= 100)
+    {
+        index = (uint32_t) (value % 100) * 2;
+        value /= 100;
+        *--p = gDigitPairs[index + 1];
+        *--p = gDigitPairs[index];
+    }
+    if (value >= 10)
+    {
+        index = (uint32_t) value * 2;
+        *--p = gDigitPairs[index + 1];
+        *--p = gDigitPairs[index];
+    }
+    else
+    {
+        *--p = '0' + (char) value;
+    }
+#else
+    do
+    {
+        *--p = '0' + (char) (value % 10);
+        value /= 10;
+    }
+    while (value != 0);
+#endif
+
+    return p;
+}
+
+// Write count copies of the character in pPad, a run of which is
+// padSize long
+static void writePadding(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam,
+                         const char *pPad, int padSize, int count)
+{
+    while (count > 0)
+    {
+        pWrite(pParam, pPad, (count < padSize) ? count : padSize);
+        count -= padSize;
+    }
+}
+
+// Write a converted field: the prefix (a sign or "0x"), if any, and
+// the length characters at pStr, padded out to width.
+// Returns the number of characters written.
+static int writeField(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam,
+                      const char *pPrefix, const char *pStr, int length,
+                      int width, bool leftJustify, bool zeroPad)
+{
+    int prefixLength = (pPrefix != NULL) ? strlen(pPrefix) : 0;
+    int padding = width - prefixLength - length;
+
+    if (padding < 0)
+    {
+        padding = 0;
+    }
+
+    if (!leftJustify && !zeroPad)
+    {
+        writePadding(pWrite, pParam, gSpaces, sizeof (gSpaces) - 1, padding);
+    }
+    if (prefixLength > 0)
+    {
+        pWrite(pParam, pPrefix, prefixLength);
+    }
+#if COMPACT_PRINTF_WIDTH
+    if (!leftJustify && zeroPad)
+    {
+        writePadding(pWrite, pParam, gZeros, sizeof (gZeros) - 1, padding);
+    }
+#endif
+    if (length > 0)
+    {
+        pWrite(pParam, pStr, length);
+    }
+    if (leftJustify)
+    {
+        writePadding(pWrite, pParam, gSpaces, sizeof (gSpaces) - 1, padding);
+    }
+
+    return prefixLength + length + padding;
+}
+
+// Write to a CompactBuffer_t, dropping what does not fit
+static int writeBuffer(void *pParam, const char *pBuf, int size)
+{
+    CompactBuffer_t *pBuffer = (CompactBuffer_t *) pParam;
+    size_t room = pBuffer->size - pBuffer->length;
+
+    if ((size_t) size < room)
+    {
+        room = size;
+    }
+    // When sizing, compactSnprintf(NULL, 0, ...), there is no buffer
+    // to copy to, not even one of no size
+    if (room > 0)
+    {
+        memcpy(pBuffer->pBuf + pBuffer->length, pBuf, room);
+        pBuffer->length += room;
+    }
+
+    return size;
+}
+
+// Throw output away
+static int writeNothing(void *pParam, const char *pBuf, int size)
+{
+    (void) pParam;
+    (void) pBuf;
+
+    return size;
+}
+
+// The formats the benchmark times, taken from what this application
+// prints
+static int formatHex(CompactFormatter_t pFormatter, char *pBuf, size_t size)
+{
+    return pFormatter(pBuf, size, "CPUID: 0x%08lx (%s%s r%dp%d, ARMv%d-M%s).\n", (unsigned long) 0x410fc241,
+                      "ARM ", "Cortex-M4", 0, 1, 7, ", unaligned access allowed");
+}
+
+static int formatDecimal(CompactFormatter_t pFormatter, char *pBuf, size_t size)
+{
+    return pFormatter(pBuf, size, "    %5lu us: %7lu tick(s) of %7lu expected, %3lu%% CPU%s.\n",
+                      (unsigned long) 50, (unsigned long) 19998, (unsigned long) 20000,
+                      (unsigned long) 37, ", UNRELIABLE");
+}
+
+static int formatSigned(CompactFormatter_t pFormatter, char *pBuf, size_t size)
+{
+    return pFormatter(pBuf, size, "    %-18s %6ld to %6ld us: %-6s %d.\n", "Tick period error",
+                      (long) -100, (long) 1606, "count", -12345);
+}
+
+// Make a benchmark call, for stackPaintMeasureCall()
+static void callBenchmark(void *pParam)
+{
+    CompactBenchmarkCall_t *pCall = (CompactBenchmarkCall_t *) pParam;
+
+    pCall->pCase->pFormat(pCall->pFormatter, pCall->pBuf, COMPACT_PRINTF_BENCHMARK_BUFFER_BYTES);
+}
+
+// Time and measure the stack of one formatter on one format, printing
+// the results
+static void benchmarkFormatter(const CompactBenchmarkCase_t *pCase, const char *pName,
+                               CompactFormatter_t pFormatter, char *pBuf)
+{
+    CompactBenchmarkCall_t call = {pCase, pFormatter, pBuf};
+    uint32_t startCounts;
+    uint32_t counts;
+    size_t stackBytes;
+
+    startCounts = cycleCounterRead();
+    for (uint32_t x = 0; x < COMPACT_PRINTF_BENCHMARK_ITERATIONS; x++)
+    {
+        pCase->pFormat(pFormatter, pBuf, COMPACT_PRINTF_BENCHMARK_BUFFER_BYTES);
+    }
+    counts = cycleCounterRead() - startCounts;
+
+    stackBytes = stackPaintMeasureCall(callBenchmark, &call, COMPACT_PRINTF_BENCHMARK_STACK_BYTES);
+
+    printf("    %-8s %-18s %10" PRIu32 " %s per call, %s%d byte(s) of stack.\n", pCase->pName, pName,
+           counts / COMPACT_PRINTF_BENCHMARK_ITERATIONS, cycleCounterUnits(),
+           (stackBytes >= COMPACT_PRINTF_BENCHMARK_STACK_BYTES) ? "at least " : "", (int) stackBytes);
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Format to a write function
+int compactVformat(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam,
+                   const char *pFormat, va_list args)
+{
+    char digits[sizeof (CompactUint_t) * 3];
+    const char *pSpec;
+    const char *pStr;
+    const char *pPrefix;
+    const char *p;
+    int length;
+    int width;
+    bool leftJustify;
+    bool zeroPad;
+    uint32_t numLongs;
+    char conversion;
+    int count = 0;
+    va_list ap;
+
+    // A copy, so that it can be passed on by pointer whatever va_list is
+    va_copy(ap, args);
+
+    while (*pFormat != 0)
+    {
+        // Write the run of literal characters up to the next conversion
+        for (p = pFormat; (*p != 0) && (*p != '%'); p++)
+        {
+        }
+        if (p > pFormat)
+        {
+            pWrite(pParam, pFormat, p - pFormat);
+            count += p - pFormat;
+            pFormat = p;
+        }
+        if (*pFormat == 0)
+        {
+            break;
+        }
+
+        pSpec = pFormat++;
+        leftJustify = false;
+        zeroPad = false;
+        width = 0;
+        // The flags and the width are parsed even if they have been
+        // left out, so that they are skipped
+        for (;; pFormat++)
+        {
+            if (*pFormat == '-')
+            {
+                leftJustify = true;
+            }
+            else if (*pFormat == '0')
+            {
+                zeroPad = true;
+            }
+            else
+            {
+                break;
+            }
+        }
+        while ((*pFormat >= '0') && (*pFormat <= '9'))
+        {
+            width = (width * 10) + (*pFormat - '0');
+            pFormat++;
+        }
+#if !COMPACT_PRINTF_WIDTH
+        leftJustify = false;
+        zeroPad = false;
+        width = 0;
+#endif
+        for (numLongs = 0; *pFormat == 'l'; pFormat++)
+        {
+            numLongs++;
+        }
+
+        // Without 'll' a conversion that has it is treated as left out
+        conversion = *pFormat;
+#if !COMPACT_PRINTF_LONG_LONG
+        if (numLongs > 1)
+        {
+            conversion = 0;
+        }
+#endif
+
+        pPrefix = NULL;
+        pStr = digits + sizeof (digits);
+        switch (conversion)
+        {
+            case '%':
+                pStr = pFormat;
+                length = 1;
+                width = 0;
+                break;
+#if COMPACT_PRINTF_SIGNED
+            case 'd':
+            case 'i':
+            {
+                bool negative;
+                CompactUint_t value = getSigned(&ap, numLongs, &negative);
+                pStr = formatUnsigned(digits + sizeof (digits), value, false, false);
+                length = digits + sizeof (digits) - pStr;
+                if (negative)
+                {
+                    pPrefix = "-";
+                }
+            }
+            break;
+#endif
+            case 'u':
+                pStr = formatUnsigned(digits + sizeof (digits), getUnsigned(&ap, numLongs), false, false);
+                length = digits + sizeof (digits) - pStr;
+                break;
+#if COMPACT_PRINTF_HEX
+            case 'x':
+            case 'X':
+                pStr = formatUnsigned(digits + sizeof (digits), getUnsigned(&ap, numLongs), true, *pFormat == 'X');
+                length = digits + sizeof (digits) - pStr;
+                break;
+            case 'p':
+                pStr = formatUnsigned(digits + sizeof (digits), (uintptr_t) va_arg(ap, void *), true, false);
+                length = digits + sizeof (digits) - pStr;
+                pPrefix = "0x";
+                break;
+#endif
+#if COMPACT_PRINTF_STRING
+            case 'c':
+                digits[0] = (char) va_arg(ap, int);
+                pStr = digits;
+                length = 1;
+                break;
+            case 's':
+                pStr = va_arg(ap, const char *);
+                if (pStr == NULL)
+                {
+                    pStr = "(null)";
+                }
+                length = strlen(pStr);
+                zeroPad = false;
+                break;
+#endif
+            default:
+                // Not known, or left out: print it as it stands, having
+                // skipped the argument of one that has been left out
+                skipArgument(&ap, *pFormat, numLongs);
+                pStr = pSpec;
+                length = pFormat - pSpec + ((*pFormat != 0) ? 1 : 0);
+                width = 0;
+                break;
+        }
+        if (*pFormat != 0)
+        {
+            pFormat++;
+        }
+
+        count += writeField(pWrite, pParam, pPrefix, pStr, length, width, leftJustify, zeroPad);
+    }
+
+    va_end(ap);
+
+    return count;
+}
+
+// Format to a buffer
+int compactVsnprintf(char *pBuf, size_t size, const char *pFormat, va_list args)
+{
+    CompactBuffer_t buffer;
+    int count;
+
+    buffer.pBuf = pBuf;
+    buffer.size = (size > 0) ? size - 1 : 0;
+    buffer.length = 0;
+    count = compactVformat(writeBuffer, &buffer, pFormat, args);
+    if (size > 0)
+    {
+        pBuf[buffer.length] = 0;
+    }
+
+    return count;
+}
+
+int compactSnprintf(char *pBuf, size_t size, const char *pFormat, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, pFormat);
+    count = compactVsnprintf(pBuf, size, pFormat, args);
+    va_end(args);
+
+    return count;
+}
+
+// Set where compactPrintf() writes to
+void compactPrintfSetOutput(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam)
+{
+    gpWriteParam = pParam;
+    gpWrite = pWrite;
+}
+
+// Format to the output
+int compactPrintf(const char *pFormat, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, pFormat);
+    count = compactVformat((gpWrite != NULL) ? gpWrite : writeNothing, gpWriteParam, pFormat, args);
+    va_end(args);
+
+    return count;
+}
+
+// Benchmark against the C library
+void compactPrintfBenchmark()
+{
+    const CompactBenchmarkCase_t cases[] = {{"hex", formatHex},
+                                            {"decimal", formatDecimal},
+                                            {"signed", formatSigned}};
+
+    cycleCounterInit();
+
+    printf("*** Benchmarking compactSnprintf() against the C library's snprintf(), %d call(s) of each.\n",
+           COMPACT_PRINTF_BENCHMARK_ITERATIONS);
+    for (uint32_t x = 0; x < sizeof (cases) / sizeof (cases[0]); x++)
+    {
+        benchmarkFormatter(&(cases[x]), "snprintf()", snprintf, gBenchmarkBuffers[0]);
+        benchmarkFormatter(&(cases[x]), "compactSnprintf()", compactSnprintf, gBenchmarkBuffers[1]);
+        if (strcmp(gBenchmarkBuffers[0], gBenchmarkBuffers[1]) != 0)
+        {
+            printf("!!! compactSnprintf() differs from snprintf() on the %s format.\n", cases[x].pName);
+        }
+    }
+}
+
+#if defined(COMPACT_PRINTF) && !defined(MBED_HOST_BUILD)
+
+// Replace the C library's printf() and the functions the compiler
+// turns simple printf()s into
+#undef putchar
+
+extern "C" int vprintf(const char *pFormat, va_list args)
+{
+    return compactVformat((gpWrite != NULL) ? gpWrite : writeNothing, gpWriteParam, pFormat, args);
+}
+
+extern "C" int printf(const char *pFormat, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, pFormat);
+    count = vprintf(pFormat, args);
+    va_end(args);
+
+    return count;
+}
+
+extern "C" int puts(const char *pStr)
+{
+    int length = strlen(pStr);
+
+    ((gpWrite != NULL) ? gpWrite : writeNothing)(gpWriteParam, pStr, length);
+    ((gpWrite != NULL) ? gpWrite : writeNothing)(gpWriteParam, "\n", 1);
+
+    return length + 1;
+}
+
+extern "C" int putchar(int c)
+{
+    char x = (char) c;
+
+    ((gpWrite != NULL) ? gpWrite : writeNothing)(gpWriteParam, &x, 1);
+
+    return (unsigned char) x;
+}
+
+#endif // COMPACT_PRINTF && !MBED_HOST_BUILD
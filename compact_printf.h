@@ -0,0 +1,106 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _COMPACT_PRINTF_H_
+#define _COMPACT_PRINTF_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A small formatter for the conversions this application uses:
+// %d, %i, %u, %x, %X, %p, %c, %s and %%, with the '-' and '0' flags,
+// a field width and the 'l' (and optionally 'll') length modifier.
+// It uses no heap and a bounded amount of stack, and hands its output
+// to a write function in runs rather than a character at a time.  A
+// conversion that has been left out by the options below is printed as
+// it stands and its argument skipped, as are flags and a width that
+// have been left out; one it does not know at all is printed as it
+// stands too, but the arguments after it are then out of step.
+//
+// Define COMPACT_PRINTF to have it replace the toolchain's printf(),
+// vprintf(), puts() and putchar() on the target (GCC_ARM), writing
+// to whatever is given to compactPrintfSetOutput(), so that the C
+// library's formatter need not be linked; the host build keeps the
+// C library's.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Set any of these to 0 to leave out code that is not needed
+// The '-' and '0' flags and the field width
+#ifndef COMPACT_PRINTF_WIDTH
+# define COMPACT_PRINTF_WIDTH 1
+#endif
+// %d and %i
+#ifndef COMPACT_PRINTF_SIGNED
+# define COMPACT_PRINTF_SIGNED 1
+#endif
+// %x, %X and %p
+#ifndef COMPACT_PRINTF_HEX
+# define COMPACT_PRINTF_HEX 1
+#endif
+// %s and %c
+#ifndef COMPACT_PRINTF_STRING
+# define COMPACT_PRINTF_STRING 1
+#endif
+
+// Set this to 1 for the 'll' length modifier, which brings in 64-bit
+// division
+#ifndef COMPACT_PRINTF_LONG_LONG
+# define COMPACT_PRINTF_LONG_LONG 0
+#endif
+
+// Set this to 1 to convert decimals two digits at a time through a
+// 200-byte table, which halves the number of divisions (library calls
+// on a Cortex-M0) at the cost of the table; 0 favours size
+#ifndef COMPACT_PRINTF_SPEED
+# define COMPACT_PRINTF_SPEED 0
+#endif
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Format pFormat with args, passing the output to pWrite, which should
+// return the number of bytes written, blocking as necessary.
+// Returns the number of characters formatted.
+int compactVformat(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam,
+                   const char *pFormat, va_list args);
+
+// As snprintf(): write at most size bytes, including the terminator,
+// to pBuf.
+// Returns the number of characters that would have been written had
+// size been large enough, not counting the terminator.
+int compactSnprintf(char *pBuf, size_t size, const char *pFormat, ...);
+int compactVsnprintf(char *pBuf, size_t size, const char *pFormat, va_list args);
+
+// Set where compactPrintf() writes to, e.g. a serial port; until this
+// is called the output is thrown away.
+void compactPrintfSetOutput(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam);
+
+// As printf(), writing to the output set by compactPrintfSetOutput().
+// Returns the number of characters written.
+int compactPrintf(const char *pFormat, ...);
+
+// Time compactSnprintf() against the C library's snprintf() on the
+// formats this application prints, in cycles per call, and measure the
+// stack each uses, printing the results.
+void compactPrintfBenchmark(void);
+
+#endif // _COMPACT_PRINTF_H_
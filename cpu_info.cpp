@@ -0,0 +1,115 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "cpu_info.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The fields of CPUID
+#define CPUID_IMPLEMENTER(cpuid) (((cpuid) >> 24) & 0xff)
+#define CPUID_VARIANT(cpuid) (((cpuid) >> 20) & 0x0f)
+#define CPUID_ARCHITECTURE(cpuid) (((cpuid) >> 16) & 0x0f)
+#define CPUID_PART_NUMBER(cpuid) (((cpuid) >> 4) & 0xfff)
+#define CPUID_REVISION(cpuid) ((cpuid) & 0x0f)
+
+// The unaligned access trap bit of CCR
+#define CCR_UNALIGN_TRP (1 << 3)
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A known ARM part number
+typedef struct
+{
+    uint16_t partNumber;
+    CpuCore_t core;
+} CpuPart_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The part numbers of the ARM Cortex-M cores
+static const CpuPart_t gParts[] = {{0xc20, CPU_CORE_M0},
+                                   {0xc60, CPU_CORE_M0_PLUS},
+                                   {0xc21, CPU_CORE_M1},
+                                   {0xc23, CPU_CORE_M3},
+                                   {0xc24, CPU_CORE_M4},
+                                   {0xc27, CPU_CORE_M7}};
+
+// The names of the cores, indexed by CpuCore_t
+static const char * gCoreNames[] = {"unknown core", "Cortex-M0", "Cortex-M0+", "Cortex-M1",
+                                    "Cortex-M3", "Cortex-M4", "Cortex-M7"};
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Read and decode CPUID and CCR
+void cpuInfoGet(CpuInfo_t *pInfo)
+{
+    uint32_t cpuid = *(SYSTEM_CONTROL_BLOCK_START_ADDRESS);
+    uint32_t ccr;
+
+    if (pInfo != NULL)
+    {
+        memset(pInfo, 0, sizeof (*pInfo));
+        pInfo->cpuid = cpuid;
+        pInfo->implementer = CPUID_IMPLEMENTER(cpuid);
+        pInfo->variant = CPUID_VARIANT(cpuid);
+        pInfo->architecture = CPUID_ARCHITECTURE(cpuid);
+        pInfo->partNumber = CPUID_PART_NUMBER(cpuid);
+        pInfo->revision = CPUID_REVISION(cpuid);
+
+        if (pInfo->implementer == CPU_INFO_IMPLEMENTER_ARM)
+        {
+            for (uint32_t x = 0; x < sizeof (gParts) / sizeof (gParts[0]); x++)
+            {
+                if (gParts[x].partNumber == pInfo->partNumber)
+                {
+                    pInfo->core = gParts[x].core;
+                }
+            }
+        }
+
+        // Go by the architecture rather than the core, so that a
+        // licensee's ARMv7-M core counts too
+        pInfo->armv7m = (pInfo->architecture == CPU_INFO_ARCHITECTURE_ARMV7M);
+        if (pInfo->armv7m)
+        {
+            ccr = *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 5);
+            pInfo->unalignedAccess = ((ccr & CCR_UNALIGN_TRP) == 0);
+        }
+    }
+}
+
+// Return the name of a core
+const char * cpuInfoCoreName(CpuCore_t core)
+{
+    const char * pName = gCoreNames[CPU_CORE_UNKNOWN];
+
+    if ((core >= 0) && (core < (int) (sizeof (gCoreNames) / sizeof (gCoreNames[0]))))
+    {
+        pName = gCoreNames[core];
+    }
+
+    return pName;
+}
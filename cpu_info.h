@@ -0,0 +1,82 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CPU_INFO_H_
+#define _CPU_INFO_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The start of the System Control Block, where CPUID is the first
+// word and CCR the sixth
+#ifndef SYSTEM_CONTROL_BLOCK_START_ADDRESS
+# define SYSTEM_CONTROL_BLOCK_START_ADDRESS ((uint32_t *) 0xe000ed00)
+#endif
+
+// The ARM implementer code in CPUID
+#define CPU_INFO_IMPLEMENTER_ARM 0x41
+
+// The architecture field of CPUID for ARMv6-M and ARMv7-M
+#define CPU_INFO_ARCHITECTURE_ARMV6M 0x0c
+#define CPU_INFO_ARCHITECTURE_ARMV7M 0x0f
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The cores that can be told apart by their part number
+typedef enum
+{
+    CPU_CORE_UNKNOWN,
+    CPU_CORE_M0,
+    CPU_CORE_M0_PLUS,
+    CPU_CORE_M1,
+    CPU_CORE_M3,
+    CPU_CORE_M4,
+    CPU_CORE_M7,
+    MAX_NUM_CPU_CORES
+} CpuCore_t;
+
+// What CPUID and CCR say about the core
+typedef struct
+{
+    uint32_t cpuid;
+    uint8_t implementer;       // CPU_INFO_IMPLEMENTER_ARM for ARM
+    uint8_t variant;           // The major revision, the "n" of rnpn
+    uint8_t architecture;
+    uint16_t partNumber;
+    uint8_t revision;          // The minor revision, the "n" of pn
+    CpuCore_t core;
+    bool armv7m;               // The ARMv7-M instructions are there
+    bool unalignedAccess;      // Unaligned word loads and stores work:
+                               // ARMv7-M with CCR.UNALIGN_TRP clear
+} CpuInfo_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Read and decode CPUID and CCR.
+void cpuInfoGet(CpuInfo_t *pInfo);
+
+// Return the name of a core, e.g. "Cortex-M0+".
+const char * cpuInfoCoreName(CpuCore_t core);
+
+#endif // _CPU_INFO_H_
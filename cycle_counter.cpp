@@ -0,0 +1,255 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "cycle_counter.h"
+#ifdef __MBED_CMSIS_RTOS_CM
+#include "cmsis_os.h"
+#endif
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Whether this core may have a DWT cycle counter
+#if defined(__CORTEX_M) && (__CORTEX_M >= 3) && !defined(MBED_HOST_BUILD)
+# define CYCLE_COUNTER_HAS_DWT 1
+#else
+# define CYCLE_COUNTER_HAS_DWT 0
+#endif
+
+// Whether the RTOS can tell the time in SysTick counts
+#if defined(osFeature_SysTick) && (osFeature_SysTick != 0) && !defined(MBED_HOST_BUILD)
+# define CYCLE_COUNTER_HAS_RTOS_SYSTICK 1
+#else
+# define CYCLE_COUNTER_HAS_RTOS_SYSTICK 0
+#endif
+
+// The reload value of SysTick when cycleCounterMeasureCoreHz() has it
+// to itself, so that it counts through all 2^24 values
+#define CYCLE_COUNTER_SYSTICK_MASK 0x00ffffff
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+#if !defined(MBED_HOST_BUILD)
+// Whether the DWT cycle counter is running
+static bool gDwt = false;
+
+// The last SysTick value read by readSysTick() and the counts so far
+static uint32_t gSysTickLast = 0;
+static uint32_t gSysTickCounts = 0;
+#endif
+
+// The core clock set by cycleCounterSetCoreHz(), 0 if none
+static uint32_t gCoreHz = 0;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+#if CYCLE_COUNTER_HAS_DWT
+// Read the DWT cycle counter.
+static uint32_t readDwt()
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+#if !defined(MBED_HOST_BUILD)
+// Read SysTick, running from the core clock with a reload of
+// CYCLE_COUNTER_SYSTICK_MASK, as an up-counter; this has to be
+// called at least once every 2^24 cycles to keep count.
+static uint32_t readSysTick()
+{
+    uint32_t value = SysTick->VAL;
+
+    gSysTickCounts += (gSysTickLast - value) & CYCLE_COUNTER_SYSTICK_MASK;
+    gSysTickLast = value;
+
+    return gSysTickCounts;
+}
+#endif
+
+// Count with pRead across at least intervalUs of the us_ticker,
+// starting and stopping on a tick, and return the counts per second.
+static uint32_t measure(uint32_t (*pRead)(void), uint32_t intervalUs)
+{
+    uint32_t startUs = us_ticker_read();
+    uint32_t nowUs;
+    uint32_t startCounts;
+    uint32_t counts;
+
+    do
+    {
+        nowUs = us_ticker_read();
+        startCounts = pRead();
+    } while (nowUs == startUs);
+    startUs = nowUs;
+
+    do
+    {
+        nowUs = us_ticker_read();
+        counts = pRead() - startCounts;
+    } while (nowUs - startUs < intervalUs);
+
+    return (uint32_t) (((uint64_t) counts * 1000000) / (nowUs - startUs));
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Start the counter
+void cycleCounterInit()
+{
+#if CYCLE_COUNTER_HAS_DWT
+    // Trace has to be enabled for the DWT to run; some cores are
+    // built without the cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    if ((DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) == 0)
+    {
+        if (!gDwt)
+        {
+            DWT->CYCCNT = 0;
+        }
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        gDwt = true;
+    }
+#endif
+}
+
+// Read the counter
+uint32_t cycleCounterRead()
+{
+#if defined(MBED_HOST_BUILD)
+    return hostCycleCount();
+#else
+# if CYCLE_COUNTER_HAS_DWT
+    if (gDwt)
+    {
+        return DWT->CYCCNT;
+    }
+# endif
+    return us_ticker_read();
+#endif
+}
+
+// The counts in a microsecond
+uint32_t cycleCounterPerUs()
+{
+    uint32_t countsPerUs = (cycleCounterCoreHz() + 500000) / 1000000;
+
+#if !defined(MBED_HOST_BUILD)
+    if (!gDwt)
+    {
+        countsPerUs = 1;
+    }
+#endif
+
+    return (countsPerUs > 0) ? countsPerUs : 1;
+}
+
+// Convert counts to nanoseconds
+uint32_t cycleCounterToNs(uint32_t counts)
+{
+    return (uint32_t) (((uint64_t) counts * 1000) / cycleCounterPerUs());
+}
+
+// What is being counted
+const char * cycleCounterUnits()
+{
+#if defined(MBED_HOST_BUILD)
+    return "nsecond(s)";
+#else
+    return gDwt ? "cycle(s)" : "usecond(s)";
+#endif
+}
+
+// Measure the core clock
+uint32_t cycleCounterMeasureCoreHz(uint32_t intervalUs, const char **ppMethod)
+{
+    uint32_t coreHz = 0;
+    const char *pMethod = "nothing";
+
+    if (intervalUs == 0)
+    {
+        intervalUs = 1;
+    }
+
+#if defined(MBED_HOST_BUILD)
+    coreHz = measure(hostCycleCount, intervalUs);
+    pMethod = "the host clock";
+#else
+    uint32_t ctrl = SysTick->CTRL;
+    uint32_t load = SysTick->LOAD;
+
+    cycleCounterInit();
+# if CYCLE_COUNTER_HAS_DWT
+    if (gDwt)
+    {
+        coreHz = measure(readDwt, intervalUs);
+        pMethod = "the DWT cycle counter";
+    }
+# endif
+    if ((coreHz == 0) && ((ctrl & SysTick_CTRL_ENABLE_Msk) == 0))
+    {
+        // SysTick is free: run it from the core clock, without its
+        // interrupt, then put it back as it was
+        SysTick->LOAD = CYCLE_COUNTER_SYSTICK_MASK;
+        SysTick->VAL = 0;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+        gSysTickLast = SysTick->VAL;
+        gSysTickCounts = 0;
+        coreHz = measure(readSysTick, intervalUs);
+        SysTick->CTRL = ctrl;
+        SysTick->LOAD = load;
+        SysTick->VAL = 0;
+        pMethod = "SysTick";
+    }
+# if CYCLE_COUNTER_HAS_RTOS_SYSTICK
+    if ((coreHz == 0) && ((ctrl & SysTick_CTRL_ENABLE_Msk) != 0) &&
+        ((ctrl & SysTick_CTRL_CLKSOURCE_Msk) != 0))
+    {
+        // The RTOS has SysTick, running from the core clock, and
+        // keeps count across its reloads whatever else is running
+        coreHz = measure(osKernelSysTick, intervalUs);
+        pMethod = "the RTOS's SysTick";
+    }
+# endif
+#endif
+
+    if (ppMethod != NULL)
+    {
+        *ppMethod = pMethod;
+    }
+
+    return coreHz;
+}
+
+// Set the core clock that counts are converted with
+void cycleCounterSetCoreHz(uint32_t coreHz)
+{
+    gCoreHz = coreHz;
+}
+
+// The core clock that counts are converted with
+uint32_t cycleCounterCoreHz()
+{
+    return (gCoreHz != 0) ? gCoreHz : SystemCoreClock;
+}
@@ -0,0 +1,66 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CYCLE_COUNTER_H_
+#define _CYCLE_COUNTER_H_
+
+#include <stdint.h>
+
+// A free-running counter for timing short stretches of code: the DWT
+// cycle counter on Cortex-M3 and above (where the core has one), else
+// the us_ticker, which is all a Cortex-M0 has.  In the host build it
+// counts nanoseconds.  It wraps, so time with differences of
+// uint32_t values.  Counts are converted to time with the core
+// clock, which is SystemCoreClock unless a measured one has been set
+// with cycleCounterSetCoreHz().
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Start the counter; calling this again does no harm.
+void cycleCounterInit(void);
+
+// Read the counter.
+uint32_t cycleCounterRead(void);
+
+// The number of counts in a microsecond.
+uint32_t cycleCounterPerUs(void);
+
+// Convert a number of counts into nanoseconds.
+uint32_t cycleCounterToNs(uint32_t counts);
+
+// What is being counted, e.g. "cycle(s)".
+const char * cycleCounterUnits(void);
+
+// Measure the core clock by counting its cycles, with the DWT cycle
+// counter or else SysTick, across intervalUs of the us_ticker; the
+// answer is only as good as the us_ticker, which must not itself run
+// from a mis-set PLL.  Returns the frequency in Hz, or 0 if the core
+// has no way of counting its cycles (SysTick taken by the RTOS but
+// running from a reference clock).  If ppMethod is not NULL it is set
+// to the name of what was counted.
+uint32_t cycleCounterMeasureCoreHz(uint32_t intervalUs, const char **ppMethod);
+
+// Convert counts to time with coreHz, e.g. as measured by
+// cycleCounterMeasureCoreHz(), rather than with SystemCoreClock.
+void cycleCounterSetCoreHz(uint32_t coreHz);
+
+// The core clock that counts are converted with.
+uint32_t cycleCounterCoreHz(void);
+
+#endif // _CYCLE_COUNTER_H_
@@ -0,0 +1,230 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "deferred_log.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+
+#ifdef DEFERRED_LOGGING
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The longest run of literal text printed in one go
+#define DEFERRED_LOG_TEXT_CHARS 32
+
+// The longest conversion: '%', flags, width, precision, length and
+// the conversion character
+#define DEFERRED_LOG_CONVERSION_CHARS 16
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Fails to compile if DEFERRED_LOG_BUFFER_WORDS is not a power of two
+typedef char DeferredLogBufferWordsMustBeAPowerOfTwo[((DEFERRED_LOG_BUFFER_WORDS & (DEFERRED_LOG_BUFFER_WORDS - 1)) == 0) ? 1 : -1];
+
+// The ring buffer: each message is the number of arguments, the
+// format string and then the arguments
+static uintptr_t gBuffer[DEFERRED_LOG_BUFFER_WORDS];
+
+// The number of words written and read since start-up, which also
+// give the next slots to write and read
+static volatile uint32_t gNumWritten = 0;
+static volatile uint32_t gNumRead = 0;
+
+// The number of messages lost for want of room since the last drain
+static volatile uint32_t gNumLost = 0;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Print a stored message a piece at a time: runs of literal text, and
+// each conversion on its own with its argument passed as the type the
+// conversion expects, since the arguments are stored as uintptr_t,
+// which on a 64-bit host is wider than the int that %d expects.
+static void printMessage(const char *pFormat, const uintptr_t *pArgs, uint32_t numArgs)
+{
+    char text[DEFERRED_LOG_TEXT_CHARS + 1];
+    char conversion[DEFERRED_LOG_CONVERSION_CHARS + 1];
+    size_t textLength = 0;
+    size_t length;
+    uint32_t argIndex = 0;
+    uintptr_t arg;
+    bool isLong;
+
+    while (*pFormat != '\0')
+    {
+        if ((*pFormat != '%') || (*(pFormat + 1) == '%'))
+        {
+            // Literal text, "%%" being a '%'
+            text[textLength++] = *pFormat;
+            pFormat += (*pFormat == '%') ? 2 : 1;
+        }
+        else
+        {
+            // A conversion, copied up to and including its conversion
+            // character
+            length = 0;
+            isLong = false;
+            conversion[length++] = *pFormat++;
+            while ((*pFormat != '\0') && (strchr("-+ #0123456789.hl", *pFormat) != NULL) &&
+                   (length < DEFERRED_LOG_CONVERSION_CHARS - 1))
+            {
+                isLong = isLong || (*pFormat == 'l');
+                conversion[length++] = *pFormat++;
+            }
+            if (*pFormat != '\0')
+            {
+                conversion[length++] = *pFormat++;
+            }
+            conversion[length] = '\0';
+            arg = (argIndex < numArgs) ? pArgs[argIndex++] : 0;
+
+            if (textLength > 0)
+            {
+                text[textLength] = '\0';
+                printf("%s", text);
+                textLength = 0;
+            }
+            switch (conversion[length - 1])
+            {
+                case 'd':
+                case 'i':
+                case 'c':
+                    if (isLong)
+                    {
+                        printf(conversion, (long) arg);
+                    }
+                    else
+                    {
+                        printf(conversion, (int) arg);
+                    }
+                    break;
+                case 's':
+                    printf(conversion, (const char *) arg);
+                    break;
+                case 'p':
+                    printf(conversion, (void *) arg);
+                    break;
+                default:
+                    if (isLong)
+                    {
+                        printf(conversion, (unsigned long) arg);
+                    }
+                    else
+                    {
+                        printf(conversion, (unsigned int) arg);
+                    }
+                    break;
+            }
+        }
+
+        if ((textLength == DEFERRED_LOG_TEXT_CHARS) || ((*pFormat == '\0') && (textLength > 0)))
+        {
+            text[textLength] = '\0';
+            printf("%s", text);
+            textLength = 0;
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Store a message
+void deferredLogRecord(uint32_t numArgs, const char *pFormat, ...)
+{
+    va_list args;
+    uint32_t index;
+    uint32_t primask = __get_PRIMASK();
+
+    if (numArgs > DEFERRED_LOG_MAX_ARGS)
+    {
+        numArgs = DEFERRED_LOG_MAX_ARGS;
+    }
+
+    __disable_irq();
+    if (DEFERRED_LOG_BUFFER_WORDS - (gNumWritten - gNumRead) < numArgs + 2)
+    {
+        gNumLost++;
+    }
+    else
+    {
+        index = gNumWritten;
+        gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)] = numArgs;
+        gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)] = (uintptr_t) pFormat;
+        va_start(args, pFormat);
+        for (uint32_t x = 0; x < numArgs; x++)
+        {
+            gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)] = va_arg(args, uintptr_t);
+        }
+        va_end(args);
+        gNumWritten = index;
+    }
+    __set_PRIMASK(primask);
+}
+
+// Print the stored messages
+uint32_t deferredLogDrain()
+{
+    uintptr_t args[DEFERRED_LOG_MAX_ARGS];
+    const char *pFormat;
+    uint32_t numArgs;
+    uint32_t index;
+    uint32_t numLost;
+    uint32_t numMessages = 0;
+    uint32_t primask;
+
+    while (gNumRead != gNumWritten)
+    {
+        // Only this function moves gNumRead and the message is complete
+        // once gNumWritten has moved past it, so it can be copied out
+        // without masking interrupts
+        index = gNumRead;
+        numArgs = gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)];
+        pFormat = (const char *) gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)];
+        for (uint32_t x = 0; x < numArgs; x++)
+        {
+            args[x] = gBuffer[index++ & (DEFERRED_LOG_BUFFER_WORDS - 1)];
+        }
+        gNumRead = index;
+
+        printMessage(pFormat, args, numArgs);
+        numMessages++;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    numLost = gNumLost;
+    gNumLost = 0;
+    __set_PRIMASK(primask);
+
+    if (numLost > 0)
+    {
+        printf("!!! %" PRIu32 " log message(s) lost.\n", numLost);
+    }
+
+    return numMessages;
+}
+
+#endif // DEFERRED_LOGGING
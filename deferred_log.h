@@ -0,0 +1,145 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _DEFERRED_LOG_H_
+#define _DEFERRED_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Define DEFERRED_LOGGING to have DEFERRED_LOG() store a pointer to
+// its format string and its raw arguments in a ring buffer rather than
+// call printf(), which at 9600 baud blocks for milliseconds a line.
+// Storing takes a few dozen cycles with interrupts masked; the
+// formatting and the UART time are paid later, by DEFERRED_LOG_FLUSH()
+// from wherever nothing is being timed, e.g. the idle branch of the
+// echo loop.  Without DEFERRED_LOGGING, DEFERRED_LOG() is printf() and
+// DEFERRED_LOG_FLUSH() does nothing, so the output is the same either
+// way provided the buffer is flushed before anything else prints.
+//
+// Since formatting happens later, the arguments must be integers or
+// pointers no wider than a pointer (no double or 64-bit values) and
+// any %s string must still be there when the buffer is flushed, which
+// in practice means a string constant.  Each argument is stored as a
+// uintptr_t and handed back to printf() as the type its conversion
+// expects (int, long, their unsigned forms or a pointer); the
+// conversions understood are those of compact_printf.h, with no '*'
+// width or precision.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the ring buffer in words, which must be a power of two;
+// a message takes two words plus one for each argument
+#ifndef DEFERRED_LOG_BUFFER_WORDS
+# define DEFERRED_LOG_BUFFER_WORDS 256
+#endif
+
+// The most arguments a message may have after its format string
+#define DEFERRED_LOG_MAX_ARGS 8
+
+// Log a message, with the arguments of printf(), and print what has
+// been logged so far; more than DEFERRED_LOG_MAX_ARGS arguments fails
+// to compile, since there is no deferredLog() that takes them
+#ifdef DEFERRED_LOGGING
+# define DEFERRED_LOG(...) deferredLog(__VA_ARGS__)
+# define DEFERRED_LOG_FLUSH() deferredLogDrain()
+#else
+# define DEFERRED_LOG(...) printf(__VA_ARGS__)
+# define DEFERRED_LOG_FLUSH()
+#endif
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Store a message with numArgs arguments after pFormat, each of which
+// must be a uintptr_t, called through DEFERRED_LOG(); if there is no
+// room the message is counted as lost.
+// May be called from interrupt handlers.
+void deferredLogRecord(uint32_t numArgs, const char *pFormat, ...);
+
+// Store a message with up to DEFERRED_LOG_MAX_ARGS arguments, each
+// converted to the uintptr_t that deferredLogRecord() reads.
+inline void deferredLog(const char *pFormat)
+{
+    deferredLogRecord(0, pFormat);
+}
+
+template <typename A1>
+inline void deferredLog(const char *pFormat, A1 a1)
+{
+    deferredLogRecord(1, pFormat, (uintptr_t) a1);
+}
+
+template <typename A1, typename A2>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2)
+{
+    deferredLogRecord(2, pFormat, (uintptr_t) a1, (uintptr_t) a2);
+}
+
+template <typename A1, typename A2, typename A3>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3)
+{
+    deferredLogRecord(3, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3);
+}
+
+template <typename A1, typename A2, typename A3, typename A4>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3, A4 a4)
+{
+    deferredLogRecord(4, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3, (uintptr_t) a4);
+}
+
+template <typename A1, typename A2, typename A3, typename A4, typename A5>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+{
+    deferredLogRecord(5, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3, (uintptr_t) a4,
+                      (uintptr_t) a5);
+}
+
+template <typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+{
+    deferredLogRecord(6, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3, (uintptr_t) a4,
+                      (uintptr_t) a5, (uintptr_t) a6);
+}
+
+template <typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7)
+{
+    deferredLogRecord(7, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3, (uintptr_t) a4,
+                      (uintptr_t) a5, (uintptr_t) a6, (uintptr_t) a7);
+}
+
+template <typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+inline void deferredLog(const char *pFormat, A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, A8 a8)
+{
+    deferredLogRecord(8, pFormat, (uintptr_t) a1, (uintptr_t) a2, (uintptr_t) a3, (uintptr_t) a4,
+                      (uintptr_t) a5, (uintptr_t) a6, (uintptr_t) a7, (uintptr_t) a8);
+}
+
+// Fails to compile if DEFERRED_LOG_MAX_ARGS no longer matches the
+// deferredLog() overloads above
+typedef char DeferredLogMaxArgsMustMatchTheOverloads[(DEFERRED_LOG_MAX_ARGS == 8) ? 1 : -1];
+
+// Format and print the stored messages, oldest first, followed by a
+// count of any that were lost; call from thread context only.
+// Returns the number of messages printed.
+uint32_t deferredLogDrain(void);
+
+#endif // _DEFERRED_LOG_H_
@@ -0,0 +1,78 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "event_trace.h"
+#include "cycle_counter.h"
+#include "trace_ring.h"
+
+#ifdef EVENT_TRACE
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Fails to compile if EVENT_TRACE_NUM_RECORDS is not a power of two
+typedef char EventTraceNumRecordsMustBeAPowerOfTwo[((EVENT_TRACE_NUM_RECORDS & (EVENT_TRACE_NUM_RECORDS - 1)) == 0) ? 1 : -1];
+
+// The names of the events, indexed by EventTraceId_t
+static const char * gNames[] = {"flip", "serial rx irq", "serial tx irq",
+                                "echo", "sleep", "checkRam"};
+
+// Fails to compile if a name is missing
+typedef char EventTraceNamesMustMatchIds[(sizeof (gNames) / sizeof (gNames[0]) == MAX_NUM_EVENT_TRACE_IDS) ? 1 : -1];
+
+// The ring buffer
+static EventTraceRecord_t gRecords[EVENT_TRACE_NUM_RECORDS];
+static TraceRing_t gRing = TRACE_RING_INIT(gRecords);
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Record an event
+void eventTraceRecord(uint32_t id, uint32_t argument)
+{
+    uint32_t timestamp = cycleCounterRead();
+    EventTraceRecord_t *pRecord;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    pRecord = (EventTraceRecord_t *) traceRingClaim(&gRing);
+    if (pRecord != NULL)
+    {
+        pRecord->timestamp = timestamp;
+        pRecord->id = id;
+        pRecord->argument = argument;
+    }
+    __set_PRIMASK(primask);
+}
+
+// The number of events so far
+uint32_t eventTraceNumEvents()
+{
+    return gRing.numEvents;
+}
+
+// Dump the ring buffer
+uint32_t eventTraceDump(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam)
+{
+    return traceRingDump(&gRing, EVENT_TRACE_MAGIC, EVENT_TRACE_VERSION, MAX_NUM_EVENT_TRACE_IDS,
+                         gNames, MAX_NUM_EVENT_TRACE_IDS, pWrite, pParam);
+}
+
+#endif // EVENT_TRACE
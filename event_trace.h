@@ -0,0 +1,109 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _EVENT_TRACE_H_
+#define _EVENT_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Define EVENT_TRACE to record events (an id, a cycle counter
+// timestamp and one argument) in a ring buffer with the macros below.
+// Recording takes a handful of instructions with interrupts masked,
+// so it can be done from interrupt handlers and disturbs timing far
+// less than a printf() at 9600 baud would.  Dump the buffer with
+// eventTraceDump() and decode it with tools/event_trace/event_trace.py,
+// which prints a timeline and the statistics of each event.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of records in the ring buffer, which must be a power
+// of two
+#ifndef EVENT_TRACE_NUM_RECORDS
+# define EVENT_TRACE_NUM_RECORDS 256
+#endif
+
+// The start of a dump (see trace_ring.h)
+#define EVENT_TRACE_MAGIC "ETRC"
+
+// The version of the dump format
+#define EVENT_TRACE_VERSION 1
+
+// The flags in a record's id marking the start and the end of
+// something, the decoder timing from one to the other
+#define EVENT_TRACE_FLAG_BEGIN 0x8000
+#define EVENT_TRACE_FLAG_END 0x4000
+#define EVENT_TRACE_ID_MASK 0x3fff
+
+// Record an event, or the beginning or end of one, with an argument
+#ifdef EVENT_TRACE
+# define EVENT_TRACE_LOG(id, argument) eventTraceRecord((uint32_t) (id), (uint32_t) (argument))
+# define EVENT_TRACE_BEGIN(id, argument) eventTraceRecord((uint32_t) (id) | EVENT_TRACE_FLAG_BEGIN, (uint32_t) (argument))
+# define EVENT_TRACE_END(id, argument) eventTraceRecord((uint32_t) (id) | EVENT_TRACE_FLAG_END, (uint32_t) (argument))
+#else
+# define EVENT_TRACE_LOG(id, argument)
+# define EVENT_TRACE_BEGIN(id, argument)
+# define EVENT_TRACE_END(id, argument)
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The events of this application; their names, in event_trace.cpp,
+// go in the dump
+typedef enum
+{
+    EVENT_TRACE_ID_FLIP,           // flip(), with the number of calls
+    EVENT_TRACE_ID_SERIAL_RX_IRQ,  // Begin and end, with bytes received
+    EVENT_TRACE_ID_SERIAL_TX_IRQ,  // Begin and end, with bytes sent
+    EVENT_TRACE_ID_ECHO,           // The echo loop, with bytes echoed
+    EVENT_TRACE_ID_SLEEP,          // Begin and end of the echo loop's sleep()
+    EVENT_TRACE_ID_CHECK_RAM,      // Begin and end of checkRam(), with the
+                                   // bytes checked and then success
+    MAX_NUM_EVENT_TRACE_IDS
+} EventTraceId_t;
+
+// A record in the ring buffer and in a dump
+typedef struct
+{
+    uint32_t timestamp;        // From cycleCounterRead()
+    uint32_t id;               // Plus EVENT_TRACE_FLAG_BEGIN or _END
+    uint32_t argument;
+} EventTraceRecord_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Record an event, called through the macros above.
+void eventTraceRecord(uint32_t id, uint32_t argument);
+
+// Return the number of events recorded since start-up.
+uint32_t eventTraceNumEvents(void);
+
+// Write a dump of the ring buffer, in binary, through pWrite, which
+// should return the number of bytes written, blocking as necessary:
+// a TraceRingHeader_t whose detail is the number of names, then the
+// NUL-terminated names, that of id 0 first, then the records.
+// Events are not recorded during the dump.
+// Returns the number of records dumped.
+uint32_t eventTraceDump(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam);
+
+#endif // _EVENT_TRACE_H_
@@ -0,0 +1,377 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "heap_benchmark.h"
+#include "cycle_counter.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A slot in the trace
+typedef struct
+{
+    void * pMem;               // NULL if the allocation failed
+    size_t sizeBytes;          // Zero if the slot is empty
+} HeapBenchmarkSlot_t;
+
+// The latencies of one kind of call
+typedef struct
+{
+    uint32_t samples[HEAP_BENCHMARK_MAX_SAMPLES]; // In counts
+    uint32_t numCalls;
+    uint32_t maxCounts;
+} HeapBenchmarkSamples_t;
+
+// A run of the trace
+typedef struct
+{
+    const HeapBenchmarkAllocator_t * pAllocator;
+    HeapBenchmarkResult_t * pResult;
+    uint32_t seed;             // For the trace
+    uint32_t sampleSeed;       // For choosing which samples to keep
+    size_t liveBytes;
+    size_t maxLiveBytes;
+    uint64_t elapsedCounts;
+} HeapBenchmarkRun_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The slots and samples, kept out of the heap being measured
+static HeapBenchmarkSlot_t gSlots[HEAP_BENCHMARK_NUM_SLOTS];
+static HeapBenchmarkSamples_t gMallocSamples;
+static HeapBenchmarkSamples_t gFreeSamples;
+
+// The names of the patterns
+static const char * gPatternNames[] = {"random", "LIFO", "FIFO", "churn"};
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// A simple linear congruential generator, good enough for a trace
+static uint32_t nextRandom(uint32_t *pSeed)
+{
+    *pSeed = (*pSeed * 1664525) + 1013904223;
+
+    return *pSeed >> 8;
+}
+
+// Pick a block size: half the time up to 32 bytes, a quarter up to
+// 128, an eighth up to 512 and the rest up to the maximum
+static size_t randomSize(uint32_t *pSeed)
+{
+    uint32_t random = nextRandom(pSeed);
+    size_t limitBytes = HEAP_BENCHMARK_MAX_BLOCK_BYTES;
+
+    if ((random & 1) == 0)
+    {
+        limitBytes = 32;
+    }
+    else if ((random & 2) == 0)
+    {
+        limitBytes = 128;
+    }
+    else if ((random & 4) == 0)
+    {
+        limitBytes = 512;
+    }
+    if (limitBytes > HEAP_BENCHMARK_MAX_BLOCK_BYTES)
+    {
+        limitBytes = HEAP_BENCHMARK_MAX_BLOCK_BYTES;
+    }
+
+    return 1 + ((random >> 3) % limitBytes);
+}
+
+// Record the latency of a call, keeping a random sample once there
+// are too many to keep them all
+static void addSample(HeapBenchmarkRun_t *pRun, HeapBenchmarkSamples_t *pSamples, uint32_t counts)
+{
+    uint32_t index = pSamples->numCalls;
+
+    if (index >= HEAP_BENCHMARK_MAX_SAMPLES)
+    {
+        index = nextRandom(&pRun->sampleSeed) % (pSamples->numCalls + 1);
+    }
+    if (index < HEAP_BENCHMARK_MAX_SAMPLES)
+    {
+        pSamples->samples[index] = counts;
+    }
+    pSamples->numCalls++;
+    if (counts > pSamples->maxCounts)
+    {
+        pSamples->maxCounts = counts;
+    }
+    pRun->elapsedCounts += counts;
+}
+
+// For qsort()
+static int compareSamples(const void *pA, const void *pB)
+{
+    uint32_t a = *(const uint32_t *) pA;
+    uint32_t b = *(const uint32_t *) pB;
+
+    return (a > b) - (a < b);
+}
+
+// Work out the percentiles of a set of samples, which get sorted
+static void getLatency(HeapBenchmarkSamples_t *pSamples, HeapBenchmarkLatency_t *pLatency)
+{
+    uint32_t numSamples = pSamples->numCalls;
+
+    memset(pLatency, 0, sizeof (*pLatency));
+    if (numSamples > HEAP_BENCHMARK_MAX_SAMPLES)
+    {
+        numSamples = HEAP_BENCHMARK_MAX_SAMPLES;
+    }
+    if (numSamples > 0)
+    {
+        qsort(pSamples->samples, numSamples, sizeof (pSamples->samples[0]), compareSamples);
+        pLatency->p50Ns = cycleCounterToNs(pSamples->samples[((numSamples - 1) * 50) / 100]);
+        pLatency->p99Ns = cycleCounterToNs(pSamples->samples[((numSamples - 1) * 99) / 100]);
+        pLatency->maxNs = cycleCounterToNs(pSamples->maxCounts);
+    }
+}
+
+// Allocate a slot, if that would not take the trace over its limit,
+// timing it; returns false if the limit stopped it
+static bool mallocSlot(HeapBenchmarkRun_t *pRun, HeapBenchmarkSlot_t *pSlot, size_t sizeBytes)
+{
+    const HeapBenchmarkAllocator_t *pAllocator = pRun->pAllocator;
+    uint32_t startCounts;
+    uint32_t counts;
+
+    if (pRun->liveBytes + sizeBytes > pRun->maxLiveBytes)
+    {
+        return false;
+    }
+
+    startCounts = cycleCounterRead();
+    pSlot->pMem = pAllocator->pMalloc(pAllocator->pContext, sizeBytes);
+    counts = cycleCounterRead() - startCounts;
+    addSample(pRun, &gMallocSamples, counts);
+    pRun->pResult->numMallocs++;
+    if (pSlot->pMem == NULL)
+    {
+        pRun->pResult->numFailures++;
+    }
+    else
+    {
+        memset(pSlot->pMem, (int) sizeBytes, sizeBytes);
+    }
+
+    // The trace carries on as if the allocation had worked
+    pSlot->sizeBytes = sizeBytes;
+    pRun->liveBytes += sizeBytes;
+    if (pRun->liveBytes > pRun->pResult->peakLiveBytes)
+    {
+        pRun->pResult->peakLiveBytes = pRun->liveBytes;
+    }
+
+    return true;
+}
+
+// Free a slot, timing it
+static void freeSlot(HeapBenchmarkRun_t *pRun, HeapBenchmarkSlot_t *pSlot)
+{
+    const HeapBenchmarkAllocator_t *pAllocator = pRun->pAllocator;
+    uint32_t startCounts;
+    uint32_t counts;
+
+    if (pSlot->pMem != NULL)
+    {
+        startCounts = cycleCounterRead();
+        pAllocator->pFree(pAllocator->pContext, pSlot->pMem);
+        counts = cycleCounterRead() - startCounts;
+        addSample(pRun, &gFreeSamples, counts);
+        pRun->pResult->numFrees++;
+    }
+    pRun->liveBytes -= pSlot->sizeBytes;
+    pSlot->pMem = NULL;
+    pSlot->sizeBytes = 0;
+}
+
+// Fill the slots in order, up to the limit, as steps of the trace;
+// returns the number of slots filled
+static uint32_t fillSlots(HeapBenchmarkRun_t *pRun, uint32_t *pStep, uint32_t numSteps)
+{
+    uint32_t numFilled = 0;
+
+    while ((numFilled < HEAP_BENCHMARK_NUM_SLOTS) && (*pStep < numSteps) &&
+           mallocSlot(pRun, &(gSlots[numFilled]), randomSize(&pRun->seed)))
+    {
+        numFilled++;
+        (*pStep)++;
+    }
+
+    return numFilled;
+}
+
+// Run the random pattern
+static void runRandom(HeapBenchmarkRun_t *pRun, uint32_t numSteps)
+{
+    HeapBenchmarkSlot_t *pSlot;
+    size_t sizeBytes;
+
+    for (uint32_t x = 0; x < numSteps; x++)
+    {
+        pSlot = &(gSlots[nextRandom(&pRun->seed) % HEAP_BENCHMARK_NUM_SLOTS]);
+        sizeBytes = randomSize(&pRun->seed);
+        if (pSlot->sizeBytes > 0)
+        {
+            freeSlot(pRun, pSlot);
+        }
+        else
+        {
+            mallocSlot(pRun, pSlot, sizeBytes);
+        }
+    }
+}
+
+// Run the LIFO or FIFO pattern
+static void runQueue(HeapBenchmarkRun_t *pRun, uint32_t numSteps, bool lifo)
+{
+    uint32_t step = 0;
+    uint32_t numFilled = 1;
+
+    while ((step < numSteps) && (numFilled > 0))
+    {
+        numFilled = fillSlots(pRun, &step, numSteps);
+        for (uint32_t x = 0; (x < numFilled) && (step < numSteps); x++, step++)
+        {
+            freeSlot(pRun, &(gSlots[lifo ? numFilled - 1 - x : x]));
+        }
+    }
+}
+
+// Run the churn pattern: each step after the slots are filled frees a
+// random slot and allocates it again with a new size
+static void runChurn(HeapBenchmarkRun_t *pRun, uint32_t numSteps)
+{
+    uint32_t step = 0;
+    uint32_t numFilled;
+    HeapBenchmarkSlot_t *pSlot;
+
+    numFilled = fillSlots(pRun, &step, numSteps);
+    for (; (step < numSteps) && (numFilled > 0); step++)
+    {
+        pSlot = &(gSlots[nextRandom(&pRun->seed) % numFilled]);
+        freeSlot(pRun, pSlot);
+        mallocSlot(pRun, pSlot, randomSize(&pRun->seed));
+    }
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Run the synthetic trace
+void heapBenchmarkRun(const HeapBenchmarkAllocator_t *pAllocator, HeapBenchmarkPattern_t pattern,
+                      uint32_t seed, uint32_t numSteps, size_t maxLiveBytes,
+                      HeapBenchmarkResult_t *pResult)
+{
+    HeapBenchmarkRun_t run;
+
+    if ((pAllocator != NULL) && (pResult != NULL))
+    {
+        memset(pResult, 0, sizeof (*pResult));
+        memset(gSlots, 0, sizeof (gSlots));
+        memset(&gMallocSamples, 0, sizeof (gMallocSamples));
+        memset(&gFreeSamples, 0, sizeof (gFreeSamples));
+        memset(&run, 0, sizeof (run));
+        run.pAllocator = pAllocator;
+        run.pResult = pResult;
+        run.seed = seed;
+        run.sampleSeed = ~seed;
+        run.maxLiveBytes = maxLiveBytes;
+        pResult->pattern = pattern;
+
+        cycleCounterInit();
+        switch (pattern)
+        {
+            case HEAP_BENCHMARK_RANDOM:
+                runRandom(&run, numSteps);
+                break;
+            case HEAP_BENCHMARK_LIFO:
+                runQueue(&run, numSteps, true);
+                break;
+            case HEAP_BENCHMARK_FIFO:
+                runQueue(&run, numSteps, false);
+                break;
+            case HEAP_BENCHMARK_CHURN:
+                runChurn(&run, numSteps);
+                break;
+            default:
+                break;
+        }
+
+        pResult->elapsedUs = (uint32_t) (run.elapsedCounts / cycleCounterPerUs());
+        getLatency(&gMallocSamples, &pResult->mallocLatency);
+        getLatency(&gFreeSamples, &pResult->freeLatency);
+    }
+}
+
+// Free what is left from a trace
+void heapBenchmarkRelease(const HeapBenchmarkAllocator_t *pAllocator)
+{
+    HeapBenchmarkResult_t result;
+    HeapBenchmarkRun_t run;
+
+    if (pAllocator != NULL)
+    {
+        memset(&run, 0, sizeof (run));
+        run.pAllocator = pAllocator;
+        run.pResult = &result;
+        for (uint32_t x = 0; x < HEAP_BENCHMARK_NUM_SLOTS; x++)
+        {
+            freeSlot(&run, &(gSlots[x]));
+        }
+    }
+}
+
+// Return the name of a pattern
+const char * heapBenchmarkPatternName(HeapBenchmarkPattern_t pattern)
+{
+    const char * pName = "unknown";
+
+    if ((pattern >= 0) && (pattern < (int) (sizeof (gPatternNames) / sizeof (gPatternNames[0]))))
+    {
+        pName = gPatternNames[pattern];
+    }
+
+    return pName;
+}
+
+// Print a result
+void heapBenchmarkPrint(const HeapBenchmarkAllocator_t *pAllocator, const HeapBenchmarkResult_t *pResult)
+{
+    if ((pAllocator != NULL) && (pResult != NULL))
+    {
+        printf("    %s, %s: %" PRIu32 " malloc(s) (%" PRIu32 " failed), %" PRIu32 " free(s) in %" PRIu32 " usecond(s), peak %d byte(s) live.\n",
+               pAllocator->pName, heapBenchmarkPatternName(pResult->pattern), pResult->numMallocs,
+               pResult->numFailures, pResult->numFrees, pResult->elapsedUs, (int) pResult->peakLiveBytes);
+        printf("      malloc p50 %" PRIu32 " ns, p99 %" PRIu32 " ns, max %" PRIu32 " ns; free p50 %" PRIu32 " ns, p99 %" PRIu32 " ns, max %" PRIu32 " ns.\n",
+               pResult->mallocLatency.p50Ns, pResult->mallocLatency.p99Ns, pResult->mallocLatency.maxNs,
+               pResult->freeLatency.p50Ns, pResult->freeLatency.p99Ns, pResult->freeLatency.maxNs);
+    }
+}
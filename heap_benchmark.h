@@ -0,0 +1,116 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HEAP_BENCHMARK_H_
+#define _HEAP_BENCHMARK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of blocks the synthetic trace keeps track of at once
+#ifndef HEAP_BENCHMARK_NUM_SLOTS
+# define HEAP_BENCHMARK_NUM_SLOTS 64
+#endif
+
+// The largest block the synthetic trace asks for
+#ifndef HEAP_BENCHMARK_MAX_BLOCK_BYTES
+# define HEAP_BENCHMARK_MAX_BLOCK_BYTES 1024
+#endif
+
+// The number of latencies kept for each of malloc() and free() to
+// work out the percentiles from; once full, a random sample of all
+// of them is kept
+#ifndef HEAP_BENCHMARK_MAX_SAMPLES
+# define HEAP_BENCHMARK_MAX_SAMPLES 256
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The allocation patterns
+typedef enum
+{
+    HEAP_BENCHMARK_RANDOM,     // Allocate or free random slots
+    HEAP_BENCHMARK_LIFO,       // Fill the slots, free newest first, repeat
+    HEAP_BENCHMARK_FIFO,       // Fill the slots, free oldest first, repeat
+    HEAP_BENCHMARK_CHURN,      // Fill the slots, then keep freeing a
+                               // random one and allocating it again
+    MAX_NUM_HEAP_BENCHMARK_PATTERNS
+} HeapBenchmarkPattern_t;
+
+// An allocator for the benchmark to drive
+typedef struct
+{
+    const char * pName;
+    void * (*pMalloc)(void *pContext, size_t sizeBytes);
+    void (*pFree)(void *pContext, void *pMem);
+    void * pContext;
+} HeapBenchmarkAllocator_t;
+
+// The latency of a call
+typedef struct
+{
+    uint32_t p50Ns;
+    uint32_t p99Ns;
+    uint32_t maxNs;
+} HeapBenchmarkLatency_t;
+
+// The result of running the synthetic trace
+typedef struct
+{
+    HeapBenchmarkPattern_t pattern;
+    uint32_t numMallocs;       // Calls to pMalloc()
+    uint32_t numFrees;         // Calls to pFree()
+    uint32_t numFailures;      // Calls to pMalloc() that returned NULL
+    uint32_t elapsedUs;        // Time spent in pMalloc() and pFree()
+    HeapBenchmarkLatency_t mallocLatency;
+    HeapBenchmarkLatency_t freeLatency;
+    size_t peakLiveBytes;      // The most bytes the trace had allocated
+} HeapBenchmarkResult_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Run numSteps steps of a synthetic trace against an allocator, in the
+// given pattern, timing every call with the cycle counter (see
+// cycle_counter.h).  Blocks are mostly small, of varying sizes, some
+// up to HEAP_BENCHMARK_MAX_BLOCK_BYTES, held in HEAP_BENCHMARK_NUM_SLOTS
+// slots, never asking for more than maxLiveBytes in total.  The trace
+// depends only on its parameters, not on which allocations succeed,
+// so different allocators see exactly the same calls.  The blocks
+// still allocated at the end are left so that the state of the heap
+// can be examined; free them with heapBenchmarkRelease().
+void heapBenchmarkRun(const HeapBenchmarkAllocator_t *pAllocator, HeapBenchmarkPattern_t pattern,
+                      uint32_t seed, uint32_t numSteps, size_t maxLiveBytes,
+                      HeapBenchmarkResult_t *pResult);
+
+// Free the blocks left allocated by heapBenchmarkRun().
+void heapBenchmarkRelease(const HeapBenchmarkAllocator_t *pAllocator);
+
+// Return the name of a pattern.
+const char * heapBenchmarkPatternName(HeapBenchmarkPattern_t pattern);
+
+// Print a result.
+void heapBenchmarkPrint(const HeapBenchmarkAllocator_t *pAllocator, const HeapBenchmarkResult_t *pResult);
+
+#endif // _HEAP_BENCHMARK_H_
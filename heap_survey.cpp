@@ -0,0 +1,237 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "heap_survey.h"
+#include "tlsf.h"
+
+#if defined(TOOLCHAIN_GCC_ARM)
+#include <reent.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------
+// GENERAL COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Things to do with the newlib (dlmalloc) heap
+// The number of bins
+#define NEWLIB_MALLOC_NUM_BINS 128
+// The flag bits at the bottom of a chunk's size field
+#define NEWLIB_MALLOC_SIZE_BITS 0x03
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+#if defined(TOOLCHAIN_GCC_ARM)
+
+// A chunk as seen by the full newlib (dlmalloc) allocator
+typedef struct NewlibChunkTag
+{
+    size_t prevSize;
+    size_t size;
+    struct NewlibChunkTag *pNext;
+    struct NewlibChunkTag *pPrev;
+} NewlibChunk_t;
+
+// A chunk as seen by the newlib-nano allocator
+typedef struct NanoChunkTag
+{
+    long size;
+    struct NanoChunkTag *pNext;
+} NanoChunk_t;
+
+#endif
+
+// ----------------------------------------------------------------
+// EXTERNAL SYMBOLS
+// ----------------------------------------------------------------
+
+#if defined(TOOLCHAIN_GCC_ARM)
+
+// These are all weak: only one of the two allocators will be
+// linked and not all linker scripts define the heap limit
+extern "C" NewlibChunk_t * __malloc_av_[] __attribute__((weak));
+extern "C" NanoChunk_t * __malloc_free_list __attribute__((weak));
+extern "C" uint32_t __HeapLimit __attribute__((weak));
+
+extern "C" void __malloc_lock(struct _reent *pReent);
+extern "C" void __malloc_unlock(struct _reent *pReent);
+
+#endif
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+#if defined(TOOLCHAIN_GCC_ARM) || defined(MBED_HOST_BUILD) || defined(HEAP_TLSF)
+
+// Add a free block to a survey
+static void addFreeBlock(HeapSurvey_t *pSurvey, size_t sizeBytes)
+{
+    if (sizeBytes > 0)
+    {
+        pSurvey->totalFreeBytes += sizeBytes;
+        pSurvey->numFreeBlocks++;
+        if (sizeBytes > pSurvey->largestFreeBytes)
+        {
+            pSurvey->largestFreeBytes = sizeBytes;
+        }
+    }
+}
+
+#endif
+
+#if defined(HEAP_TLSF) && !defined(MBED_HOST_BUILD)
+
+// Add a free block of the TLSF heap to a survey.
+static void addTlsfBlock(void *pParam, void *pMem, size_t sizeBytes, bool used)
+{
+    (void) pMem;
+    if (!used)
+    {
+        addFreeBlock((HeapSurvey_t *) pParam, sizeBytes);
+    }
+}
+
+#elif defined(TOOLCHAIN_GCC_ARM)
+
+// Return the number of bytes between the current program break and
+// the limit the heap may be sbrk()'ed up to.
+static size_t unsbrkedBytes()
+{
+    char * pBreak = (char *) sbrk(0);
+    char * pLimit;
+
+    if (&__HeapLimit != NULL)
+    {
+        pLimit = (char *) &__HeapLimit;
+    }
+    else
+    {
+        pLimit = (char *) __get_MSP();
+    }
+
+    return (pLimit > pBreak) ? pLimit - pBreak : 0;
+}
+
+// Survey the full newlib (dlmalloc) heap: every free chunk is in one of
+// the bins, apart from the top chunk, which borders the program break
+// and so can be extended into the unsbrk()'ed space.
+static void surveyNewlib(HeapSurvey_t *pSurvey)
+{
+    NewlibChunk_t *pBin;
+    NewlibChunk_t *pChunk;
+
+    // Bin 0 is not a real bin, its forward pointer is the top chunk
+    pChunk = __malloc_av_[2];
+    addFreeBlock(pSurvey, (pChunk->size & ~NEWLIB_MALLOC_SIZE_BITS) + unsbrkedBytes());
+
+    for (uint32_t x = 1; x < NEWLIB_MALLOC_NUM_BINS; x++)
+    {
+        // A bin's header overlays a chunk whose pNext/pPrev are the
+        // bin's pair of entries in __malloc_av_[]
+        pBin = (NewlibChunk_t *) ((char *) &(__malloc_av_[(x * 2) + 2]) - (2 * sizeof (size_t)));
+        for (pChunk = pBin->pNext; pChunk != pBin; pChunk = pChunk->pNext)
+        {
+            addFreeBlock(pSurvey, pChunk->size & ~NEWLIB_MALLOC_SIZE_BITS);
+        }
+    }
+}
+
+// Survey the newlib-nano heap: the free list is a single address-ordered
+// list and the last chunk may border the program break.
+static void surveyNano(HeapSurvey_t *pSurvey)
+{
+    char * pBreak = (char *) sbrk(0);
+    size_t extraBytes = unsbrkedBytes();
+    size_t sizeBytes;
+
+    for (NanoChunk_t *pChunk = __malloc_free_list; pChunk != NULL; pChunk = pChunk->pNext)
+    {
+        sizeBytes = (size_t) pChunk->size;
+        if ((char *) pChunk + sizeBytes == pBreak)
+        {
+            sizeBytes += extraBytes;
+            extraBytes = 0;
+        }
+        addFreeBlock(pSurvey, sizeBytes);
+    }
+
+    // Whatever was not merged with a chunk is a block of its own
+    addFreeBlock(pSurvey, extraBytes);
+}
+
+#elif defined(MBED_HOST_BUILD)
+
+// Add a free block of the simulated heap to a survey.
+static void addHostFreeBlock(void *pParam, size_t sizeBytes)
+{
+    addFreeBlock((HeapSurvey_t *) pParam, sizeBytes);
+}
+
+#endif
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Survey the heap
+bool heapSurvey(HeapSurvey_t *pSurvey)
+{
+    bool success = false;
+
+    if (pSurvey != NULL)
+    {
+        memset(pSurvey, 0, sizeof (*pSurvey));
+
+#if defined(HEAP_TLSF) && !defined(MBED_HOST_BUILD)
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (tlsfHeap() != NULL)
+        {
+            tlsfWalk(tlsfHeap(), addTlsfBlock, pSurvey);
+            success = true;
+        }
+        __set_PRIMASK(primask);
+#elif defined(TOOLCHAIN_GCC_ARM)
+        __malloc_lock(_REENT);
+        if (__malloc_av_ != NULL)
+        {
+            surveyNewlib(pSurvey);
+            success = true;
+        }
+        else if (&__malloc_free_list != NULL)
+        {
+            surveyNano(pSurvey);
+            success = true;
+        }
+        __malloc_unlock(_REENT);
+#elif defined(MBED_HOST_BUILD)
+        hostHeapWalk(addHostFreeBlock, pSurvey);
+        success = true;
+#endif
+
+        if (pSurvey->totalFreeBytes > 0)
+        {
+            pSurvey->fragmentationPercent = 100 - (uint32_t) (((uint64_t) pSurvey->largestFreeBytes * 100) / pSurvey->totalFreeBytes);
+        }
+    }
+
+    return success;
+}
@@ -0,0 +1,53 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HEAP_SURVEY_H_
+#define _HEAP_SURVEY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The result of a heap survey
+typedef struct
+{
+    size_t totalFreeBytes;      // All the free bytes in the heap, including
+                                // the part that has not yet been sbrk()'ed
+    size_t largestFreeBytes;    // The largest single free block
+    uint32_t numFreeBlocks;     // The number of free blocks
+    uint32_t fragmentationPercent; // 100 * (1 - largest / total), so 0 means
+                                   // that all of the free heap is in one block
+} HeapSurvey_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Survey the heap by walking the C library's free list, or the TLSF
+// allocator's blocks if HEAP_TLSF is defined.  Nothing is allocated
+// and the heap is visited in a single pass with the malloc lock held
+// (interrupts masked for TLSF).  The sizes reported are those of the
+// free chunks, i.e. they include the allocator's per-chunk overhead
+// (for TLSF they are the usable sizes).
+// Returns true if the survey was done, false if the C library in use
+// cannot be surveyed (in which case pSurvey is zeroed).
+bool heapSurvey(HeapSurvey_t *pSurvey);
+
+#endif // _HEAP_SURVEY_H_
@@ -0,0 +1,206 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "heap_trace.h"
+#include "cycle_counter.h"
+#include "trace_ring.h"
+
+#ifdef HEAP_TRACE
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Whether the C library's allocator is the one to hook: there are no
+// hooks in it, so calls to it are intercepted here
+#if !defined(HEAP_TLSF) && !defined(MBED_HOST_BUILD)
+# if defined(TOOLCHAIN_GCC_ARM) || defined(__CC_ARM)
+#  define HEAP_TRACE_INTERCEPT 1
+# endif
+#endif
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Fails to compile if HEAP_TRACE_NUM_RECORDS is not a power of two
+typedef char HeapTraceNumRecordsMustBeAPowerOfTwo[((HEAP_TRACE_NUM_RECORDS & (HEAP_TRACE_NUM_RECORDS - 1)) == 0) ? 1 : -1];
+
+// The ring buffer
+static HeapTraceRecord_t gRecords[HEAP_TRACE_NUM_RECORDS];
+static TraceRing_t gRing = TRACE_RING_INIT(gRecords);
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Add a record to the ring buffer
+static void record(HeapTraceEvent_t event, void *pCaller, void *pMem, size_t sizeBytes)
+{
+    uint32_t timestamp = cycleCounterRead();
+    HeapTraceRecord_t *pRecord;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    pRecord = (HeapTraceRecord_t *) traceRingClaim(&gRing);
+    if (pRecord != NULL)
+    {
+        pRecord->timestamp = timestamp;
+        pRecord->sizeAndEvent = (sizeBytes & HEAP_TRACE_SIZE_MASK) | ((uint32_t) event << HEAP_TRACE_EVENT_SHIFT);
+        pRecord->caller = (uintptr_t) pCaller;
+        pRecord->pointer = (uintptr_t) pMem;
+    }
+    __set_PRIMASK(primask);
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Record a malloc()
+void heapTraceMalloc(void *pCaller, void *pMem, size_t sizeBytes)
+{
+    record(HEAP_TRACE_EVENT_MALLOC, pCaller, pMem, sizeBytes);
+}
+
+// Record a free()
+void heapTraceFree(void *pCaller, void *pMem)
+{
+    if (pMem != NULL)
+    {
+        record(HEAP_TRACE_EVENT_FREE, pCaller, pMem, 0);
+    }
+}
+
+// Record a realloc() as a free() of the old block, if it went, and a
+// malloc() of the new one
+void heapTraceRealloc(void *pCaller, void *pOldMem, void *pMem, size_t sizeBytes)
+{
+    if ((pMem != NULL) || (sizeBytes == 0))
+    {
+        heapTraceFree(pCaller, pOldMem);
+    }
+    if ((pMem != NULL) || (sizeBytes > 0))
+    {
+        heapTraceMalloc(pCaller, pMem, sizeBytes);
+    }
+}
+
+// The number of events so far
+uint32_t heapTraceNumEvents()
+{
+    return gRing.numEvents;
+}
+
+// Dump the ring buffer
+uint32_t heapTraceDump(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam)
+{
+    return traceRingDump(&gRing, HEAP_TRACE_MAGIC, HEAP_TRACE_VERSION, sizeof (uintptr_t),
+                         NULL, 0, pWrite, pParam);
+}
+
+#ifdef HEAP_TRACE_INTERCEPT
+
+# if defined(TOOLCHAIN_GCC_ARM)
+
+// With the linker's --wrap, calls to malloc() and friends come here
+extern "C" void * __real_malloc(size_t sizeBytes);
+extern "C" void __real_free(void *pMem);
+extern "C" void * __real_realloc(void *pMem, size_t sizeBytes);
+extern "C" void * __real_calloc(size_t numItems, size_t itemSizeBytes);
+
+extern "C" void * __wrap_malloc(size_t sizeBytes)
+{
+    void *pMem = __real_malloc(sizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void __wrap_free(void *pMem)
+{
+    HEAP_TRACE_FREE(pMem);
+    __real_free(pMem);
+}
+
+extern "C" void * __wrap_realloc(void *pOldMem, size_t sizeBytes)
+{
+    void *pMem = __real_realloc(pOldMem, sizeBytes);
+
+    HEAP_TRACE_REALLOC(pOldMem, pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void * __wrap_calloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = __real_calloc(numItems, itemSizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, numItems * itemSizeBytes);
+
+    return pMem;
+}
+
+# elif defined(__CC_ARM)
+
+// The ARM linker sends calls to malloc() and friends to $Sub$$malloc()
+// and so on, the original being $Super$$malloc()
+extern "C" void * $Super$$malloc(size_t sizeBytes);
+extern "C" void $Super$$free(void *pMem);
+extern "C" void * $Super$$realloc(void *pMem, size_t sizeBytes);
+extern "C" void * $Super$$calloc(size_t numItems, size_t itemSizeBytes);
+
+extern "C" void * $Sub$$malloc(size_t sizeBytes)
+{
+    void *pMem = $Super$$malloc(sizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void $Sub$$free(void *pMem)
+{
+    HEAP_TRACE_FREE(pMem);
+    $Super$$free(pMem);
+}
+
+extern "C" void * $Sub$$realloc(void *pOldMem, size_t sizeBytes)
+{
+    void *pMem = $Super$$realloc(pOldMem, sizeBytes);
+
+    HEAP_TRACE_REALLOC(pOldMem, pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void * $Sub$$calloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = $Super$$calloc(numItems, itemSizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, numItems * itemSizeBytes);
+
+    return pMem;
+}
+
+# endif
+
+#endif // HEAP_TRACE_INTERCEPT
+
+#endif // HEAP_TRACE
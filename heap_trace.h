@@ -0,0 +1,118 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HEAP_TRACE_H_
+#define _HEAP_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Define HEAP_TRACE to record every malloc() and free() (the caller's
+// PC, the size, the pointer and a cycle counter timestamp) in a ring
+// buffer, so that heap use can be examined after the fact.  Recording
+// masks interrupts for a handful of instructions.  The hooks are in
+// the allocators the application provides (tlsf_heap.cpp and the host
+// build's heap); otherwise, with GCC_ARM, add
+// -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc to the
+// linker flags of the build profile and with ARM the $Sub$$ functions
+// here are picked up by the linker automatically.  Dump the buffer
+// with heapTraceDump() and decode it with tools/heap_trace/heap_trace.py.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of records in the ring buffer, which must be a power
+// of two
+#ifndef HEAP_TRACE_NUM_RECORDS
+# define HEAP_TRACE_NUM_RECORDS 128
+#endif
+
+// The start of a dump (see trace_ring.h)
+#define HEAP_TRACE_MAGIC "HTRC"
+
+// The version of the dump format
+#define HEAP_TRACE_VERSION 1
+
+// The largest size that can be recorded
+#define HEAP_TRACE_SIZE_MASK 0x0fffffff
+
+// The shift of the event type in a record's sizeAndEvent
+#define HEAP_TRACE_EVENT_SHIFT 28
+
+// The hooks for an allocator to call: record a malloc() (pMem NULL if
+// it failed), a free(), before freeing, and a realloc(), afterwards,
+// from the allocator's public functions so that the return address is
+// that of its caller
+#ifdef HEAP_TRACE
+# if defined(__CC_ARM)
+#  define HEAP_TRACE_CALLER() ((void *) __return_address())
+# elif defined(__GNUC__)
+#  define HEAP_TRACE_CALLER() __builtin_return_address(0)
+# else
+#  define HEAP_TRACE_CALLER() NULL
+# endif
+# define HEAP_TRACE_MALLOC(pMem, sizeBytes) heapTraceMalloc(HEAP_TRACE_CALLER(), pMem, sizeBytes)
+# define HEAP_TRACE_FREE(pMem) heapTraceFree(HEAP_TRACE_CALLER(), pMem)
+# define HEAP_TRACE_REALLOC(pOldMem, pMem, sizeBytes) heapTraceRealloc(HEAP_TRACE_CALLER(), pOldMem, pMem, sizeBytes)
+#else
+# define HEAP_TRACE_MALLOC(pMem, sizeBytes)
+# define HEAP_TRACE_FREE(pMem)
+# define HEAP_TRACE_REALLOC(pOldMem, pMem, sizeBytes)
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The events recorded
+typedef enum
+{
+    HEAP_TRACE_EVENT_MALLOC = 1,
+    HEAP_TRACE_EVENT_FREE = 2
+} HeapTraceEvent_t;
+
+// A record in the ring buffer and in a dump
+typedef struct
+{
+    uint32_t timestamp;        // From cycleCounterRead()
+    uint32_t sizeAndEvent;     // Event in the top four bits
+    uintptr_t caller;          // The PC the call returns to
+    uintptr_t pointer;
+} HeapTraceRecord_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// The hooks, called through the macros above.
+void heapTraceMalloc(void *pCaller, void *pMem, size_t sizeBytes);
+void heapTraceFree(void *pCaller, void *pMem);
+void heapTraceRealloc(void *pCaller, void *pOldMem, void *pMem, size_t sizeBytes);
+
+// Return the number of events recorded since start-up.
+uint32_t heapTraceNumEvents(void);
+
+// Write a dump of the ring buffer, in binary, through pWrite, which
+// should return the number of bytes written, blocking as necessary:
+// a TraceRingHeader_t whose detail is the size of a pointer, then the
+// records.
+// Events are not recorded during the dump.
+// Returns the number of records dumped.
+uint32_t heapTraceDump(int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam);
+
+#endif // _HEAP_TRACE_H_
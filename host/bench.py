@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Benchmark harness for the host build of the application.
+
+Runs the application, timestamps each "***" progress line it prints so
+that the time spent in each stage (checkCpu, checkHeapSize/checkRam,
+the ticker test, ...) can be seen, then pushes a payload through the
+echo loop and checks that it all comes back, reporting the throughput.
+"""
+
+import argparse
+import os
+import select
+import subprocess
+import sys
+import time
+
+ECHO_PROMPT = b"*** Echoing received characters forever."
+
+def read_until(process, pattern, timeout, on_line=None):
+    """Read the application's output until pattern is seen, calling
+    on_line(time, line) for each complete line; returns the output."""
+    output = b""
+    line = b""
+    deadline = time.monotonic() + timeout
+    while pattern not in output:
+        remaining = deadline - time.monotonic()
+        if remaining <= 0:
+            raise TimeoutError("timed out waiting for %r" % pattern)
+        readable, _, _ = select.select([process.stdout], [], [], remaining)
+        if not readable:
+            continue
+        data = os.read(process.stdout.fileno(), 4096)
+        if not data:
+            raise EOFError("application exited while waiting for %r" % pattern)
+        output += data
+        line += data
+        while b"\n" in line:
+            complete, line = line.split(b"\n", 1)
+            if on_line:
+                on_line(time.monotonic(), complete.rstrip(b"\r"))
+    return output
+
+def run_stages(process, timeout):
+    """Print the time spent on each "***" stage up to the echo loop."""
+    start = time.monotonic()
+    stage = {"name": "start-up", "time": start}
+
+    def on_line(now, line):
+        text = line.decode("utf-8", "replace")
+        if verbose:
+            print("    " + text)
+        if text.startswith("***"):
+            print("%8.3f s  %s" % (now - stage["time"], stage["name"]))
+            stage["name"] = text.lstrip("* ").rstrip(".")
+            stage["time"] = now
+
+    read_until(process, ECHO_PROMPT, timeout, on_line)
+    print("%8.3f s  total to reach the echo loop" % (time.monotonic() - start))
+
+def run_echo(process, payload_bytes, chunk_bytes, timeout):
+    """Push payload_bytes through the echo loop chunk_bytes at a time,
+    waiting for each chunk to come back so as not to overrun the
+    receive buffer, and return the elapsed time."""
+    payload = bytes((x % 94) + 33 for x in range(payload_bytes))
+    received = b""
+    start = time.monotonic()
+    for offset in range(0, len(payload), chunk_bytes):
+        chunk = payload[offset:offset + chunk_bytes]
+        process.stdin.write(chunk)
+        process.stdin.flush()
+        expected = offset + len(chunk)
+        deadline = time.monotonic() + timeout
+        while len(received) < expected:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError("echo stalled after %d of %d byte(s)" %
+                                   (len(received), len(payload)))
+            readable, _, _ = select.select([process.stdout], [], [], remaining)
+            if readable:
+                data = os.read(process.stdout.fileno(), 4096)
+                if not data:
+                    raise EOFError("application exited during the echo test")
+                received += data
+    elapsed = time.monotonic() - start
+    if received != payload:
+        mismatch = next(x for x in range(len(payload)) if received[x] != payload[x])
+        raise ValueError("echo mismatch at byte %d" % mismatch)
+    return elapsed
+
+def main():
+    global verbose
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("app", help="the host build of the application")
+    parser.add_argument("-n", "--payload-bytes", type=int, default=1024,
+                        help="number of bytes to echo (default %(default)s)")
+    parser.add_argument("-c", "--chunk-bytes", type=int, default=128,
+                        help="bytes sent before waiting for the echo (default %(default)s)")
+    parser.add_argument("-t", "--timeout", type=float, default=60,
+                        help="seconds to wait for each step (default %(default)s)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="show the application's output")
+    args = parser.parse_args()
+    verbose = args.verbose
+
+    process = subprocess.Popen([args.app], stdin=subprocess.PIPE,
+                               stdout=subprocess.PIPE)
+    try:
+        print("Stage timings:")
+        run_stages(process, args.timeout)
+        elapsed = run_echo(process, args.payload_bytes, args.chunk_bytes,
+                           args.timeout)
+        print("Echoed %d byte(s) correctly in %.3f s, %.0f bytes/s." %
+              (args.payload_bytes, elapsed, args.payload_bytes / elapsed))
+    except (TimeoutError, EOFError, ValueError) as error:
+        print("FAILED: %s" % error)
+        return 1
+    finally:
+        process.kill()
+        process.wait()
+    return 0
+
+verbose = False
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,380 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A simulated application heap for the host build.  The application
+// is linked with --wrap for malloc(), free(), calloc() and realloc(),
+// so that its calls come here rather than to the C library: that way
+// the heap is as small as it would be on the target and malloc() can
+// fail, rather than the application being handed the host's gigabytes.
+// The allocator is a simple address-ordered first-fit one, much like
+// newlib-nano's, or the application's TLSF allocator if HEAP_TLSF is
+// defined.
+
+#include "mbed.h"
+#include "tlsf.h"
+#include "heap_trace.h"
+
+#include <mutex>
+
+// ----------------------------------------------------------------
+// GENERAL COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the simulated heap
+#ifndef HOST_HEAP_SIZE_BYTES
+# define HOST_HEAP_SIZE_BYTES 16384
+#endif
+
+// The alignment of every block handed out, which is also the size of
+// the header on each chunk
+#define HOST_HEAP_ALIGNMENT 16
+
+// The smallest chunk worth splitting off
+#define HOST_HEAP_MIN_CHUNK_BYTES (HOST_HEAP_ALIGNMENT * 2)
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A chunk of the heap; for allocated chunks only the size is valid
+// and the block handed out starts HOST_HEAP_ALIGNMENT bytes in
+typedef struct HostChunkTag
+{
+    size_t size;
+    struct HostChunkTag *pNext;
+} HostChunk_t;
+
+// A walk of the heap by hostHeapWalk()
+typedef struct
+{
+    void (*pCallback)(void *pParam, size_t sizeBytes);
+    void *pParam;
+} HostHeapWalk_t;
+
+// ----------------------------------------------------------------
+// EXTERNAL SYMBOLS
+// ----------------------------------------------------------------
+
+// Provided by the host linker
+extern "C" char __data_start[];
+extern "C" char _edata[];
+extern "C" char __bss_start[];
+extern "C" char _end[];
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The heap
+static uint8_t gHeap[HOST_HEAP_SIZE_BYTES] __attribute__((aligned(HOST_HEAP_ALIGNMENT)));
+
+#ifdef HEAP_TLSF
+// The TLSF allocator managing the heap
+static Tlsf_t gTlsf;
+#else
+// The free list, in address order
+static HostChunk_t *gpFreeList = NULL;
+#endif
+
+// Whether the heap has been set up
+static bool gHeapInitialised = false;
+
+// Protects the above
+static std::mutex gHeapMutex;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up the heap as one free chunk, once
+static void heapInit()
+{
+    if (!gHeapInitialised)
+    {
+#ifdef HEAP_TLSF
+        tlsfInit(&gTlsf, gHeap, sizeof (gHeap));
+#else
+        gpFreeList = (HostChunk_t *) gHeap;
+        gpFreeList->size = sizeof (gHeap);
+        gpFreeList->pNext = NULL;
+#endif
+        gHeapInitialised = true;
+    }
+}
+
+#ifdef HEAP_TLSF
+// Pass a free TLSF block on to a hostHeapWalk() callback
+static void walkTlsfBlock(void *pParam, void *pMem, size_t sizeBytes, bool used)
+{
+    HostHeapWalk_t *pWalk = (HostHeapWalk_t *) pParam;
+
+    (void) pMem;
+    if (!used)
+    {
+        pWalk->pCallback(pWalk->pParam, sizeBytes);
+    }
+}
+#endif
+
+// Whether a pointer is in the heap
+static bool inHeap(void *pMem)
+{
+    return ((uint8_t *) pMem >= gHeap) && ((uint8_t *) pMem < gHeap + sizeof (gHeap));
+}
+
+#ifdef HEAP_TLSF
+
+static void *heapMalloc(size_t sizeBytes)
+{
+    std::lock_guard<std::mutex> lock(gHeapMutex);
+
+    heapInit();
+
+    return tlsfMalloc(&gTlsf, sizeBytes);
+}
+
+static void heapFree(void *pMem)
+{
+    std::lock_guard<std::mutex> lock(gHeapMutex);
+
+    tlsfFree(&gTlsf, pMem);
+}
+
+static void *heapRealloc(void *pMem, size_t sizeBytes)
+{
+    std::lock_guard<std::mutex> lock(gHeapMutex);
+
+    heapInit();
+
+    return tlsfRealloc(&gTlsf, pMem, sizeBytes);
+}
+
+#else
+
+static void *heapMalloc(size_t sizeBytes)
+{
+    std::lock_guard<std::mutex> lock(gHeapMutex);
+    HostChunk_t **ppPrevious;
+    HostChunk_t *pChunk;
+    HostChunk_t *pRemainder;
+    size_t chunkSizeBytes;
+    void *pMem = NULL;
+
+    heapInit();
+
+    if ((sizeBytes > 0) && (sizeBytes <= sizeof (gHeap)))
+    {
+        chunkSizeBytes = ((sizeBytes + HOST_HEAP_ALIGNMENT - 1) & ~(HOST_HEAP_ALIGNMENT - 1)) + HOST_HEAP_ALIGNMENT;
+        for (ppPrevious = &gpFreeList; *ppPrevious != NULL; ppPrevious = &(*ppPrevious)->pNext)
+        {
+            pChunk = *ppPrevious;
+            if (pChunk->size >= chunkSizeBytes)
+            {
+                if (pChunk->size - chunkSizeBytes >= HOST_HEAP_MIN_CHUNK_BYTES)
+                {
+                    // Split, leaving the remainder in the list
+                    pRemainder = (HostChunk_t *) ((uint8_t *) pChunk + chunkSizeBytes);
+                    pRemainder->size = pChunk->size - chunkSizeBytes;
+                    pRemainder->pNext = pChunk->pNext;
+                    pChunk->size = chunkSizeBytes;
+                    *ppPrevious = pRemainder;
+                }
+                else
+                {
+                    *ppPrevious = pChunk->pNext;
+                }
+                pMem = (uint8_t *) pChunk + HOST_HEAP_ALIGNMENT;
+                break;
+            }
+        }
+    }
+
+    return pMem;
+}
+
+static void heapFree(void *pMem)
+{
+    HostChunk_t **ppPrevious;
+    HostChunk_t *pChunk;
+    HostChunk_t *pNext;
+
+    if (pMem != NULL)
+    {
+        std::lock_guard<std::mutex> lock(gHeapMutex);
+
+        pChunk = (HostChunk_t *) ((uint8_t *) pMem - HOST_HEAP_ALIGNMENT);
+        for (ppPrevious = &gpFreeList; (*ppPrevious != NULL) && (*ppPrevious < pChunk); ppPrevious = &(*ppPrevious)->pNext)
+        {
+        }
+
+        // Insert, merging with the following chunk if adjacent
+        pNext = *ppPrevious;
+        if ((pNext != NULL) && ((uint8_t *) pChunk + pChunk->size == (uint8_t *) pNext))
+        {
+            pChunk->size += pNext->size;
+            pNext = pNext->pNext;
+        }
+        pChunk->pNext = pNext;
+        *ppPrevious = pChunk;
+
+        // Merge with the preceding chunk if adjacent
+        if (ppPrevious != &gpFreeList)
+        {
+            HostChunk_t *pPrevious = (HostChunk_t *) ((uint8_t *) ppPrevious - offsetof(HostChunk_t, pNext));
+            if ((uint8_t *) pPrevious + pPrevious->size == (uint8_t *) pChunk)
+            {
+                pPrevious->size += pChunk->size;
+                pPrevious->pNext = pChunk->pNext;
+            }
+        }
+    }
+}
+
+static void *heapRealloc(void *pMem, size_t sizeBytes)
+{
+    void *pNewMem;
+    size_t oldSizeBytes;
+
+    if (pMem == NULL)
+    {
+        return heapMalloc(sizeBytes);
+    }
+
+    oldSizeBytes = ((HostChunk_t *) ((uint8_t *) pMem - HOST_HEAP_ALIGNMENT))->size - HOST_HEAP_ALIGNMENT;
+    pNewMem = heapMalloc(sizeBytes);
+    if (pNewMem != NULL)
+    {
+        memcpy(pNewMem, pMem, (oldSizeBytes < sizeBytes) ? oldSizeBytes : sizeBytes);
+        heapFree(pMem);
+    }
+
+    return pNewMem;
+}
+
+#endif
+
+static void *heapCalloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = NULL;
+
+    if ((itemSizeBytes == 0) || (numItems <= sizeof (gHeap) / itemSizeBytes))
+    {
+        pMem = heapMalloc(numItems * itemSizeBytes);
+        if (pMem != NULL)
+        {
+            memset(pMem, 0, numItems * itemSizeBytes);
+        }
+    }
+
+    return pMem;
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// The wrappers call the hooks of heap_trace.h, which are empty unless
+// HEAP_TRACE is defined; blocks that are not in the simulated heap,
+// e.g. from strdup() inside the C library, are passed to the real
+// functions
+
+extern "C" void __real_free(void *pMem);
+extern "C" void *__real_realloc(void *pMem, size_t sizeBytes);
+
+extern "C" void *__wrap_malloc(size_t sizeBytes)
+{
+    void *pMem = heapMalloc(sizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void __wrap_free(void *pMem)
+{
+    if ((pMem != NULL) && !inHeap(pMem))
+    {
+        __real_free(pMem);
+    }
+    else
+    {
+        HEAP_TRACE_FREE(pMem);
+        heapFree(pMem);
+    }
+}
+
+extern "C" void *__wrap_realloc(void *pMem, size_t sizeBytes)
+{
+    void *pNewMem;
+
+    if ((pMem != NULL) && !inHeap(pMem))
+    {
+        return __real_realloc(pMem, sizeBytes);
+    }
+
+    pNewMem = heapRealloc(pMem, sizeBytes);
+    HEAP_TRACE_REALLOC(pMem, pNewMem, sizeBytes);
+
+    return pNewMem;
+}
+
+extern "C" void *__wrap_calloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = heapCalloc(numItems, itemSizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, numItems * itemSizeBytes);
+
+    return pMem;
+}
+
+#ifdef HEAP_TLSF
+// The allocator behind malloc()
+Tlsf_t * tlsfHeap()
+{
+    return gHeapInitialised ? &gTlsf : NULL;
+}
+#endif
+
+// Get the bounds of data, bss and the simulated heap
+extern "C" void hostMemoryMap(char **ppDataStart, char **ppDataEnd,
+                              char **ppBssStart, char **ppBssEnd,
+                              char **ppHeapStart, char **ppHeapEnd)
+{
+    *ppDataStart = __data_start;
+    *ppDataEnd = _edata;
+    *ppBssStart = __bss_start;
+    *ppBssEnd = _end;
+    *ppHeapStart = (char *) gHeap;
+    *ppHeapEnd = (char *) gHeap + sizeof (gHeap);
+}
+
+// Walk the free list
+extern "C" void hostHeapWalk(void (*pCallback)(void *pParam, size_t sizeBytes), void *pParam)
+{
+    std::lock_guard<std::mutex> lock(gHeapMutex);
+
+    heapInit();
+#ifdef HEAP_TLSF
+    HostHeapWalk_t walk = {pCallback, pParam};
+    tlsfWalk(&gTlsf, walkTlsfBlock, &walk);
+#else
+    for (HostChunk_t *pChunk = gpFreeList; pChunk != NULL; pChunk = pChunk->pNext)
+    {
+        pCallback(pParam, pChunk->size);
+    }
+#endif
+}
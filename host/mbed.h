@@ -0,0 +1,253 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A minimal stand-in for mbed.h so that the application can be built
+// and run on a Linux host.  Only what the application uses is here.
+// "Interrupts" are run, one at a time, by a single thread that
+// services the tickers and the serial port; masking interrupts takes
+// a lock that stops that thread running handlers.
+
+#ifndef _MBED_HOST_H_
+#define _MBED_HOST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+#define MBED_HOST_BUILD
+
+// A fake System Control Block, filled in to look like a Cortex-M0
+extern "C" uint32_t gHostSystemControlBlock[];
+#define SYSTEM_CONTROL_BLOCK_START_ADDRESS gHostSystemControlBlock
+
+// The core clock: the host's "cycle counter" counts nanoseconds, so
+// this is 1 GHz
+extern "C" uint32_t SystemCoreClock;
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+typedef enum
+{
+    LED1,
+    USBTX,
+    USBRX,
+    NC
+} PinName;
+
+typedef uint32_t timestamp_t;
+
+// A callback: a function or an object and member function
+template <typename F>
+class Callback;
+
+template <typename R>
+class Callback<R()>
+{
+public:
+    Callback(R (*pFunction)() = NULL) : _pFunction(pFunction), _pObject(NULL), _pThunk(NULL) {}
+
+    template <typename T>
+    Callback(T *pObject, R (T::*method)()) : _pFunction(NULL), _pObject(pObject), _pThunk(&thunk<T>)
+    {
+        memcpy(_method, &method, sizeof (method));
+    }
+
+    R call() const
+    {
+        return (_pThunk != NULL) ? _pThunk(_pObject, _method) : _pFunction();
+    }
+
+    R operator()() const
+    {
+        return call();
+    }
+
+    operator bool() const
+    {
+        return (_pFunction != NULL) || (_pThunk != NULL);
+    }
+
+private:
+    template <typename T>
+    static R thunk(void *pObject, const char *pMethod)
+    {
+        R (T::*method)();
+
+        memcpy(&method, pMethod, sizeof (method));
+        return (((T *) pObject)->*method)();
+    }
+
+    R (*_pFunction)();
+    void * _pObject;
+    R (*_pThunk)(void *, const char *);
+    char _method[2 * sizeof (void *)];
+};
+
+template <typename T, typename R>
+Callback<R()> callback(T *pObject, R (T::*method)())
+{
+    return Callback<R()>(pObject, method);
+}
+
+// ----------------------------------------------------------------
+// CLASSES
+// ----------------------------------------------------------------
+
+// A GPIO: remembers its value and counts the changes
+class DigitalOut
+{
+public:
+    DigitalOut(PinName pin) : _value(0), _changes(0) {(void) pin;}
+
+    DigitalOut & operator= (int value)
+    {
+        if ((value != 0) != (_value != 0))
+        {
+            _changes++;
+        }
+        _value = (value != 0);
+        return *this;
+    }
+
+    operator int()
+    {
+        return _value;
+    }
+
+private:
+    volatile int _value;
+    volatile uint32_t _changes;
+};
+
+// A periodic callback, run from the interrupt thread
+class Ticker
+{
+public:
+    Ticker();
+    ~Ticker();
+
+    void attach_us(Callback<void()> function, timestamp_t periodUs);
+
+    template <typename T, typename M>
+    void attach_us(T *pObject, M method, timestamp_t periodUs)
+    {
+        attach_us(Callback<void()>(pObject, method), periodUs);
+    }
+
+    void attach(Callback<void()> function, float periodSeconds)
+    {
+        attach_us(function, (timestamp_t) (periodSeconds * 1000000.0f));
+    }
+
+    void detach();
+
+    // Used by the interrupt thread
+    Callback<void()> _function;
+    timestamp_t _periodUs;
+    timestamp_t _nextUs;
+    bool _active;
+};
+
+// The base of the serial port, only here for the interrupt types
+class SerialBase
+{
+public:
+    enum IrqType
+    {
+        RxIrq = 0,
+        TxIrq,
+        IrqCnt
+    };
+};
+
+// A serial port: stdin/stdout, or a pseudo-terminal if the environment
+// variable MBED_HOST_PTY is set (its name is printed on stderr)
+class RawSerial : public SerialBase
+{
+public:
+    RawSerial(PinName tx, PinName rx);
+
+    void baud(int baudrate);
+    int readable();
+    int writeable();
+    int getc();
+    int putc(int c);
+    void attach(Callback<void()> function, IrqType type = RxIrq);
+
+    // Used by the interrupt thread
+    Callback<void()> _irq[IrqCnt];
+};
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Waits, which let the interrupt thread run
+void wait(float seconds);
+void wait_ms(int milliseconds);
+void wait_us(int microseconds);
+
+// The free-running microsecond ticker
+uint32_t us_ticker_read(void);
+
+// A free-running nanosecond counter, standing in for the DWT cycle
+// counter
+uint32_t hostCycleCount(void);
+
+// The PC of the main thread, which stands in for the code that an
+// interrupt handler interrupted and would find in its exception frame;
+// 0 if it can't be found
+uintptr_t hostInterruptedPc(void);
+
+// Sleep until the next interrupt; if interrupts are masked they are
+// unmasked while waiting, as WFI would
+void sleep(void);
+
+// Interrupt masking
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+
+// Memory barrier
+static inline void __DMB(void)
+{
+    __sync_synchronize();
+}
+
+// The "main stack pointer": the current frame address
+#define __get_MSP() ((uint32_t) (uintptr_t) __builtin_frame_address(0))
+
+// Walk the free list of the simulated application heap, calling
+// pCallback with the size of each free block
+extern "C" void hostHeapWalk(void (*pCallback)(void *pParam, size_t sizeBytes), void *pParam);
+
+// Get the bounds of the host's initialised and zero-initialised data
+// and of the simulated heap (which is itself in the latter)
+extern "C" void hostMemoryMap(char **ppDataStart, char **ppDataEnd,
+                              char **ppBssStart, char **ppBssEnd,
+                              char **ppHeapStart, char **ppHeapEnd);
+
+#endif // _MBED_HOST_H_
@@ -0,0 +1,628 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The Linux implementation of the minimal mbed API in host/mbed.h.
+
+#include "mbed.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+#include <atomic>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------
+// GENERAL COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The longest the interrupt thread waits with nothing to do
+#define HOST_IDLE_POLL_US 100000
+
+// The longest sleep() waits for an interrupt
+#define HOST_SLEEP_MAX_US 10000
+
+// The longest hostInterruptedPc() waits for the main thread to answer
+#define HOST_INTERRUPTED_PC_WAIT_US 10000
+
+// ----------------------------------------------------------------
+// GLOBAL VARIABLES
+// ----------------------------------------------------------------
+
+// A fake System Control Block: a Cortex-M0 r0p0 straight out of reset
+uint32_t gHostSystemControlBlock[] = {0x410cc200,  // CPUID
+                                      0x00000000,  // ICSR
+                                      0x00000000,  // VTOR
+                                      0xfa050000,  // AIRCR
+                                      0x00000000,  // SCR
+                                      0x00000208,  // CCR
+                                      0x00000000,  // SHPR2
+                                      0x00000000,  // SHPR3
+                                      0x00000000}; // SHCSR
+
+// The clock of the fake core, at which hostCycleCount() counts
+uint32_t SystemCoreClock = 1000000000;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Held by whoever has interrupts masked or is running a handler
+static std::mutex gIrqMutex;
+
+// Signalled each time the interrupt thread has run handlers
+static std::condition_variable gIrqCondition;
+
+// Whether this thread has masked interrupts
+static thread_local bool tIrqMasked = false;
+
+// Whether this thread is the interrupt thread running a handler
+static thread_local bool tInHandler = false;
+
+// The file descriptors used by the serial port
+static int gInFd = STDIN_FILENO;
+static int gOutFd = STDOUT_FILENO;
+
+// Set once the input has reached end of file
+static volatile bool gInEof = false;
+
+// A character read ahead by readable(), -1 if none
+static int gInLookahead = -1;
+
+// Characters are received no faster than the baud rate would allow
+static uint32_t gInCharUs = 10000000 / 9600;
+static uint32_t gInNextUs = 0;
+
+// Written to wake up the interrupt thread
+static int gWakePipe[2] = {-1, -1};
+
+// The thread that static initialisation, and so main(), runs on
+static pthread_t gMainThread = pthread_self();
+
+// The PC of the main thread, as written by its SIGPROF handler
+static std::atomic<uintptr_t> gInterruptedPc(0);
+static std::atomic<bool> gInterruptedPcValid(false);
+
+// The terminal settings to restore on exit
+static struct termios gSavedTermios;
+static bool gTermiosSaved = false;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// The tickers
+static std::vector<Ticker *> & tickers()
+{
+    static std::vector<Ticker *> tickers;
+    return tickers;
+}
+
+// The serial ports
+static std::vector<RawSerial *> & serials()
+{
+    static std::vector<RawSerial *> serials;
+    return serials;
+}
+
+// Let the fake System Control Block be some other core, given the
+// CPUID in hex in the environment variable MBED_HOST_CPUID, so that
+// the run-time choice of kernels can be exercised; an ARMv7-M core
+// gets a CCR that allows unaligned accesses, as out of reset
+static void __attribute__((constructor)) hostSetCpuid()
+{
+    const char *pCpuid = getenv("MBED_HOST_CPUID");
+
+    if (pCpuid != NULL)
+    {
+        gHostSystemControlBlock[0] = (uint32_t) strtoul(pCpuid, NULL, 16);
+        if (((gHostSystemControlBlock[0] >> 16) & 0x0f) == 0x0f)
+        {
+            gHostSystemControlBlock[5] = 0x00000200;
+        }
+    }
+}
+
+// Restore the terminal
+static void restoreTerminal()
+{
+    if (gTermiosSaved)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &gSavedTermios);
+    }
+}
+
+// Restore the terminal on a signal
+static void signalHandler(int signal)
+{
+    restoreTerminal();
+    _exit(128 + signal);
+}
+
+// Note the PC of the main thread, which SIGPROF has interrupted.
+static void interruptedPcHandler(int signal, siginfo_t *pInfo, void *pContext)
+{
+    uintptr_t pc = 0;
+
+    (void) signal;
+    (void) pInfo;
+#if defined(__x86_64__)
+    pc = (uintptr_t) ((ucontext_t *) pContext)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    pc = (uintptr_t) ((ucontext_t *) pContext)->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+    pc = (uintptr_t) ((ucontext_t *) pContext)->uc_mcontext.pc;
+#else
+    (void) pContext;
+#endif
+    gInterruptedPc = pc;
+    gInterruptedPcValid = true;
+}
+
+// Set up the console or pseudo-terminal, once
+static void hostInit()
+{
+    static bool initialised = false;
+    struct termios settings;
+    int slaveFd;
+
+    if (!initialised)
+    {
+        initialised = true;
+        setvbuf(stdout, NULL, _IONBF, 0);
+
+        if (getenv("MBED_HOST_PTY") != NULL)
+        {
+            gInFd = posix_openpt(O_RDWR | O_NOCTTY);
+            if ((gInFd >= 0) && (grantpt(gInFd) == 0) && (unlockpt(gInFd) == 0))
+            {
+                // Keep the slave open, in raw mode, so that the line
+                // discipline neither echoes nor translates anything
+                slaveFd = open(ptsname(gInFd), O_RDWR | O_NOCTTY);
+                if ((slaveFd >= 0) && (tcgetattr(slaveFd, &settings) == 0))
+                {
+                    cfmakeraw(&settings);
+                    tcsetattr(slaveFd, TCSANOW, &settings);
+                }
+                gOutFd = gInFd;
+                fprintf(stderr, "pty: %s\n", ptsname(gInFd));
+            }
+            else
+            {
+                fprintf(stderr, "Unable to open a pseudo-terminal, using stdin/stdout.\n");
+                gInFd = STDIN_FILENO;
+            }
+        }
+        else if (isatty(STDIN_FILENO) && (tcgetattr(STDIN_FILENO, &gSavedTermios) == 0))
+        {
+            // Characters should arrive one at a time and not be echoed
+            gTermiosSaved = true;
+            settings = gSavedTermios;
+            settings.c_lflag &= ~(ICANON | ECHO);
+            tcsetattr(STDIN_FILENO, TCSANOW, &settings);
+            atexit(restoreTerminal);
+            signal(SIGINT, signalHandler);
+            signal(SIGTERM, signalHandler);
+        }
+    }
+}
+
+// Take the interrupt lock unless this thread already has it
+class IrqLock
+{
+public:
+    IrqLock() : _locked(!tIrqMasked && !tInHandler)
+    {
+        if (_locked)
+        {
+            gIrqMutex.lock();
+        }
+    }
+
+    ~IrqLock()
+    {
+        if (_locked)
+        {
+            gIrqMutex.unlock();
+        }
+    }
+
+private:
+    bool _locked;
+};
+
+// Wake the interrupt thread so that it looks at things again
+static void wakeIrqThread()
+{
+    char c = 0;
+
+    if (gWakePipe[1] >= 0)
+    {
+        (void) !write(gWakePipe[1], &c, 1);
+    }
+}
+
+// The interrupt thread: run ticker and serial handlers when due
+static void irqThread()
+{
+    struct pollfd fds[2];
+    struct timespec timeout;
+    int32_t waitUs;
+    uint32_t nowUs;
+    bool rxWanted;
+    bool txWanted;
+    char buffer[16];
+
+    for (;;)
+    {
+        // Work out how long to wait and what for
+        waitUs = HOST_IDLE_POLL_US;
+        rxWanted = false;
+        txWanted = false;
+        {
+            std::lock_guard<std::mutex> lock(gIrqMutex);
+            nowUs = us_ticker_read();
+            for (size_t x = 0; x < tickers().size(); x++)
+            {
+                if (tickers()[x]->_active && ((int32_t) (tickers()[x]->_nextUs - nowUs) < waitUs))
+                {
+                    waitUs = (int32_t) (tickers()[x]->_nextUs - nowUs);
+                }
+            }
+            for (size_t x = 0; x < serials().size(); x++)
+            {
+                rxWanted = rxWanted || serials()[x]->_irq[SerialBase::RxIrq];
+                txWanted = txWanted || serials()[x]->_irq[SerialBase::TxIrq];
+            }
+        }
+        if ((waitUs < 0) || txWanted)
+        {
+            waitUs = 0;
+        }
+
+        fds[0].fd = gWakePipe[0];
+        fds[0].events = POLLIN;
+        if (rxWanted && (gInLookahead >= 0) && ((int32_t) (gInNextUs - nowUs) < waitUs))
+        {
+            waitUs = (int32_t) (gInNextUs - nowUs);
+        }
+        if (waitUs < 0)
+        {
+            waitUs = 0;
+        }
+
+        fds[1].fd = (rxWanted && !gInEof && (gInLookahead < 0)) ? gInFd : -1;
+        fds[1].events = POLLIN;
+        timeout.tv_sec = waitUs / 1000000;
+        timeout.tv_nsec = (waitUs % 1000000) * 1000;
+        if ((ppoll(fds, 2, &timeout, NULL) > 0) && (fds[0].revents & POLLIN))
+        {
+            (void) !read(gWakePipe[0], buffer, sizeof (buffer));
+        }
+
+        // Run whatever handlers are due
+        {
+            std::lock_guard<std::mutex> lock(gIrqMutex);
+            tInHandler = true;
+            nowUs = us_ticker_read();
+            for (size_t x = 0; x < tickers().size(); x++)
+            {
+                Ticker * pTicker = tickers()[x];
+                if (pTicker->_active && ((int32_t) (nowUs - pTicker->_nextUs) >= 0))
+                {
+                    pTicker->_nextUs += pTicker->_periodUs;
+                    pTicker->_function.call();
+                }
+            }
+            for (size_t x = 0; x < serials().size(); x++)
+            {
+                if (serials()[x]->_irq[SerialBase::RxIrq] && serials()[x]->readable())
+                {
+                    serials()[x]->_irq[SerialBase::RxIrq].call();
+                }
+                if (serials()[x]->_irq[SerialBase::TxIrq])
+                {
+                    serials()[x]->_irq[SerialBase::TxIrq].call();
+                }
+            }
+            tInHandler = false;
+        }
+        gIrqCondition.notify_all();
+    }
+}
+
+// Start the interrupt thread, once
+static void startIrqThread()
+{
+    static std::once_flag once;
+
+    std::call_once(once, []()
+    {
+        if (pipe(gWakePipe) == 0)
+        {
+            fcntl(gWakePipe[0], F_SETFL, O_NONBLOCK);
+            fcntl(gWakePipe[1], F_SETFL, O_NONBLOCK);
+        }
+        std::thread(irqThread).detach();
+    });
+}
+
+// ----------------------------------------------------------------
+// TICKER
+// ----------------------------------------------------------------
+
+Ticker::Ticker() : _periodUs(0), _nextUs(0), _active(false)
+{
+    IrqLock lock;
+    tickers().push_back(this);
+}
+
+Ticker::~Ticker()
+{
+    IrqLock lock;
+    for (size_t x = 0; x < tickers().size(); x++)
+    {
+        if (tickers()[x] == this)
+        {
+            tickers().erase(tickers().begin() + x);
+            break;
+        }
+    }
+}
+
+void Ticker::attach_us(Callback<void()> function, timestamp_t periodUs)
+{
+    startIrqThread();
+    {
+        IrqLock lock;
+        _function = function;
+        _periodUs = periodUs;
+        _nextUs = us_ticker_read() + periodUs;
+        _active = true;
+    }
+    wakeIrqThread();
+}
+
+void Ticker::detach()
+{
+    IrqLock lock;
+    _active = false;
+}
+
+// ----------------------------------------------------------------
+// RAW SERIAL
+// ----------------------------------------------------------------
+
+RawSerial::RawSerial(PinName tx, PinName rx)
+{
+    (void) tx;
+    (void) rx;
+    hostInit();
+    IrqLock lock;
+    serials().push_back(this);
+}
+
+void RawSerial::baud(int baudrate)
+{
+    if (baudrate > 0)
+    {
+        gInCharUs = 10000000 / baudrate;
+    }
+}
+
+int RawSerial::readable()
+{
+    struct pollfd fd;
+    unsigned char c;
+
+    // Read a character ahead since poll() also reports end of file
+    if ((gInLookahead < 0) && !gInEof)
+    {
+        fd.fd = gInFd;
+        fd.events = POLLIN;
+        if ((poll(&fd, 1, 0) > 0) && (fd.revents & (POLLIN | POLLHUP)))
+        {
+            if (read(gInFd, &c, 1) == 1)
+            {
+                gInLookahead = c;
+            }
+            else
+            {
+                gInEof = true;
+            }
+        }
+    }
+
+    return (gInLookahead >= 0) && ((int32_t) (us_ticker_read() - gInNextUs) >= 0);
+}
+
+int RawSerial::writeable()
+{
+    return 1;
+}
+
+int RawSerial::getc()
+{
+    int c = -1;
+
+    // Block until there is something, as on the target
+    while (!readable() && ((gInLookahead >= 0) || !gInEof))
+    {
+        wait_us(100);
+    }
+
+    if (gInLookahead >= 0)
+    {
+        c = gInLookahead;
+        gInLookahead = -1;
+        gInNextUs = us_ticker_read() + gInCharUs;
+    }
+
+    return c;
+}
+
+int RawSerial::putc(int c)
+{
+    unsigned char x = (unsigned char) c;
+
+    return (write(gOutFd, &x, 1) == 1) ? c : -1;
+}
+
+void RawSerial::attach(Callback<void()> function, IrqType type)
+{
+    if (type < IrqCnt)
+    {
+        startIrqThread();
+        {
+            IrqLock lock;
+            _irq[type] = function;
+        }
+        wakeIrqThread();
+    }
+}
+
+// ----------------------------------------------------------------
+// TIME
+// ----------------------------------------------------------------
+
+uint32_t us_ticker_read()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+uintptr_t hostInterruptedPc()
+{
+    static bool handlerInstalled = false;
+    struct sigaction action;
+    uint32_t startUs;
+
+    if (!handlerInstalled)
+    {
+        // SA_RESTART so that the main thread's system calls carry on
+        memset(&action, 0, sizeof (action));
+        action.sa_sigaction = interruptedPcHandler;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        handlerInstalled = (sigaction(SIGPROF, &action, NULL) == 0);
+    }
+
+    gInterruptedPcValid = false;
+    if (handlerInstalled && !pthread_equal(pthread_self(), gMainThread) &&
+        (pthread_kill(gMainThread, SIGPROF) == 0))
+    {
+        startUs = us_ticker_read();
+        while (!gInterruptedPcValid && (us_ticker_read() - startUs < HOST_INTERRUPTED_PC_WAIT_US))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    return gInterruptedPcValid ? gInterruptedPc.load() : 0;
+}
+
+uint32_t hostCycleCount()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void wait(float seconds)
+{
+    wait_us((int) (seconds * 1000000.0f));
+}
+
+void wait_ms(int milliseconds)
+{
+    wait_us(milliseconds * 1000);
+}
+
+void wait_us(int microseconds)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+}
+
+// ----------------------------------------------------------------
+// INTERRUPTS
+// ----------------------------------------------------------------
+
+void sleep()
+{
+    if (!tInHandler)
+    {
+        if (tIrqMasked)
+        {
+            // Waiting releases the lock, just as WFI lets a pending
+            // interrupt through
+            std::unique_lock<std::mutex> lock(gIrqMutex, std::adopt_lock);
+            gIrqCondition.wait_for(lock, std::chrono::microseconds(HOST_SLEEP_MAX_US));
+            lock.release();
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(gIrqMutex);
+            gIrqCondition.wait_for(lock, std::chrono::microseconds(HOST_SLEEP_MAX_US));
+        }
+    }
+}
+
+void __disable_irq()
+{
+    if (!tInHandler && !tIrqMasked)
+    {
+        gIrqMutex.lock();
+        tIrqMasked = true;
+    }
+}
+
+void __enable_irq()
+{
+    if (!tInHandler && tIrqMasked)
+    {
+        tIrqMasked = false;
+        gIrqMutex.unlock();
+    }
+}
+
+uint32_t __get_PRIMASK()
+{
+    return tIrqMasked ? 1 : 0;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    if (priMask & 1)
+    {
+        __disable_irq();
+    }
+    else
+    {
+        __enable_irq();
+    }
+}
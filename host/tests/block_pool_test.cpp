@@ -0,0 +1,110 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test the fixed-size block pools: allocation to exhaustion, the
+// statistics, the rejection of foreign blocks and check().
+
+#include "mbed.h"
+#include "block_pool.h"
+#include "host_test.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the blocks in the pool under test, not a multiple of
+// the alignment
+#define BLOCK_SIZE_BYTES 20
+
+// The number of blocks in the pool under test
+#define NUM_BLOCKS 5
+
+// ----------------------------------------------------------------
+// VARIABLES
+// ----------------------------------------------------------------
+
+// The pool under test
+static BlockPool<BLOCK_SIZE_BYTES, NUM_BLOCKS> gPool("test");
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(void)
+{
+    BlockPoolStats_t stats;
+    void *pBlocks[NUM_BLOCKS];
+    bool found = false;
+
+    for (BlockPoolBase *pPool = BlockPoolBase::first(); pPool != NULL; pPool = pPool->next())
+    {
+        found = found || (pPool == &gPool);
+    }
+    HOST_TEST_CHECK(found);
+    HOST_TEST_CHECK(gPool.check());
+
+    // Take every block: each must be aligned, inside the pool and
+    // clear of the others
+    for (uint32_t x = 0; x < NUM_BLOCKS; x++)
+    {
+        pBlocks[x] = gPool.alloc();
+        HOST_TEST_CHECK(pBlocks[x] != NULL);
+        HOST_TEST_CHECK(gPool.contains(pBlocks[x]));
+        HOST_TEST_CHECK(((uintptr_t) pBlocks[x] & (BLOCK_POOL_ALIGNMENT - 1)) == 0);
+        for (uint32_t y = 0; y < x; y++)
+        {
+            HOST_TEST_CHECK(((char *) pBlocks[x] >= (char *) pBlocks[y] + BLOCK_SIZE_BYTES) ||
+                            ((char *) pBlocks[y] >= (char *) pBlocks[x] + BLOCK_SIZE_BYTES));
+        }
+        memset(pBlocks[x], 0xa5, BLOCK_SIZE_BYTES);
+    }
+    HOST_TEST_CHECK(gPool.alloc() == NULL);
+    HOST_TEST_CHECK(gPool.check());
+
+    gPool.getStats(&stats);
+    HOST_TEST_CHECK(stats.numBlocks == NUM_BLOCKS);
+    HOST_TEST_CHECK(stats.blockSizeBytes == BLOCK_SIZE_BYTES);
+    HOST_TEST_CHECK(stats.numUsed == NUM_BLOCKS);
+    HOST_TEST_CHECK(stats.peakUsed == NUM_BLOCKS);
+    HOST_TEST_CHECK(stats.numFailures == 1);
+
+    // Things that aren't blocks of this pool are refused
+    HOST_TEST_CHECK(gPool.free(NULL));
+    HOST_TEST_CHECK(!gPool.free(&stats));
+    HOST_TEST_CHECK(!gPool.free((char *) pBlocks[0] + 1));
+
+    for (uint32_t x = 0; x < NUM_BLOCKS; x++)
+    {
+        HOST_TEST_CHECK(gPool.free(pBlocks[x]));
+    }
+    HOST_TEST_CHECK(gPool.check());
+
+    // check() leaves the statistics alone
+    gPool.getStats(&stats);
+    HOST_TEST_CHECK(stats.numUsed == 0);
+    HOST_TEST_CHECK(stats.peakUsed == NUM_BLOCKS);
+    HOST_TEST_CHECK(stats.numFailures == 1);
+
+    // A block freed twice makes the free list endless, which check()
+    // must notice rather than hang
+    pBlocks[0] = gPool.alloc();
+    HOST_TEST_CHECK(gPool.free(pBlocks[0]));
+    HOST_TEST_CHECK(gPool.free(pBlocks[0]));
+    HOST_TEST_CHECK(!gPool.check());
+
+    return hostTestResult("block_pool_test");
+}
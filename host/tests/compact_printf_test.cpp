@@ -0,0 +1,122 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test the compact formatter against the C library's snprintf(): the
+// conversions, flags and widths it handles, signs and limits, and
+// truncation to the size of the buffer, including sizing a format
+// with compactSnprintf(NULL, 0, ...).
+
+#include <limits.h>
+#include "mbed.h"
+#include "compact_printf.h"
+#include "host_test.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the buffers that the output is compared in
+#define BUFFER_CHARS 128
+
+// ----------------------------------------------------------------
+// VARIABLES
+// ----------------------------------------------------------------
+
+// The buffers that the two format into
+static char gExpected[BUFFER_CHARS];
+static char gActual[BUFFER_CHARS];
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Check that a format comes out as snprintf() would have it, both in
+// full and truncated to every size of buffer up to one more than it
+// needs (sized to none, the buffer is not even touched).
+#define CHECK_FORMAT(...)                                                            \
+    do                                                                               \
+    {                                                                                \
+        int expectedCount = snprintf(gExpected, sizeof (gExpected), __VA_ARGS__);    \
+        int actualCount = compactSnprintf(gActual, sizeof (gActual), __VA_ARGS__);   \
+        if ((actualCount != expectedCount) || (strcmp(gActual, gExpected) != 0))     \
+        {                                                                            \
+            printf("Format \"%s\": expected \"%s\" (%d), got \"%s\" (%d).\n",        \
+                   #__VA_ARGS__, gExpected, expectedCount, gActual, actualCount);    \
+        }                                                                            \
+        HOST_TEST_CHECK(actualCount == expectedCount);                               \
+        HOST_TEST_CHECK(strcmp(gActual, gExpected) == 0);                            \
+        HOST_TEST_CHECK(compactSnprintf(NULL, 0, __VA_ARGS__) == expectedCount);     \
+        for (int size = 1; size <= expectedCount + 1; size++)                        \
+        {                                                                            \
+            memset(gActual, '#', sizeof (gActual));                                  \
+            snprintf(gExpected, size, __VA_ARGS__);                                  \
+            HOST_TEST_CHECK(compactSnprintf(gActual, size, __VA_ARGS__) == expectedCount); \
+            HOST_TEST_CHECK(strcmp(gActual, gExpected) == 0);                        \
+            HOST_TEST_CHECK(gActual[size] == '#');                                   \
+        }                                                                            \
+    } while (0)
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(void)
+{
+    const char *pString = "string";
+    // Volatile, so that the compiler doesn't warn about it
+    const char * volatile pNull = NULL;
+    int local = 0;
+
+    // Literal text
+    CHECK_FORMAT("No conversions at all.");
+    CHECK_FORMAT("100%% and %%%% too.");
+
+    // Signed, with limits and signs
+    CHECK_FORMAT("%d %i %d %d", 0, 42, -42, 7);
+    CHECK_FORMAT("%d %d", INT_MAX, INT_MIN);
+    CHECK_FORMAT("%ld %ld %ld", 0L, LONG_MAX, LONG_MIN);
+
+    // Unsigned and hex
+    CHECK_FORMAT("%u %u %lu %lu", 0U, UINT_MAX, 0UL, ULONG_MAX);
+    CHECK_FORMAT("%x %X %x %lx %lX", 0U, 0xabcdefU, UINT_MAX, 0x1234abcdUL, ULONG_MAX);
+    CHECK_FORMAT("0x%08x 0x%08lX", 0x1fU, 0xdeadUL);
+
+    // Characters, strings and pointers
+    CHECK_FORMAT("[%c%c%c]", 'a', ' ', 'Z');
+    CHECK_FORMAT("[%s] [%s] [%s]", pString, "", pNull);
+    CHECK_FORMAT("%p", (void *) &local);
+
+    // Width and the '-' and '0' flags
+    CHECK_FORMAT("[%5d] [%-5d] [%05d]", 42, 42, 42);
+    CHECK_FORMAT("[%5d] [%-5d] [%05d]", -42, -42, -42);
+    CHECK_FORMAT("[%3d] [%03d] [%1d] [%01d]", -12345, 12345, -7, 0);
+    CHECK_FORMAT("[%8u] [%-8u] [%08lu]", 123U, 123U, 4000000000UL);
+    CHECK_FORMAT("[%8x] [%-8X] [%08x]", 0xabcU, 0xabcU, 0xabcU);
+    CHECK_FORMAT("[%10s] [%-10s] [%2s]", pString, pString, pString);
+    CHECK_FORMAT("[%3c] [%-3c]", 'x', 'y');
+    CHECK_FORMAT("[%20p] [%-20p]", (void *) &local, (void *) &local);
+    CHECK_FORMAT("[%40d] [%-40s]", 1, pString);
+
+    // Formats taken from this application
+    CHECK_FORMAT("*** Heap has %d byte(s) free in %lu block(s), largest %d byte(s), %lu%% fragmented.\n",
+                 16384, 1UL, 16384, 0UL);
+    CHECK_FORMAT("    %-8s %-18s %10lu %s, %lu kbytes/s.\n", "ARMv7-M", "memcpy() aligned", 123456UL, "cycles", 789UL);
+    CHECK_FORMAT("!!! RAM check failure at location 0x%08lx (expected 0x%08lx, contents 0x%08lx).\n",
+                 0x20001000UL, 0xffffffffUL, 0xfffffffeUL);
+
+    return hostTestResult("compact_printf_test");
+}
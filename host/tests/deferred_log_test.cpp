@@ -0,0 +1,122 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test deferred logging: what DEFERRED_LOG_FLUSH() prints must be what
+// printf() would have printed at the time, whatever the types of the
+// arguments; only built into the application with DEFERRED_LOGGING.
+
+#include <inttypes.h>
+#include <unistd.h>
+#include "mbed.h"
+#include "deferred_log.h"
+#include "host_test.h"
+
+#ifdef DEFERRED_LOGGING
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the buffers that the output is compared in
+#define OUTPUT_BUFFER_CHARS 1024
+
+// ----------------------------------------------------------------
+// VARIABLES
+// ----------------------------------------------------------------
+
+// What printf() would have printed
+static char gExpected[OUTPUT_BUFFER_CHARS];
+static size_t gExpectedLength = 0;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Log a message and add what printf() would print to gExpected.
+#define LOG(...)                                                                      \
+    do                                                                                \
+    {                                                                                 \
+        DEFERRED_LOG(__VA_ARGS__);                                                    \
+        gExpectedLength += snprintf(gExpected + gExpectedLength,                      \
+                                    sizeof (gExpected) - gExpectedLength, __VA_ARGS__); \
+    } while (0)
+
+// Flush the log with stdout going to a file and return what was
+// printed in pBuf.
+static size_t flushToBuffer(char *pBuf, size_t size)
+{
+    FILE *pFile = tmpfile();
+    int savedStdout;
+    size_t length = 0;
+
+    if (pFile != NULL)
+    {
+        fflush(stdout);
+        savedStdout = dup(STDOUT_FILENO);
+        dup2(fileno(pFile), STDOUT_FILENO);
+        DEFERRED_LOG_FLUSH();
+        fflush(stdout);
+        dup2(savedStdout, STDOUT_FILENO);
+        close(savedStdout);
+        rewind(pFile);
+        length = fread(pBuf, 1, size - 1, pFile);
+        fclose(pFile);
+    }
+    pBuf[length] = '\0';
+
+    return length;
+}
+
+#endif
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(void)
+{
+#ifdef DEFERRED_LOGGING
+    char printed[OUTPUT_BUFFER_CHARS];
+    const char *pString = "string";
+    int32_t negative = -1234567;
+    uint32_t big = 0xfedcba98;
+    long longNegative = -42;
+    unsigned long longBig = 4000000000UL;
+
+    LOG("No arguments, 100%% literal text that runs on for longer than one piece of it.\n");
+    LOG("%d %i %u %x %X %c.\n", (int) negative, -1, 4000000000U, 0xbeefU, 0xcafeU, 'z');
+    LOG("%" PRId32 " %" PRIu32 " 0x%08" PRIx32 " %ld %lu.\n", negative, big, big, longNegative, longBig);
+    LOG("[%-8s] [%8s] [%5d] [%-5d] [%05d] [%p].\n", pString, pString, -12, 34, -56, (void *) pString);
+    LOG("%d %d %d %d %d %d %d %d\n", 1, -2, 3, -4, 5, -6, 7, -8);
+    LOG("Ends in a conversion: %s", "done\n");
+
+    flushToBuffer(printed, sizeof (printed));
+    HOST_TEST_CHECK(strcmp(printed, gExpected) == 0);
+    if (strcmp(printed, gExpected) != 0)
+    {
+        printf("Expected:\n%sPrinted:\n%s", gExpected, printed);
+    }
+
+    // Nothing is left
+    flushToBuffer(printed, sizeof (printed));
+    HOST_TEST_CHECK(printed[0] == '\0');
+#else
+    printf("Deferred logging is only built in with DEFERRED_LOGGING defined.\n");
+#endif
+
+    return hostTestResult("deferred_log_test");
+}
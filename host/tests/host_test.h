@@ -0,0 +1,51 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+// The little there is to the host tests: each is a program whose
+// main() runs its checks and returns hostTestResult(), non-zero if
+// any check failed.
+
+#include <stdio.h>
+
+// The number of checks that have failed
+static int gHostTestFailures = 0;
+
+// Check that a condition holds, printing where it didn't
+#define HOST_TEST_CHECK(condition)                                  \
+    do                                                              \
+    {                                                               \
+        if (!(condition))                                           \
+        {                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                   #condition);                                     \
+            gHostTestFailures++;                                    \
+        }                                                           \
+    } while (0)
+
+// Print the outcome of the test called pName and return what main()
+// should.
+static inline int hostTestResult(const char *pName)
+{
+    printf("%s: %s, %d failure(s).\n", pName, (gHostTestFailures == 0) ? "PASS" : "FAIL", gHostTestFailures);
+
+    return (gHostTestFailures == 0) ? 0 : 1;
+}
+
+#endif // _HOST_TEST_H_
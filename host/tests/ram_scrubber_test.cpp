@@ -0,0 +1,138 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Run the background RAM scrubber over this program's own .data and
+// .bss, which hold the simulated heap, calling its slices directly from
+// main() (no ticker, so no interrupt thread runs alongside), and check
+// that nothing fails and that what was in RAM is still there afterwards.
+
+#include <inttypes.h>
+#include "mbed.h"
+#include "ram_scrubber.h"
+#include "host_test.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of complete sweeps to run
+#define NUM_SWEEPS 2
+
+// The number of words in the sentinel buffers
+#define SENTINEL_NUM_WORDS 1024
+
+// ----------------------------------------------------------------
+// EXTERNAL SYMBOLS
+// ----------------------------------------------------------------
+
+// Provided by the host linker
+extern "C" char __data_start[];
+extern "C" char _edata[];
+extern "C" char __bss_start[];
+extern "C" char _end[];
+
+// ----------------------------------------------------------------
+// VARIABLES
+// ----------------------------------------------------------------
+
+// A sentinel in .data
+static uint32_t gDataSentinel[SENTINEL_NUM_WORDS] = {0x5a5a5a5a};
+
+// A sentinel in .bss
+static uint32_t gBssSentinel[SENTINEL_NUM_WORDS];
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Add a region, word aligned, to the list.
+static void addRegion(RamScrubberRegion_t *pRegions, uint32_t *pNumRegions,
+                      char *pStart, char *pEnd)
+{
+    uintptr_t start = ((uintptr_t) pStart + sizeof (uint32_t) - 1) & ~(sizeof (uint32_t) - 1);
+    uintptr_t end = (uintptr_t) pEnd & ~(sizeof (uint32_t) - 1);
+
+    if (end > start)
+    {
+        pRegions[*pNumRegions].pStart = (uint32_t *) start;
+        pRegions[*pNumRegions].sizeBytes = end - start;
+        (*pNumRegions)++;
+    }
+}
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(void)
+{
+    RamScrubberRegion_t regions[2];
+    uint32_t numRegions = 0;
+    RamScrubberStatus_t status;
+    uint32_t *pHeapSentinel;
+    uint32_t numBadSlices = 0;
+    uint32_t numBad = 0;
+
+    // Something in each of .data, .bss and the heap to look at afterwards
+    pHeapSentinel = (uint32_t *) malloc(SENTINEL_NUM_WORDS * sizeof (uint32_t));
+    HOST_TEST_CHECK(pHeapSentinel != NULL);
+    for (uint32_t x = 0; x < SENTINEL_NUM_WORDS; x++)
+    {
+        gDataSentinel[x] = x * 0x9e3779b9;
+        gBssSentinel[x] = ~gDataSentinel[x];
+        pHeapSentinel[x] = gDataSentinel[x] ^ 0xa5a5a5a5;
+    }
+
+    addRegion(regions, &numRegions, __data_start, _edata);
+    addRegion(regions, &numRegions, __bss_start, _end);
+
+    // A short period so that the test doesn't take many slices
+    HOST_TEST_CHECK(ramScrubberInit(regions, numRegions, 1, 1000));
+    ramScrubberGetStatus(&status);
+    HOST_TEST_CHECK(status.totalWords > 3 * SENTINEL_NUM_WORDS);
+    HOST_TEST_CHECK((status.wordsPerSlice > 0) && (status.wordsPerSlice <= RAM_SCRUBBER_MAX_WORDS_PER_SLICE));
+
+    do
+    {
+        if (!ramScrubberSlice())
+        {
+            numBadSlices++;
+        }
+        ramScrubberGetStatus(&status);
+    } while ((status.sweepsCompleted < NUM_SWEEPS) && (numBadSlices == 0));
+
+    HOST_TEST_CHECK(numBadSlices == 0);
+    HOST_TEST_CHECK(status.numFailures == 0);
+    HOST_TEST_CHECK(status.pFirstFailure == NULL);
+    HOST_TEST_CHECK(status.numSlices >= NUM_SWEEPS * status.totalWords / status.wordsPerSlice);
+
+    for (uint32_t x = 0; x < SENTINEL_NUM_WORDS; x++)
+    {
+        if ((gDataSentinel[x] != x * 0x9e3779b9) || (gBssSentinel[x] != ~gDataSentinel[x]) ||
+            (pHeapSentinel[x] != (gDataSentinel[x] ^ 0xa5a5a5a5)))
+        {
+            numBad++;
+        }
+    }
+    HOST_TEST_CHECK(numBad == 0);
+
+    free(pHeapSentinel);
+    printf("%" PRIu32 " word(s) scrubbed %" PRIu32 " time(s) in %" PRIu32 " slice(s).\n",
+           status.totalWords, status.sweepsCompleted, status.numSlices);
+
+    return hostTestResult("ram_scrubber_test");
+}
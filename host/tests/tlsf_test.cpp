@@ -0,0 +1,289 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test the TLSF allocator: the limit on the size of a pool and a long
+// random sequence of allocations, frees and reallocations, checking
+// the alignment, bounds and contents of every block as it goes.
+
+#include <inttypes.h>
+#include "mbed.h"
+#include "tlsf.h"
+#include "host_test.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of the pool for the random test
+#define RANDOM_POOL_BYTES (32 * 1024)
+
+// The number of blocks the random test keeps track of
+#define RANDOM_NUM_BLOCKS 64
+
+// The largest block the random test asks for
+#define RANDOM_MAX_BLOCK_BYTES 4096
+
+// The number of operations in the random test
+#define RANDOM_NUM_OPERATIONS 200000
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A block allocated by the random test
+typedef struct
+{
+    uint8_t * pMem;
+    size_t sizeBytes;
+    uint8_t seed;              // The first byte of the pattern it holds
+} RandomBlock_t;
+
+// ----------------------------------------------------------------
+// VARIABLES
+// ----------------------------------------------------------------
+
+// The pool, big enough for the largest that tlsfInit() may accept
+static uint8_t gPool[((size_t) 1 << TLSF_FL_INDEX_MAX) + 8 * TLSF_ALIGN_SIZE] __attribute__ ((aligned (TLSF_ALIGN_SIZE)));
+
+// The blocks of the random test
+static RandomBlock_t gBlocks[RANDOM_NUM_BLOCKS];
+
+// The state of the random number generator
+static uint32_t gRandom = 1;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Return a pseudo-random number, the same sequence every run.
+static uint32_t randomNumber()
+{
+    gRandom = gRandom * 1103515245 + 12345;
+    return gRandom >> 8;
+}
+
+// Fill a block with its pattern.
+static void fillBlock(const RandomBlock_t *pBlock)
+{
+    for (size_t x = 0; x < pBlock->sizeBytes; x++)
+    {
+        pBlock->pMem[x] = (uint8_t) (pBlock->seed + x);
+    }
+}
+
+// Return true if the first numBytes of a block hold its pattern.
+static bool checkBlock(const RandomBlock_t *pBlock, size_t numBytes)
+{
+    for (size_t x = 0; x < numBytes; x++)
+    {
+        if (pBlock->pMem[x] != (uint8_t) (pBlock->seed + x))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Return true if a newly (re)allocated block is aligned, inside the
+// pool, big enough and clear of every other block.
+static bool checkPlacement(uint32_t index, const uint8_t *pPool, size_t poolBytes)
+{
+    const RandomBlock_t *pBlock = &gBlocks[index];
+
+    if ((((uintptr_t) pBlock->pMem & (TLSF_ALIGN_SIZE - 1)) != 0) ||
+        (pBlock->pMem < pPool) || (pBlock->pMem + pBlock->sizeBytes > pPool + poolBytes) ||
+        (tlsfBlockSize(pBlock->pMem) < pBlock->sizeBytes))
+    {
+        return false;
+    }
+    for (uint32_t x = 0; x < RANDOM_NUM_BLOCKS; x++)
+    {
+        if ((x != index) && (gBlocks[x].pMem != NULL) &&
+            (pBlock->pMem < gBlocks[x].pMem + gBlocks[x].sizeBytes) &&
+            (gBlocks[x].pMem < pBlock->pMem + pBlock->sizeBytes))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Count the blocks in use, for tlsfWalk().
+static void countUsed(void *pParam, void *pMem, size_t sizeBytes, bool used)
+{
+    (void) pMem;
+    (void) sizeBytes;
+
+    if (used)
+    {
+        (*(uint32_t *) pParam)++;
+    }
+}
+
+// Check that a pool of sizeBytes is accepted, or not, and that if it
+// is a block can be carved out of it and merged back again.
+static void testPoolSize(size_t sizeBytes, bool accepted)
+{
+    Tlsf_t tlsf;
+    TlsfStats_t stats;
+    void *pMem;
+
+    HOST_TEST_CHECK(tlsfInit(&tlsf, gPool, sizeBytes) == accepted);
+    if (accepted)
+    {
+        tlsfGetStats(&tlsf, &stats);
+        HOST_TEST_CHECK(stats.numFreeBlocks == 1);
+        HOST_TEST_CHECK(stats.largestFreeBytes < ((size_t) 1 << TLSF_FL_INDEX_MAX));
+        pMem = tlsfMalloc(&tlsf, stats.largestFreeBytes / 2);
+        HOST_TEST_CHECK(pMem != NULL);
+        tlsfFree(&tlsf, pMem);
+        tlsfGetStats(&tlsf, &stats);
+        HOST_TEST_CHECK(stats.numFreeBlocks == 1);
+        HOST_TEST_CHECK(stats.usedBytes == 0);
+    }
+}
+
+// The limits on the size of a pool.
+static void testPoolLimits()
+{
+    size_t maxBytes = (size_t) 1 << TLSF_FL_INDEX_MAX;
+
+    HOST_TEST_CHECK(!tlsfInit(NULL, gPool, sizeof (gPool)));
+    testPoolSize(0, false);
+    testPoolSize(TLSF_ALIGN_SIZE * 2, false);
+    testPoolSize(TLSF_ALIGN_SIZE * 8, true);
+    // A pool whose one free block would be exactly 2^TLSF_FL_INDEX_MAX
+    // bytes would index past the end of the first-level lists
+    testPoolSize(maxBytes + 2 * TLSF_ALIGN_SIZE, false);
+    testPoolSize(maxBytes + 2 * TLSF_ALIGN_SIZE + 1, false);
+    testPoolSize(sizeof (gPool), false);
+    testPoolSize(maxBytes + TLSF_ALIGN_SIZE, true);
+    testPoolSize(maxBytes, true);
+}
+
+// A random sequence of allocations, frees and reallocations.
+static void testRandom()
+{
+    Tlsf_t tlsf;
+    TlsfStats_t stats;
+    size_t initialFreeBytes;
+    RandomBlock_t *pBlock;
+    uint8_t *pMem;
+    size_t sizeBytes;
+    uint32_t numLive = 0;
+    uint32_t numUsed;
+    uint32_t numBadPlacements = 0;
+    uint32_t numBadContents = 0;
+    uint32_t numFailures = 0;
+    uint32_t index;
+
+    HOST_TEST_CHECK(tlsfInit(&tlsf, gPool, RANDOM_POOL_BYTES));
+    tlsfGetStats(&tlsf, &stats);
+    initialFreeBytes = stats.freeBytes;
+
+    for (uint32_t x = 0; x < RANDOM_NUM_OPERATIONS; x++)
+    {
+        index = randomNumber() % RANDOM_NUM_BLOCKS;
+        pBlock = &gBlocks[index];
+        // Mostly small blocks, with the odd big one
+        sizeBytes = (randomNumber() % 8 == 0) ? randomNumber() % RANDOM_MAX_BLOCK_BYTES + 1 : randomNumber() % 64 + 1;
+
+        if (pBlock->pMem == NULL)
+        {
+            pBlock->pMem = (uint8_t *) tlsfMalloc(&tlsf, sizeBytes);
+            if (pBlock->pMem != NULL)
+            {
+                pBlock->sizeBytes = sizeBytes;
+                pBlock->seed = (uint8_t) x;
+                numBadPlacements += checkPlacement(index, gPool, RANDOM_POOL_BYTES) ? 0 : 1;
+                fillBlock(pBlock);
+                numLive++;
+            }
+            else
+            {
+                numFailures++;
+            }
+        }
+        else
+        {
+            numBadContents += checkBlock(pBlock, pBlock->sizeBytes) ? 0 : 1;
+            if (randomNumber() % 2 == 0)
+            {
+                tlsfFree(&tlsf, pBlock->pMem);
+                pBlock->pMem = NULL;
+                numLive--;
+            }
+            else
+            {
+                pMem = (uint8_t *) tlsfRealloc(&tlsf, pBlock->pMem, sizeBytes);
+                if (pMem != NULL)
+                {
+                    pBlock->pMem = pMem;
+                    numBadContents += checkBlock(pBlock, (sizeBytes < pBlock->sizeBytes) ? sizeBytes : pBlock->sizeBytes) ? 0 : 1;
+                    pBlock->sizeBytes = sizeBytes;
+                    numBadPlacements += checkPlacement(index, gPool, RANDOM_POOL_BYTES) ? 0 : 1;
+                    fillBlock(pBlock);
+                }
+                else
+                {
+                    // The block is left alone
+                    numBadContents += checkBlock(pBlock, pBlock->sizeBytes) ? 0 : 1;
+                    numFailures++;
+                }
+            }
+        }
+
+        if (x % 1000 == 0)
+        {
+            numUsed = 0;
+            tlsfWalk(&tlsf, countUsed, &numUsed);
+            HOST_TEST_CHECK(numUsed == numLive);
+        }
+    }
+
+    HOST_TEST_CHECK(numBadPlacements == 0);
+    HOST_TEST_CHECK(numBadContents == 0);
+
+    for (uint32_t x = 0; x < RANDOM_NUM_BLOCKS; x++)
+    {
+        tlsfFree(&tlsf, gBlocks[x].pMem);
+        gBlocks[x].pMem = NULL;
+    }
+
+    // Everything should have merged back into one block
+    tlsfGetStats(&tlsf, &stats);
+    HOST_TEST_CHECK(stats.usedBytes == 0);
+    HOST_TEST_CHECK(stats.numFreeBlocks == 1);
+    HOST_TEST_CHECK(stats.freeBytes == initialFreeBytes);
+
+    printf("%d operation(s), %" PRIu32 " malloc(s), %" PRIu32 " free(s), %" PRIu32 " failure(s), peak %d byte(s) used.\n",
+           RANDOM_NUM_OPERATIONS, stats.numMallocs, stats.numFrees, numFailures, (int) stats.peakUsedBytes);
+}
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(void)
+{
+    testPoolLimits();
+    testRandom();
+
+    return hostTestResult("tlsf_test");
+}
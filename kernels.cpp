@@ -0,0 +1,395 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "kernels.h"
+#include "cpu_info.h"
+#include "cycle_counter.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of times each kernel is run by kernelsBenchmark()
+#ifndef KERNELS_BENCHMARK_ITERATIONS
+# define KERNELS_BENCHMARK_ITERATIONS 4
+#endif
+
+// The reflected IEEE 802.3 polynomial and the CRC-32 of the nine
+// ASCII digits "123456789", the usual check value
+#define KERNELS_CRC32_CHECK_STRING "123456789"
+#define KERNELS_CRC32_CHECK_VALUE 0xcbf43926
+
+// GCC spots byte and word copy loops and turns them into calls to
+// memcpy(), which would defeat the point of the kernels
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__ARMCC_VERSION)
+# define KERNELS_NO_LIBCALLS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+# define KERNELS_NO_LIBCALLS
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A set of the kernels below
+typedef struct
+{
+    const char * pName;
+    void * (*pMemcpy)(void *pDst, const void *pSrc, size_t sizeBytes);
+    uint32_t (*pCrc32)(uint32_t crc, const void *pBuf, size_t sizeBytes);
+} Kernels_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The CRC-32 of each byte value
+static const uint32_t gCrc32Table[256] = {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Whether this is a little-endian core
+static bool isLittleEndian()
+{
+    uint32_t x = 1;
+
+    return *(uint8_t *) &x == 1;
+}
+
+// Load a word from an address that need not be aligned, which only
+// ARMv7-M can do in one instruction.
+static inline uint32_t loadUnaligned(const uint8_t *pSrc)
+{
+    uint32_t word;
+
+#if defined(__GNUC__) && defined(__arm__) && !defined(__ARMCC_VERSION)
+    // A plain LDR: told that the address may be unaligned, the
+    // compiler would split it into four byte loads
+    asm ("ldr %0, [%1]" : "=l" (word) : "l" (pSrc), "m" (*(const uint8_t (*)[4]) pSrc));
+#else
+    // The compiler makes this a single load wherever that is allowed
+    memcpy(&word, pSrc, sizeof (word));
+#endif
+
+    return word;
+}
+
+// Copy using aligned accesses only: words when the source and
+// destination are equally aligned, bytes otherwise.
+static KERNELS_NO_LIBCALLS void * memcpyArmv6m(void *pDst, const void *pSrc, size_t sizeBytes)
+{
+    uint8_t *pD = (uint8_t *) pDst;
+    const uint8_t *pS = (const uint8_t *) pSrc;
+    uint32_t *pDWord;
+    const uint32_t *pSWord;
+
+    if ((((uintptr_t) pD ^ (uintptr_t) pS) & (sizeof (uint32_t) - 1)) == 0)
+    {
+        // Bytes up to a word boundary, then words, four at a time
+        // while there are enough
+        for (; (sizeBytes > 0) && (((uintptr_t) pD & (sizeof (uint32_t) - 1)) != 0); sizeBytes--)
+        {
+            *pD++ = *pS++;
+        }
+        pDWord = (uint32_t *) pD;
+        pSWord = (const uint32_t *) pS;
+        for (; sizeBytes >= sizeof (uint32_t) * 4; sizeBytes -= sizeof (uint32_t) * 4)
+        {
+            pDWord[0] = pSWord[0];
+            pDWord[1] = pSWord[1];
+            pDWord[2] = pSWord[2];
+            pDWord[3] = pSWord[3];
+            pDWord += 4;
+            pSWord += 4;
+        }
+        for (; sizeBytes >= sizeof (uint32_t); sizeBytes -= sizeof (uint32_t))
+        {
+            *pDWord++ = *pSWord++;
+        }
+        pD = (uint8_t *) pDWord;
+        pS = (const uint8_t *) pSWord;
+    }
+
+    // Whatever is left
+    for (; sizeBytes > 0; sizeBytes--)
+    {
+        *pD++ = *pS++;
+    }
+
+    return pDst;
+}
+
+// Copy using unaligned loads: bytes up to a word boundary of the
+// destination, then words whatever the alignment of the source.
+static KERNELS_NO_LIBCALLS void * memcpyArmv7m(void *pDst, const void *pSrc, size_t sizeBytes)
+{
+    uint8_t *pD = (uint8_t *) pDst;
+    const uint8_t *pS = (const uint8_t *) pSrc;
+    uint32_t *pDWord;
+
+    for (; (sizeBytes > 0) && (((uintptr_t) pD & (sizeof (uint32_t) - 1)) != 0); sizeBytes--)
+    {
+        *pD++ = *pS++;
+    }
+    pDWord = (uint32_t *) pD;
+    for (; sizeBytes >= sizeof (uint32_t) * 4; sizeBytes -= sizeof (uint32_t) * 4)
+    {
+        pDWord[0] = loadUnaligned(pS);
+        pDWord[1] = loadUnaligned(pS + 4);
+        pDWord[2] = loadUnaligned(pS + 8);
+        pDWord[3] = loadUnaligned(pS + 12);
+        pDWord += 4;
+        pS += 16;
+    }
+    for (; sizeBytes >= sizeof (uint32_t); sizeBytes -= sizeof (uint32_t))
+    {
+        *pDWord++ = loadUnaligned(pS);
+        pS += 4;
+    }
+    pD = (uint8_t *) pDWord;
+    for (; sizeBytes > 0; sizeBytes--)
+    {
+        *pD++ = *pS++;
+    }
+
+    return pDst;
+}
+
+// CRC-32 a byte at a time.
+static uint32_t crc32Armv6m(uint32_t crc, const void *pBuf, size_t sizeBytes)
+{
+    const uint8_t *pB = (const uint8_t *) pBuf;
+
+    crc = ~crc;
+    for (; sizeBytes > 0; sizeBytes--)
+    {
+        crc = gCrc32Table[(crc ^ *pB++) & 0xff] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+// CRC-32 a word at a time, loaded unaligned; the bytes of the word
+// are taken in memory order, so this is for little-endian cores only.
+static uint32_t crc32Armv7m(uint32_t crc, const void *pBuf, size_t sizeBytes)
+{
+    const uint8_t *pB = (const uint8_t *) pBuf;
+
+    crc = ~crc;
+    for (; sizeBytes >= sizeof (uint32_t); sizeBytes -= sizeof (uint32_t))
+    {
+        crc ^= loadUnaligned(pB);
+        pB += sizeof (uint32_t);
+        crc = gCrc32Table[crc & 0xff] ^ (crc >> 8);
+        crc = gCrc32Table[crc & 0xff] ^ (crc >> 8);
+        crc = gCrc32Table[crc & 0xff] ^ (crc >> 8);
+        crc = gCrc32Table[crc & 0xff] ^ (crc >> 8);
+    }
+    for (; sizeBytes > 0; sizeBytes--)
+    {
+        crc = gCrc32Table[(crc ^ *pB++) & 0xff] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+// The sets of kernels
+static const Kernels_t gArmv6mKernels = {"ARMv6-M", memcpyArmv6m, crc32Armv6m};
+static const Kernels_t gArmv7mKernels = {"ARMv7-M", memcpyArmv7m, crc32Armv7m};
+
+// The set in use, see kernelsSelect()
+static const Kernels_t * gpKernels = &gArmv6mKernels;
+
+// Whether a set of kernels can run on the given core
+static bool canRun(const Kernels_t *pKernels, const CpuInfo_t *pCpu)
+{
+    return (pKernels != &gArmv7mKernels) ||
+           ((pCpu != NULL) && pCpu->unalignedAccess && isLittleEndian());
+}
+
+// Time KERNELS_BENCHMARK_ITERATIONS copies, returning the counts
+// taken, and check the last one.
+static uint32_t timeMemcpy(void * (*pMemcpy)(void *, const void *, size_t),
+                           void *pDst, const void *pSrc, size_t sizeBytes, bool *pGood)
+{
+    uint32_t startCounts;
+    uint32_t counts;
+
+    memset(pDst, 0, sizeBytes);
+    startCounts = cycleCounterRead();
+    for (uint32_t x = 0; x < KERNELS_BENCHMARK_ITERATIONS; x++)
+    {
+        pMemcpy(pDst, pSrc, sizeBytes);
+    }
+    counts = cycleCounterRead() - startCounts;
+    *pGood = (memcmp(pDst, pSrc, sizeBytes) == 0) && *pGood;
+
+    return counts;
+}
+
+// Time KERNELS_BENCHMARK_ITERATIONS CRCs, returning the counts taken
+// and the CRC.
+static uint32_t timeCrc32(uint32_t (*pCrc32)(uint32_t, const void *, size_t),
+                          const void *pBuf, size_t sizeBytes, uint32_t *pCrc)
+{
+    uint32_t startCounts;
+
+    startCounts = cycleCounterRead();
+    for (uint32_t x = 0; x < KERNELS_BENCHMARK_ITERATIONS; x++)
+    {
+        *pCrc = pCrc32(0, pBuf, sizeBytes);
+    }
+
+    return cycleCounterRead() - startCounts;
+}
+
+// Print a timing.
+static void printTiming(const char *pName, const char *pWhat, size_t numBytes, uint32_t counts)
+{
+    printf("    %-8s %-18s %10" PRIu32 " %s", pName, pWhat, counts, cycleCounterUnits());
+    if (counts > 0)
+    {
+        printf(", %" PRIu32 " kbytes/s", (uint32_t) (((uint64_t) numBytes * cycleCounterPerUs() * 1000) / counts));
+    }
+    printf(".\n");
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Pick the kernels for the core
+void kernelsSelect(const CpuInfo_t *pCpu)
+{
+    gpKernels = canRun(&gArmv7mKernels, pCpu) ? &gArmv7mKernels : &gArmv6mKernels;
+}
+
+// Return the name of the kernels in use
+const char * kernelsName()
+{
+    return gpKernels->pName;
+}
+
+// Check and time the kernels
+void kernelsBenchmark(const CpuInfo_t *pCpu, void *pMem, size_t memorySizeBytes)
+{
+    const Kernels_t * pAllKernels[] = {&gArmv6mKernels, &gArmv7mKernels};
+    size_t halfBytes = (memorySizeBytes / 2) & ~(sizeof (uint32_t) - 1);
+    uint8_t *pSrc = (uint8_t *) pMem;
+    uint8_t *pDst = pSrc + halfBytes;
+    size_t sizeBytes;
+    size_t numBytes;
+    uint32_t referenceCrc = 0;
+    uint32_t crc;
+    bool good;
+
+    if ((pMem != NULL) && (halfBytes > sizeof (uint32_t)))
+    {
+        // Leave room to offset the source by a byte
+        sizeBytes = halfBytes - sizeof (uint32_t);
+        numBytes = sizeBytes * KERNELS_BENCHMARK_ITERATIONS;
+        for (size_t x = 0; x < halfBytes; x++)
+        {
+            pSrc[x] = (uint8_t) (x ^ (x >> 8));
+        }
+        cycleCounterInit();
+
+        printf("*** Benchmarking copy and CRC kernels (%s in use) over %d byte(s), %d iteration(s).\n",
+               gpKernels->pName, (int) sizeBytes, KERNELS_BENCHMARK_ITERATIONS);
+        good = true;
+        printTiming("library", "memcpy() aligned", numBytes, timeMemcpy(memcpy, pDst, pSrc, sizeBytes, &good));
+        printTiming("library", "memcpy() unaligned", numBytes, timeMemcpy(memcpy, pDst, pSrc + 1, sizeBytes, &good));
+        if (!good)
+        {
+            printf("!!! RAM changed under the benchmark, results are not valid.\n");
+        }
+
+        for (uint32_t x = 0; x < sizeof (pAllKernels) / sizeof (pAllKernels[0]); x++)
+        {
+            if (!canRun(pAllKernels[x], pCpu))
+            {
+                printf("    %-8s not for this core.\n", pAllKernels[x]->pName);
+                continue;
+            }
+
+            good = (pAllKernels[x]->pCrc32(0, KERNELS_CRC32_CHECK_STRING, strlen(KERNELS_CRC32_CHECK_STRING)) == KERNELS_CRC32_CHECK_VALUE);
+            printTiming(pAllKernels[x]->pName, "memcpy() aligned", numBytes,
+                        timeMemcpy(pAllKernels[x]->pMemcpy, pDst, pSrc, sizeBytes, &good));
+            printTiming(pAllKernels[x]->pName, "memcpy() unaligned", numBytes,
+                        timeMemcpy(pAllKernels[x]->pMemcpy, pDst, pSrc + 1, sizeBytes, &good));
+            printTiming(pAllKernels[x]->pName, "CRC-32 unaligned", numBytes,
+                        timeCrc32(pAllKernels[x]->pCrc32, pSrc + 1, sizeBytes, &crc));
+            if (x == 0)
+            {
+                referenceCrc = crc;
+            }
+            if (!good || (crc != referenceCrc))
+            {
+                printf("!!! The %s kernels gave the wrong answer.\n", pAllKernels[x]->pName);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu_info.h"
+
+// Copy and CRC kernels with a variant for each architecture: the
+// ARMv6-M ones make only aligned accesses, the ARMv7-M ones use the
+// unaligned word loads that those cores allow.  kernelsSelect() picks
+// the variant for the core found at run time, which kernelsBenchmark()
+// reports as the one in use; until it is called that is the ARMv6-M
+// variant, which runs anywhere.  The application makes no copies or
+// CRCs of any size of its own, so the kernels are only benchmarked.
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Pick the kernels for the given core.
+void kernelsSelect(const CpuInfo_t *pCpu);
+
+// Return the name of the kernels in use, e.g. "ARMv6-M".
+const char * kernelsName(void);
+
+// Check every variant that can run on the given core against the C
+// library and known answers, time them over memorySizeBytes of RAM
+// starting at pMem, and print the results.  The contents of the RAM
+// are destroyed.
+void kernelsBenchmark(const CpuInfo_t *pCpu, void *pMem, size_t memorySizeBytes);
+
+#endif // _KERNELS_H_
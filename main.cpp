@@ -16,14 +16,220 @@
  */
 
 #include "mbed.h"
+#include "heap_survey.h"
+#include "ram_test.h"
+#include "ram_scrubber.h"
+#include "buffered_serial.h"
+#include "timing_stats.h"
+#include "semihost.h"
+#include "stack_paint.h"
+#include "memory_map.h"
+#include "tlsf.h"
+#include "heap_benchmark.h"
+#include "block_pool.h"
+#include "heap_trace.h"
+#include "cpu_info.h"
+#include "kernels.h"
+#include "cycle_counter.h"
+#include "profiler.h"
+#include "event_trace.h"
+#include "deferred_log.h"
+#include "compact_printf.h"
+
+#include <inttypes.h>
+
+#ifdef __MBED_CMSIS_RTOS_CM
+#include "cmsis_os.h"
+#endif
 
 // ----------------------------------------------------------------
 // GENERAL COMPILE-TIME CONSTANTS
 // ----------------------------------------------------------------
 
-// Things to do with the processing system
-#define SYSTEM_CONTROL_BLOCK_START_ADDRESS ((uint32_t *) 0xe000ed00)
-#define SYSTEM_RAM_SIZE_BYTES 20480
+// Things to do with the processing system (see also cpu_info.h)
+// How long the core clock is measured against the us_ticker for
+#ifndef SYSTEM_CLOCK_MEASURE_US
+# define SYSTEM_CLOCK_MEASURE_US 100000
+#endif
+// How far, in percent, the measured core clock may be from
+// SystemCoreClock before checkCpu() complains
+#ifndef SYSTEM_CLOCK_TOLERANCE_PERCENT
+# define SYSTEM_CLOCK_TOLERANCE_PERCENT 2
+#endif
+// The size of RAM assumed if it can be found neither from the linker
+// symbols nor by probing (see findRamSize())
+#ifndef SYSTEM_RAM_SIZE_BYTES
+# define SYSTEM_RAM_SIZE_BYTES 20480
+#endif
+
+// Things to do with probing the heap
+// How mallocLargestSize() searches for the largest block: either
+// MALLOC_PROBE_LINEAR (step down from the target size until malloc()
+// succeeds) or MALLOC_PROBE_BISECT (binary search between the known
+// good and known bad sizes)
+#ifndef MALLOC_PROBE_MODE
+# define MALLOC_PROBE_MODE MALLOC_PROBE_BISECT
+#endif
+// The step between the sizes that are probed; with the default of
+// sizeof(uint32_t) both modes return exactly the same block, setting
+// it to the allocator's real granularity (e.g. 8 for newlib) saves a
+// malloc() call or two at the cost of up to that many bytes
+#ifndef MALLOC_PROBE_GRANULARITY_BYTES
+# define MALLOC_PROBE_GRANULARITY_BYTES sizeof(uint32_t)
+#endif
+
+// Things to do with testing RAM
+// The algorithm checkRam() uses, one of the RamTestAlgorithm_t values
+// in ram_test.h
+#ifndef RAM_TEST_ALGORITHM
+# define RAM_TEST_ALGORITHM RAM_TEST_MARCH_C_MINUS
+#endif
+// Define RAM_TEST_BENCHMARK to time the RAM test kernels against
+// word-at-a-time loops, and the copy and CRC kernels against the C
+// library, after the heap check
+
+// checkRam() always runs the quick data and address bus tests; set
+// this to 1 to also run the full RAM test on a warm boot (a reset
+// without a power cycle), it is always run on a cold boot
+#ifndef RAM_TEST_FULL_ON_WARM_BOOT
+# define RAM_TEST_FULL_ON_WARM_BOOT 0
+#endif
+// The value left in gWarmBootMarker once we have booted, which will
+// still be there after a reset if the RAM kept its contents
+#define WARM_BOOT_MARKER 0x5741524d
+
+// Things to do with the heap benchmark
+// Define HEAP_BENCHMARK to run the same synthetic traces of malloc()s
+// and free()s, in each of the patterns in heap_benchmark.h, against
+// the heap and against a TLSF allocator after the heap check
+
+// The number of steps in each trace
+#ifndef HEAP_BENCHMARK_NUM_STEPS
+# define HEAP_BENCHMARK_NUM_STEPS 2000
+#endif
+// The seed for the traces
+#ifndef HEAP_BENCHMARK_SEED
+# define HEAP_BENCHMARK_SEED 0x1ceb00da
+#endif
+
+// Things to do with the heap trace
+// When HEAP_TRACE is defined (see heap_trace.h), receiving this
+// character in the echo loop dumps the trace over gUsb (Ctrl-T)
+#ifndef HEAP_TRACE_DUMP_CHAR
+# define HEAP_TRACE_DUMP_CHAR 0x14
+#endif
+
+// Things to do with the profiler
+// Define PROFILER to profile checkRam() and then the echo loop (see
+// profiler.h); this is the sampling period
+#ifndef PROFILER_PERIOD_US
+# define PROFILER_PERIOD_US 1000
+#endif
+// Receiving this character in the echo loop prints the profile of
+// the echo loop so far (Ctrl-P)
+#ifndef PROFILER_PRINT_CHAR
+# define PROFILER_PRINT_CHAR 0x10
+#endif
+
+// Things to do with the event trace
+// When EVENT_TRACE is defined (see event_trace.h) the trace is dumped
+// over gUsb at the end of the self-tests and when this character is
+// received in the echo loop (Ctrl-E)
+#ifndef EVENT_TRACE_DUMP_CHAR
+# define EVENT_TRACE_DUMP_CHAR 0x05
+#endif
+
+// Things to do with the serial benchmark
+// Define SERIAL_BENCHMARK to let tools/serial_benchmark/serial_benchmark.py
+// drive the echo loop: receiving this character (Ctrl-B) followed by a
+// digit reports the bytes echoed and receive overflows since the last
+// report and then switches to that entry of SERIAL_BENCHMARK_BAUD_RATES;
+// any other character after it lists the rates
+#ifndef SERIAL_BENCHMARK_CHAR
+# define SERIAL_BENCHMARK_CHAR 0x02
+#endif
+// The baud rates that can be selected, at most ten; the first must be
+// the one main() starts with
+#ifndef SERIAL_BENCHMARK_BAUD_RATES
+# define SERIAL_BENCHMARK_BAUD_RATES 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+#endif
+// The character times to wait, once the transmit buffer is empty, for
+// the UART to finish sending before the baud rate is changed
+#define SERIAL_BENCHMARK_DRAIN_CHARS 4
+
+// Things to do with printing
+// Define COMPACT_PRINTF to replace the C library's printf() with the
+// formatter of compact_printf.h, writing straight to gUsb, and
+// COMPACT_PRINTF_BENCHMARK to time the two against each other after
+// the heap check
+
+// Things to do with the ticker test
+// The period at which flip() is called
+#define FLIP_PERIOD_US 100
+// How long the ticker test runs for
+#define FLIP_RUN_SECONDS 2
+// The width of the bins in the histogram of period errors
+#ifndef FLIP_HISTOGRAM_BIN_WIDTH_US
+# define FLIP_HISTOGRAM_BIN_WIDTH_US 2
+#endif
+
+// Define TICKER_SWEEP to find the shortest ticker period that is
+// serviced reliably after the ticker test.  The sweep starts at
+// TICKER_SWEEP_START_US and halves the period each step, stopping
+// when ticks start to go missing.
+#ifndef TICKER_SWEEP_START_US
+# define TICKER_SWEEP_START_US 1000
+#endif
+// How long each step of the sweep runs for
+#ifndef TICKER_SWEEP_STEP_US
+# define TICKER_SWEEP_STEP_US 200000
+#endif
+// The percentage of ticks that may go missing in a step before the
+// period is considered unreliable
+#ifndef TICKER_SWEEP_TOLERANCE_PERCENT
+# define TICKER_SWEEP_TOLERANCE_PERCENT 1
+#endif
+
+// Things to do with the echo loop
+// The size of the frames the echo loop moves received characters in,
+// and the number of them in the pool they come from
+#ifndef ECHO_FRAME_SIZE_BYTES
+# define ECHO_FRAME_SIZE_BYTES 32
+#endif
+#ifndef ECHO_NUM_FRAMES
+# define ECHO_NUM_FRAMES 2
+#endif
+
+// Things to do with the background RAM scrubber
+// The period over which the scrubber covers static RAM and the heap,
+// or 0 to disable it
+#ifndef RAM_SCRUBBER_PERIOD_SECONDS
+# define RAM_SCRUBBER_PERIOD_SECONDS 60
+#endif
+// The interval between scrubber slices
+#ifndef RAM_SCRUBBER_SLICE_INTERVAL_US
+# define RAM_SCRUBBER_SLICE_INTERVAL_US 10000
+#endif
+
+// Variables that are not initialised by the C start-up code, and so
+// survive a reset, where the toolchain allows it
+#if defined(TOOLCHAIN_GCC_ARM)
+# define NO_INIT __attribute__((section(".noinit")))
+#elif defined(TOOLCHAIN_IAR)
+# define NO_INIT __no_init
+#else
+# define NO_INIT
+#endif
+
+// Define SEMIHOSTING when running under an emulator (see the QEMU
+// section of the README): each self-test stage is then marked so that
+// an instruction-counting plugin can attribute a cost to it, and the
+// application exits after the self-tests instead of echoing forever
+#ifdef SEMIHOSTING
+# define STAGE_MARK(name) semihostStageMark(name)
+#else
+# define STAGE_MARK(name)
+#endif
 
 // ----------------------------------------------------------------
 // TYPES
@@ -32,6 +238,23 @@
 // Tick callback
 typedef void (*TickCallback_t)(uint32_t count);
 
+// The ways in which mallocLargestSize() can search for the largest block
+typedef enum
+{
+    MALLOC_PROBE_LINEAR,
+    MALLOC_PROBE_BISECT
+} MallocProbe_t;
+
+// ----------------------------------------------------------------
+// EXTERNAL SYMBOLS
+// ----------------------------------------------------------------
+
+#ifdef __MBED_CMSIS_RTOS_CM
+// The definition of the main thread, filled in by the RTOS start-up
+// code with the location of the main thread's stack
+extern "C" osThreadDef_t os_thread_def_main;
+#endif
+
 // ----------------------------------------------------------------
 // GLOBAL VARIABLES
 // ----------------------------------------------------------------
@@ -42,18 +265,95 @@ static DigitalOut gGpio(LED1);
 // Flipper to test uS delays
 static Ticker gFlipper;
 
+// The time of the last call to flip()
+static uint32_t gLastFlipUs;
+
+// The number of calls to flip()
+static volatile uint32_t gFlipCount;
+
+// Statistics on the error in the period between calls to flip()
+static TimingStats_t gFlipStats;
+
+#ifdef TICKER_SWEEP
+// The number of calls to sweepTick() in this step of the sweep
+static volatile uint32_t gSweepCount;
+
+// When this step of the sweep ends
+static uint32_t gSweepEndUs;
+#endif
+
 // Serial port for talking to a PC
 static RawSerial gUsb (USBTX, USBRX);
 
+// Interrupt-driven buffering on the serial port
+static BufferedRawSerial gBufferedUsb (&gUsb);
+
+// The frames the echo loop moves received characters in
+static BlockPool<ECHO_FRAME_SIZE_BYTES, ECHO_NUM_FRAMES> gFramePool("echo frames");
+
+#ifdef SERIAL_BENCHMARK
+// The baud rates the serial benchmark can select
+static const int gSerialBenchmarkBaudRates[] = {SERIAL_BENCHMARK_BAUD_RATES};
+
+// The entry of gSerialBenchmarkBaudRates in use
+static uint32_t gSerialBenchmarkBaudIndex = 0;
+#endif
+
+// Marker for detecting a warm boot
+static NO_INIT uint32_t gWarmBootMarker;
+
+// Whether checkRam() should run the full RAM test as well as the bus tests
+static bool gFullRamTest = true;
+
+// The number of self-test failures
+static uint32_t gNumFailures = 0;
+
+// The size of RAM, as found by findRamSize(); this bounds the heap
+// check and the RAM tests
+static size_t gRamSizeBytes = SYSTEM_RAM_SIZE_BYTES;
+
 // ----------------------------------------------------------------
 // FUNCTION PROTOTYPES
 // ----------------------------------------------------------------
 
 static void checkCpu(void);
-static void * mallocLargestSize(size_t *pSizeBytes);
+static void findRamSize(const MemoryMap_t *pMemoryMap);
+static void * mallocLargestSizeLinear(size_t *pSizeBytes, uint32_t *pNumMallocCalls);
+static void * mallocLargestSizeBisect(size_t *pSizeBytes, uint32_t *pNumMallocCalls);
+static void * mallocLargestSize(size_t *pSizeBytes, uint32_t *pNumMallocCalls);
+static void printMallocCalls(uint32_t numMallocCalls);
+static size_t checkHeapSizeByMalloc(size_t sizeBytes);
+static void checkBlockPools(void);
+static void printBlockPools(void);
 static size_t checkHeapSize(size_t sizeBytes);
+static bool isWarmBoot(void);
 static void checkRam(uint32_t * pMem, size_t memorySizeBytes);
+#ifdef RAM_TEST_BENCHMARK
+static void benchmarkRam(size_t sizeBytes);
+#endif
+#ifdef HEAP_BENCHMARK
+static void printFragmentation(size_t freeBytes, uint32_t numFreeBlocks, size_t largestFreeBytes);
+static void benchmarkHeap(void);
+#endif
+#ifdef COMPACT_PRINTF
+static int printUsb(void *pParam, const char *pBuf, int size);
+#endif
+#if defined(HEAP_TRACE) || defined(EVENT_TRACE) || defined(SERIAL_BENCHMARK)
+static int writeUsb(void *pParam, const char *pBuf, int size);
+static void flushUsb(void);
+#endif
+#ifdef SERIAL_BENCHMARK
+static void serialBenchmarkCommand(char command, uint32_t numBytes);
+static void serialBenchmark(const char *pBuf, int size);
+#endif
+static void startRamScrubber(const MemoryMap_t *pMemoryMap);
+static void paintStacks(void);
 static void flip(void);
+#ifdef TICKER_SWEEP
+static void sweepTick(void);
+static uint32_t spin(uint32_t durationUs);
+static void sweepTicker(void);
+#endif
 
 // ----------------------------------------------------------------
 // STATIC FUNCTIONS
@@ -63,89 +363,258 @@ static void flip(void);
 static void checkCpu()
 {
     uint32_t x = 0x01234567;
+    CpuInfo_t info;
+    const char *pMethod;
+    uint32_t coreHz;
+    uint32_t errorHz;
 
-    printf("\n*** Printing stuff of interest about the CPU.\n");
+    DEFERRED_LOG("\n*** Printing stuff of interest about the CPU.\n");
     if ((*(uint8_t *) &x) == 0x67)
     {
-        printf("Little endian.\n");
+        DEFERRED_LOG("Little endian.\n");
     }
     else
     {
-        printf("Big endian.\n");
+        DEFERRED_LOG("Big endian.\n");
     }
 
     // Read the system control block
-    // CPU ID register
-    printf("CPUID: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS));
+    // CPU ID register, decoded
+    cpuInfoGet(&info);
+    DEFERRED_LOG("CPUID: 0x%08" PRIx32 " (%s%s r%dp%d, ARMv%d-M%s).\n", info.cpuid,
+                 (info.implementer == CPU_INFO_IMPLEMENTER_ARM) ? "ARM " : "",
+                 cpuInfoCoreName(info.core), info.variant, info.revision,
+                 info.armv7m ? 7 : 6, info.unalignedAccess ? ", unaligned access allowed" : "");
     // Interrupt control and state register
-    printf("ICSR: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 1));
+    DEFERRED_LOG("ICSR: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 1));
     // VTOR is not there, skip it
     // Application interrupt and reset control register
-    printf("AIRCR: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 3));
+    DEFERRED_LOG("AIRCR: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 3));
     // SCR is not there, skip it
     // Configuration and control register
-    printf("CCR: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 5));
+    DEFERRED_LOG("CCR: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 5));
     // System handler priority register 2
-    printf("SHPR2: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 6));
+    DEFERRED_LOG("SHPR2: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 6));
     // System handler priority register 3
-    printf("SHPR3: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 7));
+    DEFERRED_LOG("SHPR3: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 7));
     // System handler control and status register
-    printf("SHCSR: 0x%08lx.\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 8));
+    DEFERRED_LOG("SHCSR: 0x%08" PRIx32 ".\n", *(SYSTEM_CONTROL_BLOCK_START_ADDRESS + 8));
+
+    DEFERRED_LOG("Last stack entry was at 0x%08" PRIx32 ".\n", (uint32_t) (uintptr_t) &x);
 
-    printf("Last stack entry was at 0x%08lx.\n", (uint32_t) &x);
-    printf("A static variable is at 0x%08lx.\n", (uint32_t) &gFlipper);
+    // Measure the core clock, since a mis-set PLL otherwise shows up
+    // only as everything being slow, and time the benchmarks with it
+    coreHz = cycleCounterMeasureCoreHz(SYSTEM_CLOCK_MEASURE_US, &pMethod);
+    if (coreHz > 0)
+    {
+        DEFERRED_LOG("Core clock measured as %" PRIu32 ".%03" PRIu32 " MHz (counting %s for %d us), SystemCoreClock is %" PRIu32 ".%03" PRIu32 " MHz.\n",
+                     coreHz / 1000000, (coreHz % 1000000) / 1000, pMethod, SYSTEM_CLOCK_MEASURE_US,
+                     SystemCoreClock / 1000000, (SystemCoreClock % 1000000) / 1000);
+        errorHz = (coreHz > SystemCoreClock) ? coreHz - SystemCoreClock : SystemCoreClock - coreHz;
+        if ((uint64_t) errorHz * 100 > (uint64_t) SystemCoreClock * SYSTEM_CLOCK_TOLERANCE_PERCENT)
+        {
+            DEFERRED_LOG("!!! The core clock is more than %d%% away from SystemCoreClock, check the clock set-up.\n",
+                         SYSTEM_CLOCK_TOLERANCE_PERCENT);
+        }
+        cycleCounterSetCoreHz(coreHz);
+    }
+    else
+    {
+        DEFERRED_LOG("Core clock can't be measured on this core, SystemCoreClock is %" PRIu32 ".%03" PRIu32 " MHz.\n",
+                     SystemCoreClock / 1000000, (SystemCoreClock % 1000000) / 1000);
+    }
+
+    // Use the fastest kernels this core can run
+    ramTestSelectKernels(&info);
+    kernelsSelect(&info);
+    DEFERRED_LOG("Using the %s RAM test kernels and the %s copy and CRC kernels.\n",
+                 ramTestKernelsName(), kernelsName());
 }
 
-// Malloc the largest block possible.  When called pSizeBytes should
-// point to the target size required and on return pSizeBytes will be filled
-// in with the actual size allocated.
-// A pointer to the mallocated block is returned.
-static void * mallocLargestSize(size_t *pSizeBytes)
+// Find the size of RAM, setting gRamSizeBytes.  The linker symbols
+// are used if they describe both the heap and the stack, since
+// together those bound everything, otherwise RAM is probed where the
+// core allows; failing that whatever the linker symbols describe is
+// used, and failing that SYSTEM_RAM_SIZE_BYTES is assumed.
+static void findRamSize(const MemoryMap_t *pMemoryMap)
+{
+    char *pStart = NULL;
+    char *pEnd = NULL;
+    const char *pHow = "assumed";
+
+    if ((memoryMapRegionSize(pMemoryMap, MEMORY_MAP_HEAP) > 0) &&
+        (memoryMapRegionSize(pMemoryMap, MEMORY_MAP_STACK) > 0) &&
+        memoryMapRamBounds(pMemoryMap, &pStart, &pEnd))
+    {
+        pHow = "from the linker symbols";
+    }
+    else if (memoryMapProbeRam(&gRamSizeBytes, &pStart, &pEnd))
+    {
+        pHow = "by probing";
+    }
+    else if (memoryMapRamBounds(pMemoryMap, &pStart, &pEnd))
+    {
+        pHow = "from the linker symbols, which are incomplete";
+    }
+
+    if (pEnd > pStart)
+    {
+        gRamSizeBytes = pEnd - pStart;
+        DEFERRED_LOG("*** RAM is %d byte(s), 0x%08" PRIx32 " to 0x%08" PRIx32 " (found %s).\n", (int) gRamSizeBytes,
+                     (uint32_t) (uintptr_t) pStart, (uint32_t) (uintptr_t) pEnd, pHow);
+    }
+    else
+    {
+        DEFERRED_LOG("*** RAM is %d byte(s) (%s).\n", (int) gRamSizeBytes, pHow);
+    }
+}
+
+// Malloc the largest block possible by stepping down from the target
+// size until malloc() succeeds.  This can take thousands of malloc()
+// calls if the target size is a long way from what is available.
+static void * mallocLargestSizeLinear(size_t *pSizeBytes, uint32_t *pNumMallocCalls)
 {
-    int32_t memorySizeBytes;
+    int32_t memorySizeBytes = (int32_t) *pSizeBytes;
     void * pMem = NULL;
 
-    if (pSizeBytes != NULL)
+    while ((pMem == NULL) && (memorySizeBytes > 0))
     {
-        memorySizeBytes = (int32_t) *pSizeBytes;
+        pMem = malloc(memorySizeBytes);
+        (*pNumMallocCalls)++;
+        if (pMem == NULL)
+        {
+            memorySizeBytes -= MALLOC_PROBE_GRANULARITY_BYTES;
+        }
+    }
+
+    if (memorySizeBytes < 0)
+    {
+        memorySizeBytes = 0;
+    }
+
+    *pSizeBytes = memorySizeBytes;
+
+    return pMem;
+}
+
+// Malloc the largest block possible by bisecting between a known bad
+// size and a known good size.  The sizes probed are the same as those
+// the linear walk would try, i.e. the target size less a whole number
+// of MALLOC_PROBE_GRANULARITY_BYTES steps, so the same block is found,
+// but in O(log n) rather than O(n) malloc() calls.  This relies on
+// the fact that, at any instant, if malloc() fails for a given size
+// it will also fail for all larger sizes.
+static void * mallocLargestSizeBisect(size_t *pSizeBytes, uint32_t *pNumMallocCalls)
+{
+    size_t targetSizeBytes = *pSizeBytes;
+    uint32_t badSteps = 0;
+    uint32_t goodSteps;
+    uint32_t steps;
+    void * pMem = NULL;
+
+    // First, the optimistic case
+    pMem = malloc(targetSizeBytes);
+    (*pNumMallocCalls)++;
+
+    if (pMem == NULL)
+    {
+        // Zero steps down is known bad and stepping all the way down
+        // to zero bytes counts as known "good" (but yields nothing)
+        goodSteps = (targetSizeBytes + MALLOC_PROBE_GRANULARITY_BYTES - 1) / MALLOC_PROBE_GRANULARITY_BYTES;
+
+        while (goodSteps - badSteps > 1)
+        {
+            steps = badSteps + ((goodSteps - badSteps) / 2);
+            pMem = malloc(targetSizeBytes - (steps * MALLOC_PROBE_GRANULARITY_BYTES));
+            (*pNumMallocCalls)++;
+            if (pMem != NULL)
+            {
+                free(pMem);
+                goodSteps = steps;
+            }
+            else
+            {
+                badSteps = steps;
+            }
+        }
 
-        while ((pMem == NULL) && (memorySizeBytes > 0))
+        *pSizeBytes = 0;
+        pMem = NULL;
+        if (goodSteps * MALLOC_PROBE_GRANULARITY_BYTES < targetSizeBytes)
         {
-            pMem = malloc(memorySizeBytes);
+            // Grab the block we found for real
+            *pSizeBytes = targetSizeBytes - (goodSteps * MALLOC_PROBE_GRANULARITY_BYTES);
+            pMem = malloc(*pSizeBytes);
+            (*pNumMallocCalls)++;
             if (pMem == NULL)
             {
-                memorySizeBytes -= sizeof(uint32_t);
+                *pSizeBytes = 0;
             }
         }
+    }
+
+    return pMem;
+}
+
+// Malloc the largest block possible.  When called pSizeBytes should
+// point to the target size required and on return pSizeBytes will be filled
+// in with the actual size allocated.  If pNumMallocCalls is not NULL
+// the number of calls made to malloc() in the process is added to it.
+// A pointer to the mallocated block is returned.
+static void * mallocLargestSize(size_t *pSizeBytes, uint32_t *pNumMallocCalls)
+{
+    uint32_t numMallocCalls = 0;
+    void * pMem = NULL;
 
-        if (memorySizeBytes < 0)
+    if (pSizeBytes != NULL)
+    {
+        if (MALLOC_PROBE_MODE == MALLOC_PROBE_BISECT)
         {
-            memorySizeBytes = 0;
+            pMem = mallocLargestSizeBisect(pSizeBytes, &numMallocCalls);
+        }
+        else
+        {
+            pMem = mallocLargestSizeLinear(pSizeBytes, &numMallocCalls);
         }
 
-        *pSizeBytes = memorySizeBytes;
+        if (pNumMallocCalls != NULL)
+        {
+            *pNumMallocCalls += numMallocCalls;
+        }
     }
 
     return pMem;
 }
 
-// Check how much heap can be malloc'ed, up to sizeBytes in size.
+// Print how many calls to malloc() finding the largest blocks took.
+static void printMallocCalls(uint32_t numMallocCalls)
+{
+    DEFERRED_LOG("*** Finding the largest blocks took %" PRIu32 " call(s) to malloc() (%s search).\n", numMallocCalls,
+                 (MALLOC_PROBE_MODE == MALLOC_PROBE_BISECT) ? "binary" : "linear");
+}
+
+// Check how much heap can be malloc'ed, up to sizeBytes in size, by
+// malloc()ing blocks until malloc() fails, checking the RAM of each
+// block as it goes.  This is the fallback for C libraries that
+// heapSurvey() cannot look inside.
 // Returns the number of bytes successfully malloc'ed.
-static size_t checkHeapSize(size_t sizeBytes)
+static size_t checkHeapSizeByMalloc(size_t sizeBytes)
 {
     size_t totalHeapSizeBytes = 0;
     void *pFirstMalloc = NULL;
     size_t firstMallocSizeBytes = sizeBytes;
     void **ppLaterMalloc = NULL;
     size_t laterMallocSizeBytes = sizeBytes;
+    uint32_t numMallocCalls = 0;
 
     // Try to allocate a block
-    pFirstMalloc = mallocLargestSize(&firstMallocSizeBytes);
+    pFirstMalloc = mallocLargestSize(&firstMallocSizeBytes, &numMallocCalls);
 
     if (pFirstMalloc != NULL)
     {
         // Check that this bit of RAM is good
         checkRam((uint32_t *) pFirstMalloc, firstMallocSizeBytes);
+        STAGE_MARK("checkHeapSize");
 
         // Now use the block to store pointers to memory and
         // try to allocate more blocks.  This is necessary
@@ -154,19 +623,20 @@ static size_t checkHeapSize(size_t sizeBytes)
         totalHeapSizeBytes += firstMallocSizeBytes;
 
         ppLaterMalloc = (void **) pFirstMalloc;
-        laterMallocSizeBytes = SYSTEM_RAM_SIZE_BYTES;
+        laterMallocSizeBytes = gRamSizeBytes;
 
         while ((ppLaterMalloc < (void **) pFirstMalloc + (firstMallocSizeBytes / sizeof (void **))) && (*ppLaterMalloc != NULL) && (laterMallocSizeBytes > 0))
         {
-            *ppLaterMalloc = mallocLargestSize(&laterMallocSizeBytes);
+            *ppLaterMalloc = mallocLargestSize(&laterMallocSizeBytes, &numMallocCalls);
 
             if (*ppLaterMalloc != NULL)
             {
                 // Check that this bit of RAM is good
                 checkRam((uint32_t *) *ppLaterMalloc, laterMallocSizeBytes);
+                STAGE_MARK("checkHeapSize");
 
                 totalHeapSizeBytes += laterMallocSizeBytes;
-                laterMallocSizeBytes = SYSTEM_RAM_SIZE_BYTES;
+                laterMallocSizeBytes = gRamSizeBytes;
                 ppLaterMalloc++;
             }
         }
@@ -181,81 +651,591 @@ static size_t checkHeapSize(size_t sizeBytes)
         free(pFirstMalloc);
     }
 
+    printMallocCalls(numMallocCalls);
+
     return totalHeapSizeBytes;
 }
 
-// Check that the given area of RAM is good.  Prints an error
-// message and stops dead if there is a problem.
-static void checkRam(uint32_t *pMem, size_t memorySizeBytes)
+// Check the free list of each of the fixed-size block pools, leaving
+// their statistics as they are.  Prints an error message if there is
+// a problem.
+static void checkBlockPools()
 {
-    uint32_t * pLocation = NULL;
-    uint32_t value;
+    BlockPoolStats_t stats;
 
-    if (pMem != NULL)
+    for (BlockPoolBase *pPool = BlockPoolBase::first(); pPool != NULL; pPool = pPool->next())
+    {
+        if (!pPool->check())
+        {
+            pPool->getStats(&stats);
+            DEFERRED_LOG("!!! Block pool \"%s\" failed its free list check.\n", stats.pName);
+            gNumFailures++;
+        }
+    }
+}
+
+// Print the usage of the fixed-size block pools beside the heap.
+static void printBlockPools()
+{
+    BlockPoolStats_t stats;
+
+    for (BlockPoolBase *pPool = BlockPoolBase::first(); pPool != NULL; pPool = pPool->next())
     {
-        printf("*** Checking RAM, from 0x%08lx to 0x%08lx.\n", (uint32_t) pMem, (uint32_t) pMem + memorySizeBytes / sizeof (*pMem));
+        pPool->getStats(&stats);
+        DEFERRED_LOG("*** Pool \"%s\" has %" PRIu32 " of %" PRIu32 " block(s) of %d byte(s) in use, peak %" PRIu32 ", %" PRIu32 " failure(s).\n",
+                     stats.pName, stats.numUsed, stats.numBlocks, (int) stats.blockSizeBytes, stats.peakUsed, stats.numFailures);
+    }
+}
+
+// Check how much heap is free, up to sizeBytes in size, and check
+// that the RAM of every free block is good; the block pools' usage is
+// reported too.  The survey's figures, printed first, count the
+// allocator's overhead as free; the figure returned does not.
+// Returns the number of bytes successfully malloc'ed.
+static size_t checkHeapSize(size_t sizeBytes)
+{
+    HeapSurvey_t survey;
+    size_t totalMallocBytes = 0;
+    size_t blockSizeBytes = 1;
+    uint32_t numMallocCalls = 0;
+    void *pChain = NULL;
+    void *pMem;
 
-        // Write a walking 1 pattern
-        value = 1;
-        for (pLocation = pMem; pLocation < pMem + memorySizeBytes / sizeof (*pLocation); pLocation++)
+    checkBlockPools();
+    printBlockPools();
+
+    if (!heapSurvey(&survey))
+    {
+        return checkHeapSizeByMalloc(sizeBytes);
+    }
+
+    DEFERRED_LOG("*** Heap has %d byte(s) free, allocator overhead included, in %" PRIu32 " block(s), largest %d byte(s), %" PRIu32 "%% fragmented.\n",
+                 (int) survey.totalFreeBytes, survey.numFreeBlocks, (int) survey.largestFreeBytes, survey.fragmentationPercent);
+#ifdef HEAP_TLSF
+    TlsfStats_t stats;
+    if (tlsfHeap() != NULL)
+    {
+        tlsfGetStats(tlsfHeap(), &stats);
+        DEFERRED_LOG("    TLSF: %d byte(s) in use (peak %d) of %d, %" PRIu32 " malloc(s), %" PRIu32 " free(s), %" PRIu32 " failure(s).\n",
+                     (int) stats.usedBytes, (int) stats.peakUsedBytes, (int) stats.poolBytes, stats.numMallocs, stats.numFrees, stats.numFailures);
+    }
+#endif
+
+    // Check the RAM of every free block: malloc() the largest block
+    // left until nothing more can be had, chaining the blocks through
+    // their first word once they have been checked, then free them
+    // all.  The survey sizes include the allocator's overhead, so each
+    // malloc() that will succeed is a little smaller than the block:
+    // let the probe find it, which is quick since it starts from a
+    // close guess
+    while ((totalMallocBytes < sizeBytes) && (blockSizeBytes > 0))
+    {
+        blockSizeBytes = survey.largestFreeBytes;
+        if (blockSizeBytes > sizeBytes - totalMallocBytes)
         {
-            *pLocation = value;
-            value <<= 1;
-            if (value == 0)
+            blockSizeBytes = sizeBytes - totalMallocBytes;
+        }
+        pMem = mallocLargestSize(&blockSizeBytes, &numMallocCalls);
+        if (pMem != NULL)
+        {
+            if (blockSizeBytes < sizeof (void *))
             {
-                value = 1;
+                // Too small to chain, and to be worth checking
+                free(pMem);
+                blockSizeBytes = 0;
+            }
+            else
+            {
+                checkRam((uint32_t *) pMem, blockSizeBytes);
+                STAGE_MARK("checkHeapSize");
+                totalMallocBytes += blockSizeBytes;
+                *(void **) pMem = pChain;
+                pChain = pMem;
             }
         }
+    }
+    printMallocCalls(numMallocCalls);
+
+    while (pChain != NULL)
+    {
+        pMem = pChain;
+        pChain = *(void **) pMem;
+        free(pMem);
+    }
 
-        // Read the walking 1 pattern
-        value = 1;
-        for (pLocation = pMem; pLocation < pMem + memorySizeBytes / sizeof (*pLocation); pLocation++)
+    return totalMallocBytes;
+}
+
+// Determine whether this is a warm boot, i.e. whether RAM has kept
+// its contents across the reset, and set the marker for next time.
+// Toolchains where NO_INIT is not available always see a cold boot.
+static bool isWarmBoot()
+{
+    bool warmBoot = (gWarmBootMarker == WARM_BOOT_MARKER);
+
+    gWarmBootMarker = WARM_BOOT_MARKER;
+
+    return warmBoot;
+}
+
+// Check that the given area of RAM is good: first run the data and
+// address bus tests and then, if gFullRamTest is true, the full test
+// using the algorithm selected by RAM_TEST_ALGORITHM.  Prints an
+// error message if there is a problem.
+static void checkRam(uint32_t *pMem, size_t memorySizeBytes)
+{
+    RamTestResult_t result;
+    bool success;
+
+    if (pMem != NULL)
+    {
+        STAGE_MARK("checkRam");
+        EVENT_TRACE_BEGIN(EVENT_TRACE_ID_CHECK_RAM, memorySizeBytes);
+#ifdef PROFILER
+        profilerStart(PROFILER_PERIOD_US);
+#endif
+        DEFERRED_LOG("*** Checking RAM buses, from 0x%08" PRIx32 " to 0x%08" PRIx32 ".\n", (uint32_t) (uintptr_t) pMem, (uint32_t) ((uintptr_t) pMem + memorySizeBytes));
+        success = ramTestBus(pMem, memorySizeBytes, &result);
+        DEFERRED_LOG("    %" PRIu32 " byte(s) touched, took %" PRIu32 " usecond(s).\n", result.bytesTouched, result.elapsedUs);
+
+        if (success && gFullRamTest)
         {
-            value <<= 1;
-            if (value == 0)
-            {
-                value = 1;
-            }
+            DEFERRED_LOG("*** Checking RAM (%s), from 0x%08" PRIx32 " to 0x%08" PRIx32 ".\n", ramTestName(RAM_TEST_ALGORITHM),
+                         (uint32_t) (uintptr_t) pMem, (uint32_t) ((uintptr_t) pMem + memorySizeBytes));
+            success = ramTest(RAM_TEST_ALGORITHM, pMem, memorySizeBytes, &result);
+            DEFERRED_LOG("    %" PRIu32 " pass(es), %" PRIu32 " byte(s) touched, took %" PRIu32 " usecond(s).\n",
+                         result.passes, result.bytesTouched, result.elapsedUs);
         }
 
-        if (pLocation >= pMem + memorySizeBytes / sizeof (uint32_t))
+        if (!success && (result.pFailure != NULL))
         {
-            // Write an inverted walking 1 pattern
-            value = 1;
-            for (pLocation = pMem; pLocation < pMem + memorySizeBytes / sizeof (*pLocation); pLocation++)
-            {
-                *pLocation = ~value;
-                value <<= 1;
-                if (value == 0)
-                {
-                    value = 1;
-                }
-            }
+            DEFERRED_LOG("!!! RAM check failure at location 0x%08" PRIx32 " (expected 0x%08" PRIx32 ", contents 0x%08" PRIx32 ").\n",
+                         (uint32_t) (uintptr_t) result.pFailure, result.expected, result.actual);
+        }
+        if (!success)
+        {
+            gNumFailures++;
+        }
+
+#ifdef PROFILER
+        profilerStop();
+#endif
+        EVENT_TRACE_END(EVENT_TRACE_ID_CHECK_RAM, success);
+    }
+}
+
+#ifdef RAM_TEST_BENCHMARK
+// Benchmark the RAM test kernels, and the copy and CRC kernels,
+// over the largest block of heap, up to sizeBytes in size.
+static void benchmarkRam(size_t sizeBytes)
+{
+    void *pMem = mallocLargestSize(&sizeBytes, NULL);
+    CpuInfo_t info;
+
+    if (pMem != NULL)
+    {
+        ramTestBenchmark((uint32_t *) pMem, sizeBytes);
+        cpuInfoGet(&info);
+        kernelsBenchmark(&info, pMem, sizeBytes);
+        free(pMem);
+    }
+}
+#endif
+
+#ifdef HEAP_BENCHMARK
+// Malloc and free functions for the benchmark
+static void * benchmarkMalloc(void *pContext, size_t sizeBytes)
+{
+    (void) pContext;
+    return malloc(sizeBytes);
+}
+
+static void benchmarkFree(void *pContext, void *pMem)
+{
+    (void) pContext;
+    free(pMem);
+}
+
+static void * benchmarkTlsfMalloc(void *pContext, size_t sizeBytes)
+{
+    return tlsfMalloc((Tlsf_t *) pContext, sizeBytes);
+}
+
+static void benchmarkTlsfFree(void *pContext, void *pMem)
+{
+    tlsfFree((Tlsf_t *) pContext, pMem);
+}
+
+// Print how fragmented the free memory of an allocator is.
+static void printFragmentation(size_t freeBytes, uint32_t numFreeBlocks, size_t largestFreeBytes)
+{
+    printf("      Afterwards %d byte(s) free in %" PRIu32 " block(s), largest %d byte(s), %" PRIu32 "%% fragmented.\n",
+           (int) freeBytes, numFreeBlocks, (int) largestFreeBytes,
+           (freeBytes > 0) ? 100 - (uint32_t) (((uint64_t) largestFreeBytes * 100) / freeBytes) : 0);
+}
+
+// Run the heap benchmark: the synthetic trace in each pattern against
+// malloc() and then against a TLSF allocator managing the largest free
+// block of heap, keeping up to half of that block allocated in each
+// case so that both have the same room to work in.
+static void benchmarkHeap()
+{
+    static Tlsf_t tlsf;
+    HeapBenchmarkAllocator_t heap = {"malloc()", benchmarkMalloc, benchmarkFree, NULL};
+    HeapBenchmarkAllocator_t tlsfPool = {"TLSF", benchmarkTlsfMalloc, benchmarkTlsfFree, &tlsf};
+    HeapBenchmarkResult_t result;
+    HeapSurvey_t survey;
+    TlsfStats_t stats;
+    size_t sizeBytes = gRamSizeBytes;
+    void *pPool;
+
+    // No bigger than a TLSF allocator can manage
+    if (sizeBytes > ((size_t) 1 << TLSF_FL_INDEX_MAX))
+    {
+        sizeBytes = (size_t) 1 << TLSF_FL_INDEX_MAX;
+    }
+    pPool = mallocLargestSize(&sizeBytes, NULL);
+    if (pPool == NULL)
+    {
+        return;
+    }
+    free(pPool);
+
+    printf("*** Running traces of %d heap operation(s), up to %d byte(s) live.\n",
+           HEAP_BENCHMARK_NUM_STEPS, (int) (sizeBytes / 2));
+    for (int x = 0; x < MAX_NUM_HEAP_BENCHMARK_PATTERNS; x++)
+    {
+        heapBenchmarkRun(&heap, (HeapBenchmarkPattern_t) x, HEAP_BENCHMARK_SEED, HEAP_BENCHMARK_NUM_STEPS,
+                         sizeBytes / 2, &result);
+        heapBenchmarkPrint(&heap, &result);
+        if (heapSurvey(&survey))
+        {
+            printFragmentation(survey.totalFreeBytes, survey.numFreeBlocks, survey.largestFreeBytes);
+        }
+        heapBenchmarkRelease(&heap);
+
+        pPool = malloc(sizeBytes);
+        if ((pPool != NULL) && tlsfInit(&tlsf, pPool, sizeBytes))
+        {
+            heapBenchmarkRun(&tlsfPool, (HeapBenchmarkPattern_t) x, HEAP_BENCHMARK_SEED, HEAP_BENCHMARK_NUM_STEPS,
+                             sizeBytes / 2, &result);
+            heapBenchmarkPrint(&tlsfPool, &result);
+            tlsfGetStats(&tlsf, &stats);
+            printFragmentation(stats.freeBytes, stats.numFreeBlocks, stats.largestFreeBytes);
+            heapBenchmarkRelease(&tlsfPool);
+        }
+        free(pPool);
+    }
+}
+#endif
+
+#ifdef COMPACT_PRINTF
+// Write to gUsb directly, as the C library's printf() would, for
+// compactPrintf(), which replaces it
+static int printUsb(void *pParam, const char *pBuf, int size)
+{
+    (void) pParam;
+    for (int x = 0; x < size; x++)
+    {
+        gUsb.putc(pBuf[x]);
+    }
 
-            // Read the inverted walking 1 pattern
-            value = 1;
-            for (pLocation = pMem; (pLocation < pMem + memorySizeBytes / sizeof (*pLocation)) && (*pLocation == ~value); pLocation++)
+    return size;
+}
+#endif
+
+#if defined(HEAP_TRACE) || defined(EVENT_TRACE) || defined(SERIAL_BENCHMARK)
+// Write to gUsb, waiting for room: for heapTraceDump(),
+// eventTraceDump() and the serial benchmark.
+static int writeUsb(void *pParam, const char *pBuf, int size)
+{
+    int written = 0;
+
+    (void) pParam;
+    while (written < size)
+    {
+        written += gBufferedUsb.write(pBuf + written, size - written);
+    }
+
+    return written;
+}
+
+// Wait until everything queued on gBufferedUsb has been sent, so that
+// printf(), which goes straight to the UART, can't land in the middle
+// of a binary dump.
+static void flushUsb()
+{
+    while (gBufferedUsb.writeable() < BUFFERED_SERIAL_TX_SIZE)
+    {
+    }
+}
+#endif
+
+#ifdef SERIAL_BENCHMARK
+// Carry out a serial benchmark command, the character that followed
+// SERIAL_BENCHMARK_CHAR: report, over gBufferedUsb so that it is in
+// order with the echoed bytes, what has been echoed since the last
+// report and then, if the command is the index of a baud rate, switch
+// to it once the report has gone.
+static void serialBenchmarkCommand(char command, uint32_t numBytes)
+{
+    static uint32_t lastRxOverflows = 0;
+    const uint32_t numBaudRates = sizeof (gSerialBenchmarkBaudRates) / sizeof (gSerialBenchmarkBaudRates[0]);
+    uint32_t index = (uint32_t) (command - '0');
+    uint32_t rxOverflows = gBufferedUsb.rxOverflows();
+    char buf[128];
+    int length;
+
+    if (index < numBaudRates)
+    {
+        length = compactSnprintf(buf, sizeof (buf), "*** Serial benchmark: %" PRIu32 " byte(s) echoed, %" PRIu32 " receive overflow(s), now %d baud.\n",
+                                 numBytes, rxOverflows - lastRxOverflows, gSerialBenchmarkBaudRates[index]);
+    }
+    else
+    {
+        length = compactSnprintf(buf, sizeof (buf), "*** Serial benchmark: %" PRIu32 " byte(s) echoed, %" PRIu32 " receive overflow(s), baud rates",
+                                 numBytes, rxOverflows - lastRxOverflows);
+        for (uint32_t x = 0; (x < numBaudRates) && (length < (int) sizeof (buf)); x++)
+        {
+            length += compactSnprintf(buf + length, sizeof (buf) - length, " %d%s", gSerialBenchmarkBaudRates[x],
+                                      (x == gSerialBenchmarkBaudIndex) ? "*" : "");
+        }
+        if (length < (int) sizeof (buf))
+        {
+            length += compactSnprintf(buf + length, sizeof (buf) - length, ".\n");
+        }
+    }
+    lastRxOverflows = rxOverflows;
+    if (length >= (int) sizeof (buf))
+    {
+        length = sizeof (buf) - 1;
+    }
+    writeUsb(NULL, buf, length);
+
+    if (index < numBaudRates)
+    {
+        flushUsb();
+        wait_us((SERIAL_BENCHMARK_DRAIN_CHARS * 10 * 1000000) / gSerialBenchmarkBaudRates[gSerialBenchmarkBaudIndex]);
+        gSerialBenchmarkBaudIndex = index;
+        gUsb.baud(gSerialBenchmarkBaudRates[index]);
+    }
+}
+
+// Count what the echo loop has echoed and carry out any serial
+// benchmark commands in it; a command may be split across calls and
+// the bytes reported include the command itself.
+static void serialBenchmark(const char *pBuf, int size)
+{
+    static bool commandPending = false;
+    static uint32_t numBytes = 0;
+    const char *pEnd = pBuf + size;
+    const char *pCommand;
+
+    while (pBuf < pEnd)
+    {
+        if (commandPending)
+        {
+            commandPending = false;
+            serialBenchmarkCommand(*pBuf, numBytes + 1);
+            numBytes = 0;
+            pBuf++;
+        }
+        else
+        {
+            pCommand = (const char *) memchr(pBuf, SERIAL_BENCHMARK_CHAR, pEnd - pBuf);
+            if (pCommand == NULL)
             {
-                value <<= 1;
-                if (value == 0)
-                {
-                    value = 1;
-                }
+                numBytes += pEnd - pBuf;
+                break;
             }
+            numBytes += pCommand + 1 - pBuf;
+            commandPending = true;
+            pBuf = pCommand + 1;
         }
+    }
+}
+#endif
+
+// Paint the stacks so that their high-water marks can be measured
+// later.  With the RTOS, main() runs in a thread whose stack is placed
+// below the interrupt stack; without it, main() and interrupts share
+// the one stack.
+static void paintStacks()
+{
+    MemoryMap_t memoryMap;
+    char *pStackTop;
+
+    memoryMapGet(&memoryMap);
+    pStackTop = memoryMap.regions[MEMORY_MAP_STACK].pEnd;
+
+#ifdef __MBED_CMSIS_RTOS_CM
+    char *pInterruptStack = (char *) os_thread_def_main.stack_pointer + os_thread_def_main.stacksize;
 
-        if (pLocation < pMem + memorySizeBytes / sizeof (*pLocation))
+    stackPaintAdd("Main thread", os_thread_def_main.stack_pointer, os_thread_def_main.stacksize);
+    if (pStackTop > pInterruptStack)
+    {
+        stackPaintAdd("Interrupt", (uint32_t *) pInterruptStack, pStackTop - pInterruptStack);
+    }
+#else
+    if (pStackTop != NULL)
+    {
+        stackPaintAdd("Main", (uint32_t *) memoryMap.regions[MEMORY_MAP_STACK].pStart,
+                      memoryMapRegionSize(&memoryMap, MEMORY_MAP_STACK));
+    }
+#endif
+}
+
+// Start the RAM scrubber in the background, covering the .data, .bss
+// and heap regions of the memory map; the stacks are not covered, nor
+// is any region that holds the interrupt stack.
+static void startRamScrubber(const MemoryMap_t *pMemoryMap)
+{
+#if RAM_SCRUBBER_PERIOD_SECONDS > 0
+# ifdef MBED_HOST_BUILD
+    // The host's "interrupts" run alongside the main thread rather
+    // than stopping it, so the scrubber would pull RAM from under it
+    (void) pMemoryMap;
+    DEFERRED_LOG("*** RAM scrubber not started: interrupts don't stop the main thread on the host.\n");
+# else
+    const MemoryMapRegionType_t types[] = {MEMORY_MAP_DATA, MEMORY_MAP_BSS, MEMORY_MAP_HEAP};
+    RamScrubberRegion_t regions[sizeof (types) / sizeof (types[0])];
+    uint32_t numRegions = 0;
+    RamScrubberStatus_t status;
+    uintptr_t msp = __get_MSP();
+    uintptr_t start;
+    uintptr_t end;
+
+    for (uint32_t x = 0; x < sizeof (types) / sizeof (types[0]); x++)
+    {
+        start = ((uintptr_t) pMemoryMap->regions[types[x]].pStart + sizeof (uint32_t) - 1) & ~(sizeof (uint32_t) - 1);
+        end = (uintptr_t) pMemoryMap->regions[types[x]].pEnd & ~(sizeof (uint32_t) - 1);
+        if ((end > start) && ((msp < start) || (msp > end)))
         {
-            printf("!!! RAM check failure at location 0x%08lx (contents 0x%08lx).\n", (uint32_t) pLocation, *pLocation);
+            regions[numRegions].pStart = (uint32_t *) start;
+            regions[numRegions].sizeBytes = end - start;
+            numRegions++;
         }
     }
+
+    if ((numRegions > 0) &&
+        ramScrubberInit(regions, numRegions, RAM_SCRUBBER_PERIOD_SECONDS, RAM_SCRUBBER_SLICE_INTERVAL_US))
+    {
+        ramScrubberGetStatus(&status);
+        DEFERRED_LOG("*** Scrubbing %" PRIu32 " byte(s) of RAM in the background, %" PRIu32 " byte(s) every %d usecond(s).\n",
+                     (uint32_t) (status.totalWords * sizeof (uint32_t)), (uint32_t) (status.wordsPerSlice * sizeof (uint32_t)),
+                     RAM_SCRUBBER_SLICE_INTERVAL_US);
+        ramScrubberStart();
+    }
+    else
+    {
+        DEFERRED_LOG("*** RAM scrubber not started: no region of RAM is known.\n");
+    }
+# endif
+#else
+    (void) pMemoryMap;
+#endif
 }
 
-// Flip
+// Flip, measuring the error in the period since the last flip
+// against the free-running us_ticker
 static void flip()
 {
+    uint32_t nowUs = us_ticker_read();
+
     gGpio = !gGpio;
+    EVENT_TRACE_LOG(EVENT_TRACE_ID_FLIP, gFlipCount);
+
+    if (gFlipCount > 0)
+    {
+        timingStatsAdd(&gFlipStats, (int32_t) (nowUs - gLastFlipUs) - FLIP_PERIOD_US);
+    }
+    gLastFlipUs = nowUs;
+    gFlipCount++;
+}
+
+#ifdef TICKER_SWEEP
+// Count a tick of the sweep; the ticker is detached from here at the
+// end of a step since, if the period is too short to service, the
+// main loop may never get to run to do it
+static void sweepTick()
+{
+    gSweepCount++;
+    if ((int32_t) (us_ticker_read() - gSweepEndUs) >= 0)
+    {
+        gFlipper.detach();
+    }
+}
+
+// Spin for durationUs, returning the number of times around the loop;
+// compared with the number when nothing else is running this gives
+// the fraction of the CPU left over.
+static uint32_t spin(uint32_t durationUs)
+{
+    uint32_t startUs = us_ticker_read();
+    uint32_t loops = 0;
+
+    while (us_ticker_read() - startUs < durationUs)
+    {
+        loops++;
+    }
+
+    return loops;
+}
+
+// Halve the ticker period from TICKER_SWEEP_START_US until ticks go
+// missing (or are coalesced), printing the CPU taken at each step,
+// and report the shortest period that was serviced reliably.
+static void sweepTicker()
+{
+    uint32_t idleLoops;
+    uint32_t loops;
+    uint32_t expected;
+    uint32_t cpuPercent;
+    uint32_t reliablePeriodUs = 0;
+    bool reliable = true;
+
+    printf("*** Sweeping ticker period from %d useconds, %d useconds per step.\n", TICKER_SWEEP_START_US, TICKER_SWEEP_STEP_US);
+
+    idleLoops = spin(TICKER_SWEEP_STEP_US);
+
+    for (uint32_t periodUs = TICKER_SWEEP_START_US; (periodUs > 0) && reliable; periodUs /= 2)
+    {
+        gSweepCount = 0;
+        gSweepEndUs = us_ticker_read() + TICKER_SWEEP_STEP_US;
+        gFlipper.attach_us(&sweepTick, periodUs);
+        loops = spin(TICKER_SWEEP_STEP_US);
+
+        // Let the last tick, which detaches the ticker, arrive
+        while ((int32_t) (us_ticker_read() - gSweepEndUs) < (int32_t) periodUs)
+        {
+        }
+        gFlipper.detach();
+
+        expected = TICKER_SWEEP_STEP_US / periodUs;
+        cpuPercent = 0;
+        if ((idleLoops > 0) && (loops < idleLoops))
+        {
+            cpuPercent = 100 - (uint32_t) (((uint64_t) loops * 100) / idleLoops);
+        }
+        reliable = ((uint64_t) gSweepCount * 100 >= (uint64_t) expected * (100 - TICKER_SWEEP_TOLERANCE_PERCENT));
+        printf("    %5" PRIu32 " us: %7" PRIu32 " tick(s) of %7" PRIu32 " expected, %3" PRIu32 "%% CPU%s.\n", periodUs, gSweepCount, expected,
+               cpuPercent, reliable ? "" : ", UNRELIABLE");
+        if (reliable)
+        {
+            reliablePeriodUs = periodUs;
+        }
+    }
+
+    if (reliablePeriodUs > 0)
+    {
+        printf("*** Shortest reliable ticker period was %" PRIu32 " useconds.\n", reliablePeriodUs);
+    }
+    else
+    {
+        printf("!!! No reliable ticker period found.\n");
+    }
 }
+#endif
 
 // ----------------------------------------------------------------
 // PUBLIC FUNCTIONS
@@ -264,35 +1244,214 @@ static void flip()
 int main(void)
 {
     size_t memorySizeBytes;
+    RamScrubberStatus_t scrubberStatus;
+    MemoryMap_t memoryMap;
+    uint32_t scrubberFailures = 0;
+    char *pFrame;
+    int numBytes;
+
+    // Do this first so that as much as possible of the stack is painted
+    paintStacks();
 
     //gUsb.baud (115200);
     gUsb.baud (9600);
+#ifdef COMPACT_PRINTF
+    compactPrintfSetOutput(printUsb, NULL);
+#endif
 
+    STAGE_MARK("checkCpu");
     checkCpu();
 
-    printf("*** Checking heap size available.\n");
-    memorySizeBytes = checkHeapSize(SYSTEM_RAM_SIZE_BYTES);
+    // Anything that prints directly, rather than through DEFERRED_LOG(),
+    // is preceded by DEFERRED_LOG_FLUSH() to keep the output in order
+    if (memoryMapGet(&memoryMap))
+    {
+        DEFERRED_LOG("*** Memory map:\n");
+        DEFERRED_LOG_FLUSH();
+        memoryMapPrint(&memoryMap);
+    }
+    findRamSize(&memoryMap);
+
+    if (isWarmBoot())
+    {
+        DEFERRED_LOG("*** Warm boot.\n");
+        gFullRamTest = RAM_TEST_FULL_ON_WARM_BOOT;
+    }
+
+    STAGE_MARK("checkHeapSize");
+    DEFERRED_LOG("*** Checking heap size available.\n");
+    memorySizeBytes = checkHeapSize(gRamSizeBytes);
+
+    DEFERRED_LOG("*** Total heap available was %d bytes.\n", (int) memorySizeBytes);
+    DEFERRED_LOG("    The last variable pushed onto the stack was at 0x%08" PRIx32 ", MSP is at 0x%08" PRIx32 ".\n", (uint32_t) (uintptr_t) &memorySizeBytes, __get_MSP());
+
+    // The profile and the benchmarks print directly
+    DEFERRED_LOG_FLUSH();
+
+#ifdef PROFILER
+    profilerPrint("checkRam()");
+    profilerReset();
+#endif
+
+#ifdef HEAP_BENCHMARK
+    STAGE_MARK("heapBenchmark");
+    benchmarkHeap();
+#endif
+
+#ifdef RAM_TEST_BENCHMARK
+    STAGE_MARK("benchmarkRam");
+    benchmarkRam(gRamSizeBytes);
+#endif
 
-    printf("*** Total heap available was %d bytes.\n", memorySizeBytes);
-    printf("    The last variable pushed onto the stack was at 0x%08lx, MSP is at 0x%08lx.\n", (uint32_t) &memorySizeBytes, __get_MSP());
+#ifdef COMPACT_PRINTF_BENCHMARK
+    STAGE_MARK("compactPrintfBenchmark");
+    compactPrintfBenchmark();
+#endif
 
-    printf("*** Running us_ticker at 100 usecond intervals for 2 seconds...\n");
+    STAGE_MARK("ticker");
+    DEFERRED_LOG("*** Running us_ticker at %d usecond intervals for %d seconds...\n", FLIP_PERIOD_US, FLIP_RUN_SECONDS);
 
     /* Use a usecond delay function to check-out the us_ticker at high speed for a little while */
-    gFlipper.attach_us(&flip, 100);
+    timingStatsInit(&gFlipStats, FLIP_HISTOGRAM_BIN_WIDTH_US);
+    gFlipCount = 0;
+    gFlipper.attach_us(&flip, FLIP_PERIOD_US);
 
-    wait(2);
+    wait(FLIP_RUN_SECONDS);
 
     gFlipper.detach();
 
-    printf("*** Echoing received characters forever.\n");
+    DEFERRED_LOG("*** %" PRIu32 " tick(s) received, %d expected.\n", gFlipCount, (FLIP_RUN_SECONDS * 1000000) / FLIP_PERIOD_US);
+    DEFERRED_LOG_FLUSH();
+    timingStatsPrint(&gFlipStats, "Tick period error");
+
+#ifdef TICKER_SWEEP
+    STAGE_MARK("tickerSweep");
+    sweepTicker();
+#endif
+
+    if (stackPaintNumStacks() > 0)
+    {
+        DEFERRED_LOG("*** Stack usage so far:\n");
+        DEFERRED_LOG_FLUSH();
+        stackPaintPrint();
+    }
+
+#ifdef SEMIHOSTING
+    STAGE_MARK("end");
+    DEFERRED_LOG("*** Self-tests complete, %" PRIu32 " failure(s).\n", gNumFailures);
+    DEFERRED_LOG_FLUSH();
+    semihostExit(gNumFailures == 0);
+#endif
+
+#ifdef EVENT_TRACE
+    DEFERRED_LOG("*** Event trace has %" PRIu32 " event(s), binary dump of the latest follows.\n", eventTraceNumEvents());
+    DEFERRED_LOG_FLUSH();
+    eventTraceDump(writeUsb, NULL);
+    flushUsb();
+    DEFERRED_LOG("\n");
+#endif
+
+    // The self-tests are over, print what they logged
+    DEFERRED_LOG_FLUSH();
+    startRamScrubber(&memoryMap);
+
+#ifdef HEAP_TRACE
+    DEFERRED_LOG("*** Heap trace has %" PRIu32 " event(s), send 0x%02x for a binary dump of the latest.\n",
+                 heapTraceNumEvents(), HEAP_TRACE_DUMP_CHAR);
+#endif
+
+#ifdef EVENT_TRACE
+    DEFERRED_LOG("*** Send 0x%02x for a binary dump of the latest events.\n", EVENT_TRACE_DUMP_CHAR);
+#endif
+#ifdef PROFILER
+    DEFERRED_LOG("*** Profiling the echo loop, send 0x%02x for the profile so far.\n", PROFILER_PRINT_CHAR);
+    profilerStart(PROFILER_PERIOD_US);
+#endif
+
+#ifdef SERIAL_BENCHMARK
+    DEFERRED_LOG("*** Send 0x%02x and a digit to change the baud rate for the serial benchmark.\n", SERIAL_BENCHMARK_CHAR);
+#endif
+    DEFERRED_LOG("*** Echoing received characters forever.\n");
 
     while (1)
     {
-        if (gUsb.readable() && gUsb.writeable())
+        ramScrubberGetStatus(&scrubberStatus);
+        if (scrubberStatus.numFailures != scrubberFailures)
+        {
+            scrubberFailures = scrubberStatus.numFailures;
+            DEFERRED_LOG("!!! RAM scrubber failure at location 0x%08" PRIx32 " (%" PRIu32 " failure(s) so far, %" PRIu32 "%% through sweep %" PRIu32 ").\n",
+                         (uint32_t) (uintptr_t) scrubberStatus.pFirstFailure, scrubberStatus.numFailures,
+                         scrubberStatus.coveragePercent, scrubberStatus.sweepsCompleted + 1);
+        }
+
+        // Move as much as there is room to send, a frame at a time,
+        // only taking a frame when there is something to move
+        numBytes = 0;
+        pFrame = NULL;
+        if ((gBufferedUsb.readable() > 0) && (gBufferedUsb.writeable() > 0))
+        {
+            pFrame = (char *) gFramePool.alloc();
+        }
+        if (pFrame != NULL)
+        {
+            numBytes = gBufferedUsb.writeable();
+            if (numBytes > ECHO_FRAME_SIZE_BYTES)
+            {
+                numBytes = ECHO_FRAME_SIZE_BYTES;
+            }
+            numBytes = gBufferedUsb.read(pFrame, numBytes);
+        }
+        if (numBytes > 0)
+        {
+            EVENT_TRACE_LOG(EVENT_TRACE_ID_ECHO, numBytes);
+            gBufferedUsb.write(pFrame, numBytes);
+#ifdef SERIAL_BENCHMARK
+            serialBenchmark(pFrame, numBytes);
+#endif
+#ifdef HEAP_TRACE
+            if (memchr(pFrame, HEAP_TRACE_DUMP_CHAR, numBytes) != NULL)
+            {
+                DEFERRED_LOG_FLUSH();
+                heapTraceDump(writeUsb, NULL);
+                flushUsb();
+            }
+#endif
+#ifdef PROFILER
+            if (memchr(pFrame, PROFILER_PRINT_CHAR, numBytes) != NULL)
+            {
+                DEFERRED_LOG_FLUSH();
+                profilerPrint("the echo loop");
+            }
+#endif
+#ifdef EVENT_TRACE
+            if (memchr(pFrame, EVENT_TRACE_DUMP_CHAR, numBytes) != NULL)
+            {
+                DEFERRED_LOG_FLUSH();
+                eventTraceDump(writeUsb, NULL);
+                flushUsb();
+            }
+#endif
+        }
+        else
+        {
+            // Nothing to echo, so print what has been logged
+            DEFERRED_LOG_FLUSH();
+
+            // Nothing to do until an interrupt arrives; mask interrupts
+            // while checking so that one can't slip in before the sleep,
+            // sleep() still wakes up on it
+            __disable_irq();
+            if ((gBufferedUsb.readable() == 0) || (gBufferedUsb.writeable() == 0))
+            {
+                EVENT_TRACE_BEGIN(EVENT_TRACE_ID_SLEEP, 0);
+                sleep();
+                EVENT_TRACE_END(EVENT_TRACE_ID_SLEEP, 0);
+            }
+            __enable_irq();
+        }
+        if (pFrame != NULL)
         {
-            char c = gUsb.getc();
-            gUsb.putc(c);
+            gFramePool.free(pFrame);
         }
     }
 }
@@ -0,0 +1,317 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "memory_map.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Whether this core can suppress bus faults to probe memory
+#if defined(__CORTEX_M) && (__CORTEX_M >= 3)
+# define MEMORY_MAP_CAN_PROBE 1
+#else
+# define MEMORY_MAP_CAN_PROBE 0
+#endif
+
+// ----------------------------------------------------------------
+// EXTERNAL SYMBOLS
+// ----------------------------------------------------------------
+
+// All weak, so that a linker script or scatter file that doesn't
+// provide one just leaves that region unknown
+#if defined(TOOLCHAIN_GCC_ARM)
+extern "C" char __data_start__[] __attribute__((weak));
+extern "C" char __data_end__[] __attribute__((weak));
+extern "C" char __bss_start__[] __attribute__((weak));
+extern "C" char __bss_end__[] __attribute__((weak));
+extern "C" char __end__[] __attribute__((weak));
+extern "C" char __HeapLimit[] __attribute__((weak));
+extern "C" char __StackLimit[] __attribute__((weak));
+extern "C" char __StackTop[] __attribute__((weak));
+#elif defined(TOOLCHAIN_ARM)
+extern "C" char Image$$RW_IRAM1$$RW$$Base[] __attribute__((weak));
+extern "C" char Image$$RW_IRAM1$$RW$$Limit[] __attribute__((weak));
+extern "C" char Image$$RW_IRAM1$$ZI$$Base[] __attribute__((weak));
+extern "C" char Image$$RW_IRAM1$$ZI$$Limit[] __attribute__((weak));
+extern "C" char Image$$ARM_LIB_HEAP$$ZI$$Base[] __attribute__((weak));
+extern "C" char Image$$ARM_LIB_HEAP$$ZI$$Limit[] __attribute__((weak));
+extern "C" char Image$$ARM_LIB_STACK$$ZI$$Base[] __attribute__((weak));
+extern "C" char Image$$ARM_LIB_STACK$$ZI$$Limit[] __attribute__((weak));
+#elif defined(TOOLCHAIN_IAR)
+#pragma section = ".data"
+#pragma section = ".bss"
+#pragma section = "HEAP"
+#pragma section = "CSTACK"
+#endif
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The names of the regions, in MemoryMapRegionType_t order
+static const char * gRegionNames[] = {".data", ".bss", "heap", "stack"};
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set a region, leaving it unknown if either end is missing or
+// the two are the wrong way round
+static void setRegion(MemoryMap_t *pMap, MemoryMapRegionType_t type, char *pStart, char *pEnd)
+{
+    if ((pStart != NULL) && (pEnd != NULL) && (pEnd >= pStart))
+    {
+        pMap->regions[type].pStart = pStart;
+        pMap->regions[type].pEnd = pEnd;
+    }
+}
+
+#if MEMORY_MAP_CAN_PROBE
+// Read a word, returning false if that caused a bus fault.  With
+// FAULTMASK set and CCR.BFHFNMIGN set, a precise bus fault on a data
+// access is ignored, only being recorded in the BFSR.
+static bool probeWord(const volatile uint32_t *pAddress)
+{
+    uint32_t faultmask = __get_FAULTMASK();
+    uint32_t ccr = SCB->CCR;
+    bool readable;
+
+    __set_FAULTMASK(1);
+    SCB->CFSR = SCB_CFSR_BUSFAULTSR_Msk;
+    SCB->CCR = ccr | SCB_CCR_BFHFNMIGN_Msk;
+    __DSB();
+    __ISB();
+
+    (void) *pAddress;
+    __DSB();
+
+    readable = ((SCB->CFSR & SCB_CFSR_BUSFAULTSR_Msk) == 0);
+    SCB->CFSR = SCB_CFSR_BUSFAULTSR_Msk;
+    SCB->CCR = ccr;
+    __DSB();
+    __ISB();
+    __set_FAULTMASK(faultmask);
+
+    return readable;
+}
+#endif
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Read the layout of RAM
+bool memoryMapGet(MemoryMap_t *pMap)
+{
+    bool success = false;
+
+    if (pMap != NULL)
+    {
+        memset(pMap, 0, sizeof (*pMap));
+        for (uint32_t x = 0; x < MAX_NUM_MEMORY_MAP_REGIONS; x++)
+        {
+            pMap->regions[x].pName = gRegionNames[x];
+        }
+
+#if defined(TOOLCHAIN_GCC_ARM)
+        setRegion(pMap, MEMORY_MAP_DATA, __data_start__, __data_end__);
+        setRegion(pMap, MEMORY_MAP_BSS, __bss_start__, __bss_end__);
+        if (__HeapLimit > __end__)
+        {
+            setRegion(pMap, MEMORY_MAP_HEAP, __end__, __HeapLimit);
+        }
+        else
+        {
+            setRegion(pMap, MEMORY_MAP_HEAP, __end__, __StackLimit);
+        }
+        setRegion(pMap, MEMORY_MAP_STACK, __StackLimit, __StackTop);
+#elif defined(TOOLCHAIN_ARM)
+        setRegion(pMap, MEMORY_MAP_DATA, Image$$RW_IRAM1$$RW$$Base, Image$$RW_IRAM1$$RW$$Limit);
+        setRegion(pMap, MEMORY_MAP_BSS, Image$$RW_IRAM1$$ZI$$Base, Image$$RW_IRAM1$$ZI$$Limit);
+        setRegion(pMap, MEMORY_MAP_HEAP, Image$$ARM_LIB_HEAP$$ZI$$Base, Image$$ARM_LIB_HEAP$$ZI$$Limit);
+        setRegion(pMap, MEMORY_MAP_STACK, Image$$ARM_LIB_STACK$$ZI$$Base, Image$$ARM_LIB_STACK$$ZI$$Limit);
+#elif defined(TOOLCHAIN_IAR)
+        setRegion(pMap, MEMORY_MAP_DATA, (char *) __section_begin(".data"), (char *) __section_end(".data"));
+        setRegion(pMap, MEMORY_MAP_BSS, (char *) __section_begin(".bss"), (char *) __section_end(".bss"));
+        setRegion(pMap, MEMORY_MAP_HEAP, (char *) __section_begin("HEAP"), (char *) __section_end("HEAP"));
+        setRegion(pMap, MEMORY_MAP_STACK, (char *) __section_begin("CSTACK"), (char *) __section_end("CSTACK"));
+#elif defined(MBED_HOST_BUILD)
+        char *pBounds[6];
+
+        hostMemoryMap(&pBounds[0], &pBounds[1], &pBounds[2], &pBounds[3], &pBounds[4], &pBounds[5]);
+        setRegion(pMap, MEMORY_MAP_DATA, pBounds[0], pBounds[1]);
+        setRegion(pMap, MEMORY_MAP_BSS, pBounds[2], pBounds[3]);
+        setRegion(pMap, MEMORY_MAP_HEAP, pBounds[4], pBounds[5]);
+#endif
+
+        for (uint32_t x = 0; x < MAX_NUM_MEMORY_MAP_REGIONS; x++)
+        {
+            if (pMap->regions[x].pStart != NULL)
+            {
+                success = true;
+            }
+        }
+    }
+
+    return success;
+}
+
+// Return the size of a region
+size_t memoryMapRegionSize(const MemoryMap_t *pMap, MemoryMapRegionType_t type)
+{
+    size_t sizeBytes = 0;
+
+    if ((pMap != NULL) && (type < MAX_NUM_MEMORY_MAP_REGIONS))
+    {
+        sizeBytes = pMap->regions[type].pEnd - pMap->regions[type].pStart;
+    }
+
+    return sizeBytes;
+}
+
+// Get the bounds of RAM from the known regions
+bool memoryMapRamBounds(const MemoryMap_t *pMap, char **ppStart, char **ppEnd)
+{
+    char *pStart = NULL;
+    char *pEnd = NULL;
+
+    if (pMap != NULL)
+    {
+        for (uint32_t x = 0; x < MAX_NUM_MEMORY_MAP_REGIONS; x++)
+        {
+            if (pMap->regions[x].pStart != NULL)
+            {
+                if ((pStart == NULL) || (pMap->regions[x].pStart < pStart))
+                {
+                    pStart = pMap->regions[x].pStart;
+                }
+                if ((pEnd == NULL) || (pMap->regions[x].pEnd > pEnd))
+                {
+                    pEnd = pMap->regions[x].pEnd;
+                }
+            }
+        }
+    }
+
+    if ((pStart != NULL) && (ppStart != NULL))
+    {
+        *ppStart = pStart;
+    }
+    if ((pStart != NULL) && (ppEnd != NULL))
+    {
+        *ppEnd = pEnd;
+    }
+
+    return pStart != NULL;
+}
+
+// Find the bounds of RAM by probing
+bool memoryMapProbeRam(const void *pKnown, char **ppStart, char **ppEnd)
+{
+#if MEMORY_MAP_CAN_PROBE
+    // Start from a step boundary inside RAM
+    const char *pBase = (const char *) ((uintptr_t) pKnown & ~((uintptr_t) MEMORY_MAP_PROBE_STEP_BYTES - 1));
+    size_t upBytes = MEMORY_MAP_PROBE_STEP_BYTES;
+    size_t downBytes = 0;
+
+    while ((upBytes < MEMORY_MAP_PROBE_MAX_BYTES) &&
+           probeWord((const volatile uint32_t *) (pBase + upBytes)))
+    {
+        upBytes += MEMORY_MAP_PROBE_STEP_BYTES;
+    }
+    while ((downBytes < MEMORY_MAP_PROBE_MAX_BYTES) &&
+           probeWord((const volatile uint32_t *) (pBase - downBytes - MEMORY_MAP_PROBE_STEP_BYTES)))
+    {
+        downBytes += MEMORY_MAP_PROBE_STEP_BYTES;
+    }
+
+    if (ppStart != NULL)
+    {
+        *ppStart = (char *) pBase - downBytes;
+    }
+    if (ppEnd != NULL)
+    {
+        *ppEnd = (char *) pBase + upBytes;
+    }
+
+    return true;
+#else
+    (void) pKnown;
+    (void) ppStart;
+    (void) ppEnd;
+
+    return false;
+#endif
+}
+
+// Print the regions in address order
+void memoryMapPrint(const MemoryMap_t *pMap)
+{
+    const MemoryMapRegion_t *pSorted[MAX_NUM_MEMORY_MAP_REGIONS];
+    const MemoryMapRegion_t *pTemp;
+    const MemoryMapRegion_t *pPrevious = NULL;
+    uint32_t numKnown = 0;
+
+    if (pMap != NULL)
+    {
+        // Insertion sort of the known regions by start address
+        for (uint32_t x = 0; x < MAX_NUM_MEMORY_MAP_REGIONS; x++)
+        {
+            if (pMap->regions[x].pStart != NULL)
+            {
+                pSorted[numKnown] = &(pMap->regions[x]);
+                for (uint32_t y = numKnown; (y > 0) && (pSorted[y]->pStart < pSorted[y - 1]->pStart); y--)
+                {
+                    pTemp = pSorted[y];
+                    pSorted[y] = pSorted[y - 1];
+                    pSorted[y - 1] = pTemp;
+                }
+                numKnown++;
+            }
+        }
+
+        for (uint32_t x = 0; x < numKnown; x++)
+        {
+            if (pPrevious != NULL)
+            {
+                if (pSorted[x]->pStart > pPrevious->pEnd)
+                {
+                    printf("    %d byte(s) gap.\n", (int) (pSorted[x]->pStart - pPrevious->pEnd));
+                }
+                else if (pSorted[x]->pStart < pPrevious->pEnd)
+                {
+                    printf("    %d byte(s) overlap.\n", (int) (pPrevious->pEnd - pSorted[x]->pStart));
+                }
+            }
+            printf("    %-6s 0x%08" PRIx32 " to 0x%08" PRIx32 ": %d byte(s).\n", pSorted[x]->pName,
+                   (uint32_t) (uintptr_t) pSorted[x]->pStart, (uint32_t) (uintptr_t) pSorted[x]->pEnd, (int) (pSorted[x]->pEnd - pSorted[x]->pStart));
+            pPrevious = pSorted[x];
+        }
+
+        for (uint32_t x = 0; x < MAX_NUM_MEMORY_MAP_REGIONS; x++)
+        {
+            if (pMap->regions[x].pStart == NULL)
+            {
+                printf("    %-6s not known.\n", pMap->regions[x].pName);
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MEMORY_MAP_H_
+#define _MEMORY_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The granularity with which memoryMapProbeRam() looks for the ends
+// of RAM
+#ifndef MEMORY_MAP_PROBE_STEP_BYTES
+# define MEMORY_MAP_PROBE_STEP_BYTES 1024
+#endif
+
+// The furthest memoryMapProbeRam() will look in each direction
+#ifndef MEMORY_MAP_PROBE_MAX_BYTES
+# define MEMORY_MAP_PROBE_MAX_BYTES (1024 * 1024)
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The regions of RAM that the linker lays out
+typedef enum
+{
+    MEMORY_MAP_DATA,
+    MEMORY_MAP_BSS,
+    MEMORY_MAP_HEAP,
+    MEMORY_MAP_STACK,
+    MAX_NUM_MEMORY_MAP_REGIONS
+} MemoryMapRegionType_t;
+
+// A region of RAM, pStart and pEnd both NULL if it is not known
+typedef struct
+{
+    const char * pName;
+    char * pStart;
+    char * pEnd;               // One past the last byte
+} MemoryMapRegion_t;
+
+// The layout of RAM
+typedef struct
+{
+    MemoryMapRegion_t regions[MAX_NUM_MEMORY_MAP_REGIONS];
+} MemoryMap_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Read the layout of RAM from the symbols that the linker provides:
+//
+// - GCC_ARM: __data_start__, __data_end__, __bss_start__, __bss_end__,
+//   __end__, __HeapLimit, __StackLimit and __StackTop from the mbed
+//   linker scripts; where __HeapLimit is no higher than __end__ the
+//   heap may grow up to the bottom of the stack.
+// - ARM: the RW and ZI parts of the RW_IRAM1 execution region, plus
+//   the ARM_LIB_HEAP and ARM_LIB_STACK regions if the scatter file
+//   has them.
+// - IAR: the .data, .bss, HEAP and CSTACK sections.
+//
+// Regions the linker does not say anything about are left NULL.
+// Returns true if at least one region is known.
+bool memoryMapGet(MemoryMap_t *pMap);
+
+// Return the size of a region in bytes, zero if it is not known.
+size_t memoryMapRegionSize(const MemoryMap_t *pMap, MemoryMapRegionType_t type);
+
+// Get the bounds of RAM as the span of the known regions, from the
+// start of the lowest to the end of the highest.
+// Returns true on success, false if no region is known.
+bool memoryMapRamBounds(const MemoryMap_t *pMap, char **ppStart, char **ppEnd);
+
+// Find the bounds of the RAM containing pKnown by reading a word every
+// MEMORY_MAP_PROBE_STEP_BYTES upwards and downwards from it until one
+// causes a bus fault.  Bus faults are suppressed while probing (using
+// FAULTMASK and CCR.BFHFNMIGN) so nothing is disturbed, but this needs
+// a Cortex-M3 or above; on other cores it does nothing.  Parts where
+// reads beyond RAM don't fault will give an answer limited by
+// MEMORY_MAP_PROBE_MAX_BYTES.
+// Returns true on success, false if probing is not supported.
+bool memoryMapProbeRam(const void *pKnown, char **ppStart, char **ppEnd);
+
+// Print the regions in address order, with their sizes and the gaps
+// between them.
+void memoryMapPrint(const MemoryMap_t *pMap);
+
+#endif // _MEMORY_MAP_H_
@@ -0,0 +1,222 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "profiler.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The EXC_RETURN values that the core puts in LR on exception entry
+// have bits 31 to 5 and bit 0 set and bit 1 clear; bit 3 is set if
+// the exception interrupted thread mode and bit 2 if the exception
+// frame went onto the process stack
+#define EXC_RETURN_MASK 0xffffffe3
+#define EXC_RETURN_VALUE 0xffffffe1
+#define EXC_RETURN_THREAD (1 << 3)
+#define EXC_RETURN_PSP (1 << 2)
+
+// The word of an exception frame holding the stacked PC, after R0 to
+// R3, R12 and LR
+#define EXCEPTION_FRAME_PC 6
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A slot of the histogram, empty if count is 0
+typedef struct
+{
+    uintptr_t bucket;          // The lowest address of the bucket
+    uint32_t count;
+} ProfilerSlot_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// Takes the samples
+static Ticker gTicker;
+
+// The histogram, hashed on the bucket
+static ProfilerSlot_t gSlots[PROFILER_NUM_SLOTS];
+
+// The counts kept alongside it
+static ProfilerStats_t gStats;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Find the PC that the ticker interrupt interrupted, and whether that
+// was in a handler.  On entry to the interrupt the core stacked a
+// frame, on the process stack under the RTOS and on the main stack
+// otherwise, and put an EXC_RETURN value in LR saying which; the
+// handler's first function to make a call pushed LR, as the highest
+// register, just below the frame if it is on the main stack.  Look
+// up the main stack, on which this runs, for that.  Returns false if
+// the PC can't be found.
+static bool interruptedPc(uintptr_t *pPc, bool *pInHandler)
+{
+#if defined(MBED_HOST_BUILD)
+    *pPc = hostInterruptedPc();
+    *pInHandler = false;
+
+    return *pPc != 0;
+#else
+    uint32_t *pStack = (uint32_t *) __get_MSP();
+    uint32_t *pFrame = NULL;
+    uint32_t value;
+
+    for (uint32_t x = 0; (x < PROFILER_STACK_SEARCH_WORDS) && (pFrame == NULL); x++)
+    {
+        value = pStack[x];
+        // Returning to a handler on the process stack isn't possible
+        if (((value & EXC_RETURN_MASK) == EXC_RETURN_VALUE) &&
+            (((value & EXC_RETURN_THREAD) != 0) || ((value & EXC_RETURN_PSP) == 0)))
+        {
+            pFrame = ((value & EXC_RETURN_PSP) != 0) ? (uint32_t *) __get_PSP() : pStack + x + 1;
+            *pInHandler = ((value & EXC_RETURN_THREAD) == 0);
+        }
+    }
+
+    if (pFrame != NULL)
+    {
+        *pPc = pFrame[EXCEPTION_FRAME_PC];
+    }
+
+    return pFrame != NULL;
+#endif
+}
+
+// Take a sample, from the ticker interrupt.
+static void sample()
+{
+    uintptr_t pc;
+    uintptr_t bucket;
+    uint32_t slot;
+    bool inHandler = false;
+    bool counted = false;
+
+    gStats.numSamples++;
+    if (interruptedPc(&pc, &inHandler))
+    {
+        if (inHandler)
+        {
+            gStats.numInHandlers++;
+        }
+
+        // Open addressing: consecutive buckets hash to consecutive
+        // slots, so a hot loop doesn't collide with itself
+        bucket = pc & ~((uintptr_t) PROFILER_BUCKET_BYTES - 1);
+        slot = (uint32_t) (bucket / PROFILER_BUCKET_BYTES) & (PROFILER_NUM_SLOTS - 1);
+        for (uint32_t x = 0; (x < PROFILER_MAX_PROBES) && !counted; x++)
+        {
+            if (gSlots[slot].count == 0)
+            {
+                gSlots[slot].bucket = bucket;
+                gStats.numBuckets++;
+            }
+            if (gSlots[slot].bucket == bucket)
+            {
+                gSlots[slot].count++;
+                counted = true;
+            }
+            slot = (slot + 1) & (PROFILER_NUM_SLOTS - 1);
+        }
+
+        if (!counted)
+        {
+            gStats.numDropped++;
+        }
+    }
+    else
+    {
+        gStats.numUnknown++;
+    }
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Start sampling
+void profilerStart(uint32_t periodUs)
+{
+    gStats.periodUs = periodUs;
+    gTicker.attach_us(&sample, periodUs);
+}
+
+// Stop sampling
+void profilerStop()
+{
+    gTicker.detach();
+}
+
+// Empty the histogram
+void profilerReset()
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t periodUs;
+
+    __disable_irq();
+    periodUs = gStats.periodUs;
+    memset(gSlots, 0, sizeof (gSlots));
+    memset(&gStats, 0, sizeof (gStats));
+    gStats.periodUs = periodUs;
+    __set_PRIMASK(primask);
+}
+
+// Get the counts
+void profilerGetStats(ProfilerStats_t *pStats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    if (pStats != NULL)
+    {
+        __disable_irq();
+        *pStats = gStats;
+        __set_PRIMASK(primask);
+    }
+}
+
+// Print the histogram; a slot is copied with interrupts masked and
+// printed with them unmasked, so a sample may land in between
+void profilerPrint(const char *pName)
+{
+    ProfilerStats_t stats;
+    ProfilerSlot_t slot;
+    uint32_t primask = __get_PRIMASK();
+
+    profilerGetStats(&stats);
+    printf("*** Profile of %s: %" PRIu32 " sample(s) every %" PRIu32 " us, %" PRIu32 " in handlers, %" PRIu32 " unknown, %" PRIu32 " dropped, %" PRIu32 " bucket(s) of %d byte(s).\n",
+           pName, stats.numSamples, stats.periodUs, stats.numInHandlers, stats.numUnknown,
+           stats.numDropped, stats.numBuckets, PROFILER_BUCKET_BYTES);
+    for (uint32_t x = 0; x < PROFILER_NUM_SLOTS; x++)
+    {
+        __disable_irq();
+        slot = gSlots[x];
+        __set_PRIMASK(primask);
+        if (slot.count > 0)
+        {
+            printf("    PROFILE 0x%08lx %" PRIu32 "\n", (unsigned long) slot.bucket, slot.count);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A statistical profiler: a Ticker interrupts the running code at a
+// fixed rate and the PC stacked in the exception frame is counted in
+// a histogram of address buckets, so that hot spots show up even on
+// a Cortex-M0, which has no DWT or ITM to do the job.  Print the
+// histogram with profilerPrint() and resolve the buckets against the
+// application's ELF file with tools/profiler/profile.py.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The size of an address bucket, which must be a power of two: the
+// smaller it is, the finer the profile but the more slots it needs
+#ifndef PROFILER_BUCKET_BYTES
+# define PROFILER_BUCKET_BYTES 32
+#endif
+
+// The number of buckets the histogram can hold, which must be a power
+// of two; samples that find no room are counted as dropped
+#ifndef PROFILER_NUM_SLOTS
+# define PROFILER_NUM_SLOTS 128
+#endif
+
+// How many slots a sample looks at before it is dropped
+#ifndef PROFILER_MAX_PROBES
+# define PROFILER_MAX_PROBES 8
+#endif
+
+// How far up the stack, in words, the ticker interrupt looks for the
+// EXC_RETURN value pushed on entry to it, which leads to the frame
+#ifndef PROFILER_STACK_SEARCH_WORDS
+# define PROFILER_STACK_SEARCH_WORDS 128
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The counts kept alongside the histogram
+typedef struct
+{
+    uint32_t periodUs;         // The sampling period, 0 if stopped
+    uint32_t numSamples;       // All samples taken
+    uint32_t numInHandlers;    // Samples that interrupted an interrupt
+    uint32_t numUnknown;       // Samples where the PC couldn't be found
+    uint32_t numDropped;       // Samples that found no free slot
+    uint32_t numBuckets;       // Buckets in the histogram
+} ProfilerStats_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Start sampling every periodUs, adding to the histogram so far.
+void profilerStart(uint32_t periodUs);
+
+// Stop sampling, keeping the histogram.
+void profilerStop(void);
+
+// Empty the histogram.
+void profilerReset(void);
+
+// Get the counts kept alongside the histogram.
+void profilerGetStats(ProfilerStats_t *pStats);
+
+// Print the histogram, headed by pName, as one "PROFILE <address>
+// <count>" line per bucket, for tools/profiler/profile.py.
+void profilerPrint(const char *pName);
+
+#endif // _PROFILER_H_
@@ -0,0 +1,278 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "ram_scrubber.h"
+#include "ram_test.h"
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// Everything the scrubber keeps, in one place so that it can be
+// skipped when the scrubber covers static RAM
+typedef struct
+{
+    RamScrubberRegion_t regions[RAM_SCRUBBER_MAX_NUM_REGIONS];
+    uint32_t numRegions;
+    uint32_t region;           // The region being scrubbed
+    size_t offsetWords;        // How far into that region we are
+    uint32_t sliceIntervalUs;
+    RamScrubberStatus_t status;
+    uint32_t save[RAM_SCRUBBER_MAX_WORDS_PER_SLICE];
+} RamScrubber_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The scrubber
+static RamScrubber_t gScrubber;
+
+// The ticker that drives it
+static Ticker gScrubberTicker;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Return the number of words of a region taken up by the scrubber itself.
+static size_t overlapWords(const RamScrubberRegion_t *pRegion)
+{
+    uint32_t * pStart = pRegion->pStart;
+    uint32_t * pEnd = pRegion->pStart + (pRegion->sizeBytes / sizeof (uint32_t));
+
+    if (pStart < (uint32_t *) &gScrubber)
+    {
+        pStart = (uint32_t *) &gScrubber;
+    }
+    if (pEnd > (uint32_t *) (&gScrubber + 1))
+    {
+        pEnd = (uint32_t *) (&gScrubber + 1);
+    }
+
+    return (pEnd > pStart) ? pEnd - pStart : 0;
+}
+
+// Work out the next chunk to test, moving on to the next region
+// as necessary and stepping around the scrubber's own state.
+// Returns the number of words in the chunk, which starts at
+// *ppChunk, or zero if the end of a sweep has been reached.
+static size_t nextChunk(uint32_t **ppChunk)
+{
+    uint32_t * pSelf = (uint32_t *) &gScrubber;
+    uint32_t * pSelfEnd = (uint32_t *) (&gScrubber + 1);
+    RamScrubberRegion_t * pRegion;
+    uint32_t * pChunk;
+    uint32_t * pEnd;
+    size_t numWords = 0;
+
+    while ((numWords == 0) && (gScrubber.region < gScrubber.numRegions))
+    {
+        pRegion = &gScrubber.regions[gScrubber.region];
+        pChunk = pRegion->pStart + gScrubber.offsetWords;
+        pEnd = pRegion->pStart + (pRegion->sizeBytes / sizeof (uint32_t));
+        if (pEnd > pChunk + gScrubber.status.wordsPerSlice)
+        {
+            pEnd = pChunk + gScrubber.status.wordsPerSlice;
+        }
+
+        if ((pChunk >= pSelf) && (pChunk < pSelfEnd))
+        {
+            // Skip over ourselves
+            if (pEnd > pSelfEnd)
+            {
+                pChunk = pSelfEnd;
+            }
+            else
+            {
+                pChunk = pEnd;
+            }
+        }
+        else if ((pEnd > pSelf) && (pChunk < pSelf))
+        {
+            // Stop short of ourselves
+            pEnd = pSelf;
+        }
+
+        if (pEnd > pChunk)
+        {
+            numWords = pEnd - pChunk;
+            *ppChunk = pChunk;
+        }
+
+        // Move on, including past anything skipped
+        gScrubber.offsetWords = pEnd - pRegion->pStart;
+        if (gScrubber.offsetWords >= pRegion->sizeBytes / sizeof (uint32_t))
+        {
+            gScrubber.region++;
+            gScrubber.offsetWords = 0;
+        }
+    }
+
+    return numWords;
+}
+
+// Ticker callback.
+static void tick()
+{
+    ramScrubberSlice();
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up the scrubber
+bool ramScrubberInit(const RamScrubberRegion_t *pRegions, uint32_t numRegions,
+                     uint32_t periodSeconds, uint32_t sliceIntervalUs)
+{
+    uint64_t numSlices;
+    bool success = false;
+
+    if ((pRegions != NULL) && (numRegions > 0) && (numRegions <= RAM_SCRUBBER_MAX_NUM_REGIONS) &&
+        (periodSeconds > 0) && (sliceIntervalUs > 0))
+    {
+        ramScrubberStop();
+        memset(&gScrubber, 0, sizeof (gScrubber));
+
+        for (uint32_t x = 0; x < numRegions; x++)
+        {
+            gScrubber.regions[x] = pRegions[x];
+            gScrubber.status.totalWords += pRegions[x].sizeBytes / sizeof (uint32_t);
+            gScrubber.status.totalWords -= overlapWords(&pRegions[x]);
+        }
+        gScrubber.numRegions = numRegions;
+        gScrubber.sliceIntervalUs = sliceIntervalUs;
+
+        // Work out how many words to test per slice
+        numSlices = ((uint64_t) periodSeconds * 1000000) / sliceIntervalUs;
+        if (numSlices == 0)
+        {
+            numSlices = 1;
+        }
+        gScrubber.status.wordsPerSlice = (uint32_t) ((gScrubber.status.totalWords + numSlices - 1) / numSlices);
+        if (gScrubber.status.wordsPerSlice > RAM_SCRUBBER_MAX_WORDS_PER_SLICE)
+        {
+            gScrubber.status.wordsPerSlice = RAM_SCRUBBER_MAX_WORDS_PER_SLICE;
+        }
+        if (gScrubber.status.wordsPerSlice == 0)
+        {
+            gScrubber.status.wordsPerSlice = 1;
+        }
+
+        success = true;
+    }
+
+    return success;
+}
+
+// Test the next slice of RAM
+bool ramScrubberSlice()
+{
+    uint32_t * pChunk = NULL;
+    uint32_t * pFailure;
+    size_t numWords;
+    uint32_t primask;
+    uint32_t startUs;
+    uint32_t sliceUs;
+    bool success = false;
+
+    if (gScrubber.numRegions > 0)
+    {
+        numWords = nextChunk(&pChunk);
+        if (numWords == 0)
+        {
+            // End of a sweep, start again
+            gScrubber.status.sweepsCompleted++;
+            gScrubber.status.sweepWords = 0;
+            gScrubber.region = 0;
+            gScrubber.offsetWords = 0;
+            numWords = nextChunk(&pChunk);
+        }
+
+        success = true;
+        if (numWords > 0)
+        {
+            // Nothing that might live in the chunk, e.g. the HAL's
+            // ticker state, may be used between the save and the
+            // restore, hence the timing outside them
+            startUs = us_ticker_read();
+            primask = __get_PRIMASK();
+            __disable_irq();
+
+            memcpy(gScrubber.save, pChunk, numWords * sizeof (uint32_t));
+            pFailure = ramTestMarchCMinusWords(pChunk, numWords);
+            memcpy(pChunk, gScrubber.save, numWords * sizeof (uint32_t));
+
+            __set_PRIMASK(primask);
+            sliceUs = us_ticker_read() - startUs;
+            success = (pFailure == NULL);
+
+            gScrubber.status.numSlices++;
+            gScrubber.status.sweepWords += numWords;
+            if (gScrubber.status.totalWords > 0)
+            {
+                gScrubber.status.coveragePercent = (uint32_t) (((uint64_t) gScrubber.status.sweepWords * 100) /
+                                                               gScrubber.status.totalWords);
+            }
+            if (sliceUs > gScrubber.status.worstSliceUs)
+            {
+                gScrubber.status.worstSliceUs = sliceUs;
+            }
+            if (!success)
+            {
+                gScrubber.status.numFailures++;
+                if (gScrubber.status.pFirstFailure == NULL)
+                {
+                    gScrubber.status.pFirstFailure = pFailure;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+// Start the scrubber ticker
+void ramScrubberStart()
+{
+    if ((gScrubber.numRegions > 0) && (gScrubber.sliceIntervalUs > 0))
+    {
+        gScrubberTicker.attach_us(&tick, gScrubber.sliceIntervalUs);
+    }
+}
+
+// Stop the scrubber ticker
+void ramScrubberStop()
+{
+    gScrubberTicker.detach();
+}
+
+// Get the state of the scrubber
+void ramScrubberGetStatus(RamScrubberStatus_t *pStatus)
+{
+    uint32_t primask;
+
+    if (pStatus != NULL)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        *pStatus = gScrubber.status;
+        __set_PRIMASK(primask);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _RAM_SCRUBBER_H_
+#define _RAM_SCRUBBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The largest number of words the scrubber will test in one slice;
+// this sets the size of the save buffer and bounds the time for
+// which interrupts are masked
+#ifndef RAM_SCRUBBER_MAX_WORDS_PER_SLICE
+# define RAM_SCRUBBER_MAX_WORDS_PER_SLICE 32
+#endif
+
+// The maximum number of regions the scrubber can cover
+#ifndef RAM_SCRUBBER_MAX_NUM_REGIONS
+# define RAM_SCRUBBER_MAX_NUM_REGIONS 4
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A region of RAM for the scrubber to cover
+typedef struct
+{
+    uint32_t * pStart;
+    size_t sizeBytes;
+} RamScrubberRegion_t;
+
+// The state of the scrubber
+typedef struct
+{
+    uint32_t totalWords;       // The number of words covered in a sweep
+    uint32_t wordsPerSlice;    // The number of words tested per slice
+    uint32_t sweepWords;       // The number of words tested so far in
+                               // the current sweep
+    uint32_t coveragePercent;  // sweepWords as a percentage of totalWords
+    uint32_t sweepsCompleted;  // The number of complete sweeps
+    uint32_t numSlices;        // The number of slices run in total
+    uint32_t worstSliceUs;     // The longest slice so far, i.e. the longest
+                               // time interrupts have been masked
+    uint32_t numFailures;      // The number of failed slices
+    uint32_t * pFirstFailure;  // The first location to fail, NULL if none
+} RamScrubberStatus_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up the scrubber to cover numRegions regions of RAM, each of
+// which must be word aligned and none of which may contain the stack
+// that ramScrubberSlice() will be called on.  The scrubber's own
+// state is skipped automatically.  The number of words tested per
+// slice is chosen so that all of the regions are covered once every
+// periodSeconds given a slice every sliceIntervalUs, limited to
+// RAM_SCRUBBER_MAX_WORDS_PER_SLICE (in which case a sweep will take
+// longer: the actual figure is in the status).
+// Returns true on success, false if the parameters were bad.
+bool ramScrubberInit(const RamScrubberRegion_t *pRegions, uint32_t numRegions,
+                     uint32_t periodSeconds, uint32_t sliceIntervalUs);
+
+// Test the next slice of RAM: the words are saved, tested and restored
+// with interrupts masked for that slice only.  Call this from an idle
+// hook, or let ramScrubberStart() call it from a ticker.
+// Returns true if the slice was good, false if a failure was found or
+// the scrubber has not been initialised.
+bool ramScrubberSlice(void);
+
+// Call ramScrubberSlice() from a ticker every sliceIntervalUs, as passed
+// to ramScrubberInit().
+void ramScrubberStart(void);
+
+// Stop the ticker started by ramScrubberStart().
+void ramScrubberStop(void);
+
+// Get the state of the scrubber.
+void ramScrubberGetStatus(RamScrubberStatus_t *pStatus);
+
+#endif // _RAM_SCRUBBER_H_
@@ -0,0 +1,1052 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "ram_test.h"
+#include "cpu_info.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// GENERAL COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The maximum number of operations in a march element
+#define MARCH_MAX_NUM_OPS 6
+
+// The background written for a "0" in march notation, "1" being the
+// inverse of it
+#define MARCH_BACKGROUND 0x00000000
+
+// The number of words moved by one burst of the block kernels
+#define RAM_TEST_BURST_WORDS 4
+
+// Use the LDM/STM assembler kernels where the toolchain can build them
+// (GCC, Thumb), otherwise the portable C++ ones; define
+// RAM_TEST_PORTABLE_KERNELS to force the latter
+#if defined(__GNUC__) && defined(__thumb__) && !defined(__ARMCC_VERSION) && !defined(RAM_TEST_PORTABLE_KERNELS)
+# define RAM_TEST_ASM_KERNELS
+#endif
+
+// The number of times each kernel is run by ramTestBenchmark()
+#ifndef RAM_TEST_BENCHMARK_ITERATIONS
+# define RAM_TEST_BENCHMARK_ITERATIONS 10
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// An operation in a march element
+typedef enum
+{
+    MARCH_R0,
+    MARCH_R1,
+    MARCH_W0,
+    MARCH_W1
+} MarchOp_t;
+
+// The order in which a march element visits the words
+typedef enum
+{
+    MARCH_UP,   // Ascending addresses (also used for "either")
+    MARCH_DOWN  // Descending addresses
+} MarchOrder_t;
+
+// A march element: a sequence of operations applied to each word
+// in turn before moving on to the next
+typedef struct
+{
+    MarchOrder_t order;
+    uint8_t numOps;
+    MarchOp_t ops[MARCH_MAX_NUM_OPS];
+} MarchElement_t;
+
+// A march test: a sequence of march elements
+typedef struct
+{
+    uint8_t numElements;
+    const MarchElement_t * pElements;
+} MarchTest_t;
+
+// A set of the block kernels below
+typedef struct
+{
+    const char * pName;
+    void (*pFillBursts)(uint32_t *pMem, size_t numBursts, uint32_t value);
+    uint32_t * (*pVerifyBursts)(uint32_t *pMem, size_t numBursts, uint32_t value);
+    void (*pWriteWalkingBursts)(uint32_t *pMem, size_t numBursts, uint32_t value);
+    uint32_t * (*pVerifyWalkingBursts)(uint32_t *pMem, size_t numBursts, uint32_t value);
+} RamTestKernels_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// MATS+: {b(w0); u(r0,w1); d(r1,w0)}
+static const MarchElement_t gMatsPlus[] = {{MARCH_UP, 1, {MARCH_W0}},
+                                           {MARCH_UP, 2, {MARCH_R0, MARCH_W1}},
+                                           {MARCH_DOWN, 2, {MARCH_R1, MARCH_W0}}};
+
+// March C-: {b(w0); u(r0,w1); u(r1,w0); d(r0,w1); d(r1,w0); b(r0)}
+static const MarchElement_t gMarchCMinus[] = {{MARCH_UP, 1, {MARCH_W0}},
+                                              {MARCH_UP, 2, {MARCH_R0, MARCH_W1}},
+                                              {MARCH_UP, 2, {MARCH_R1, MARCH_W0}},
+                                              {MARCH_DOWN, 2, {MARCH_R0, MARCH_W1}},
+                                              {MARCH_DOWN, 2, {MARCH_R1, MARCH_W0}},
+                                              {MARCH_UP, 1, {MARCH_R0}}};
+
+// March B: {b(w0); u(r0,w1,r1,w0,r0,w1); u(r1,w0,w1); d(r1,w0,w1,w0); d(r0,w1,w0)}
+static const MarchElement_t gMarchB[] = {{MARCH_UP, 1, {MARCH_W0}},
+                                         {MARCH_UP, 6, {MARCH_R0, MARCH_W1, MARCH_R1, MARCH_W0, MARCH_R0, MARCH_W1}},
+                                         {MARCH_UP, 3, {MARCH_R1, MARCH_W0, MARCH_W1}},
+                                         {MARCH_DOWN, 4, {MARCH_R1, MARCH_W0, MARCH_W1, MARCH_W0}},
+                                         {MARCH_DOWN, 3, {MARCH_R0, MARCH_W1, MARCH_W0}}};
+
+// The march tests, indexed by RamTestAlgorithm_t (the walking test is
+// not a march test and so has no elements)
+static const MarchTest_t gMarchTests[] = {{0, NULL},
+                                          {sizeof (gMatsPlus) / sizeof (gMatsPlus[0]), gMatsPlus},
+                                          {sizeof (gMarchCMinus) / sizeof (gMarchCMinus[0]), gMarchCMinus},
+                                          {sizeof (gMarchB) / sizeof (gMarchB[0]), gMarchB}};
+
+// The names of the tests, indexed by RamTestAlgorithm_t
+static const char * gRamTestNames[] = {"walking 1", "MATS+", "March C-", "March B"};
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Record a failure in the result.
+static void fail(RamTestResult_t *pResult, uint32_t *pLocation, uint32_t expected)
+{
+    pResult->pFailure = pLocation;
+    pResult->expected = expected;
+    pResult->actual = *pLocation;
+}
+
+// Rotate a word left.
+static inline uint32_t rotateLeft(uint32_t value, uint32_t bits)
+{
+    bits &= 31;
+    return (value << bits) | (value >> ((32 - bits) & 31));
+}
+
+// ----------------------------------------------------------------
+// BLOCK KERNELS
+// ----------------------------------------------------------------
+
+// Each of the *Bursts() kernels below works on numBursts (which must
+// be non-zero) bursts of RAM_TEST_BURST_WORDS words; the word-wise
+// functions that follow them deal with any remainder.  The walking
+// pattern is the sequence 1, 2, 4, ... 0x80000000, 1, ... (or its
+// inverse), i.e. each word is the previous one rotated left by one,
+// so a burst can be written from four precomputed pattern registers
+// which are then all rotated by four.  There are LDM/STM assembler
+// versions, where the toolchain can build them, and portable ones;
+// ramTestSelectKernels() picks the set to use at run time.
+
+#ifdef RAM_TEST_ASM_KERNELS
+
+// Fill bursts with value using STM.
+static void fillBurstsLdmStm(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    register uint32_t * r0 asm("r0") = pMem;
+    register uint32_t r1 asm("r1") = numBursts;
+    register uint32_t r2 asm("r2") = value;
+    register uint32_t r3 asm("r3") = value;
+    register uint32_t r4 asm("r4") = value;
+    register uint32_t r5 asm("r5") = value;
+
+    asm volatile (".syntax unified\n\t"
+                  "1:\n\t"
+                  "stmia %0!, {r2-r5}\n\t"
+                  "subs %1, #1\n\t"
+                  "bne 1b\n"
+                  : "+l" (r0), "+l" (r1)
+                  : "l" (r2), "l" (r3), "l" (r4), "l" (r5)
+                  : "cc", "memory");
+}
+
+// Check that bursts contain value using LDM.  Returns a pointer
+// to the first burst that does not, else NULL.
+static uint32_t * verifyBurstsLdmStm(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    register uint32_t * r0 asm("r0") = pMem;
+    register uint32_t * r1 asm("r1") = pMem + (numBursts * RAM_TEST_BURST_WORDS);
+    register uint32_t r2 asm("r2");
+    register uint32_t r6 asm("r6") = value;
+
+    asm volatile (".syntax unified\n\t"
+                  "1:\n\t"
+                  "ldmia %0!, {r2-r5}\n\t"
+                  "eors r2, %3\n\t"
+                  "eors r3, %3\n\t"
+                  "eors r4, %3\n\t"
+                  "eors r5, %3\n\t"
+                  "orrs r2, r3\n\t"
+                  "orrs r2, r4\n\t"
+                  "orrs r2, r5\n\t"
+                  "bne 2f\n\t"
+                  "cmp %0, %2\n\t"
+                  "bne 1b\n"
+                  "2:\n"
+                  : "+l" (r0), "=l" (r2)
+                  : "l" (r1), "l" (r6)
+                  : "r3", "r4", "r5", "cc", "memory");
+
+    return (r2 != 0) ? r0 - RAM_TEST_BURST_WORDS : NULL;
+}
+
+// Write bursts of the walking pattern, starting with value, using STM.
+static void writeWalkingBurstsLdmStm(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    register uint32_t * r0 asm("r0") = pMem;
+    register uint32_t r1 asm("r1") = numBursts;
+    register uint32_t r2 asm("r2") = value;
+    register uint32_t r3 asm("r3") = rotateLeft(value, 1);
+    register uint32_t r4 asm("r4") = rotateLeft(value, 2);
+    register uint32_t r5 asm("r5") = rotateLeft(value, 3);
+    register uint32_t r6 asm("r6") = 32 - RAM_TEST_BURST_WORDS;
+
+    asm volatile (".syntax unified\n\t"
+                  "1:\n\t"
+                  "stmia %0!, {r2-r5}\n\t"
+                  "rors %2, %6\n\t"
+                  "rors %3, %6\n\t"
+                  "rors %4, %6\n\t"
+                  "rors %5, %6\n\t"
+                  "subs %1, #1\n\t"
+                  "bne 1b\n"
+                  : "+l" (r0), "+l" (r1), "+l" (r2), "+l" (r3), "+l" (r4), "+l" (r5)
+                  : "l" (r6)
+                  : "cc", "memory");
+}
+
+// Check bursts of the walking pattern, starting with value, using LDM.
+// Returns a pointer to the first burst that does not match, else NULL.
+static uint32_t * verifyWalkingBurstsLdmStm(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    register uint32_t * r0 asm("r0") = pMem;
+    register uint32_t r1 asm("r1") = 31;
+    register uint32_t r2 asm("r2");
+    register uint32_t r6 asm("r6") = value;
+    register uint32_t * r8 asm("r8") = pMem + (numBursts * RAM_TEST_BURST_WORDS);
+
+    // ARMv6-M has too few low registers to hold four expected
+    // values as well, so the expected value is rotated word by word
+    asm volatile (".syntax unified\n\t"
+                  "1:\n\t"
+                  "ldmia %0!, {r2-r5}\n\t"
+                  "eors r2, %2\n\t"
+                  "rors %2, %3\n\t"
+                  "eors r3, %2\n\t"
+                  "rors %2, %3\n\t"
+                  "eors r4, %2\n\t"
+                  "rors %2, %3\n\t"
+                  "eors r5, %2\n\t"
+                  "rors %2, %3\n\t"
+                  "orrs r2, r3\n\t"
+                  "orrs r2, r4\n\t"
+                  "orrs r2, r5\n\t"
+                  "bne 2f\n\t"
+                  "cmp %0, %4\n\t"
+                  "bne 1b\n"
+                  "2:\n"
+                  : "+l" (r0), "=l" (r2), "+l" (r6)
+                  : "l" (r1), "r" (r8)
+                  : "r3", "r4", "r5", "cc", "memory");
+
+    return (r2 != 0) ? r0 - RAM_TEST_BURST_WORDS : NULL;
+}
+
+#endif
+
+// Fill bursts with value.
+static void fillBurstsPortable(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    for (; numBursts > 0; numBursts--)
+    {
+        pMem[0] = value;
+        pMem[1] = value;
+        pMem[2] = value;
+        pMem[3] = value;
+        pMem += RAM_TEST_BURST_WORDS;
+    }
+}
+
+// Check that bursts contain value.  Returns a pointer to the first
+// burst that does not, else NULL.
+static uint32_t * verifyBurstsPortable(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    for (; numBursts > 0; numBursts--)
+    {
+        if (((pMem[0] ^ value) | (pMem[1] ^ value) | (pMem[2] ^ value) | (pMem[3] ^ value)) != 0)
+        {
+            return pMem;
+        }
+        pMem += RAM_TEST_BURST_WORDS;
+    }
+
+    return NULL;
+}
+
+// Write bursts of the walking pattern, starting with value.
+static void writeWalkingBurstsPortable(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    uint32_t a = value;
+    uint32_t b = rotateLeft(value, 1);
+    uint32_t c = rotateLeft(value, 2);
+    uint32_t d = rotateLeft(value, 3);
+
+    for (; numBursts > 0; numBursts--)
+    {
+        pMem[0] = a;
+        pMem[1] = b;
+        pMem[2] = c;
+        pMem[3] = d;
+        pMem += RAM_TEST_BURST_WORDS;
+        a = rotateLeft(a, RAM_TEST_BURST_WORDS);
+        b = rotateLeft(b, RAM_TEST_BURST_WORDS);
+        c = rotateLeft(c, RAM_TEST_BURST_WORDS);
+        d = rotateLeft(d, RAM_TEST_BURST_WORDS);
+    }
+}
+
+// Check bursts of the walking pattern, starting with value.  Returns
+// a pointer to the first burst that does not match, else NULL.
+static uint32_t * verifyWalkingBurstsPortable(uint32_t *pMem, size_t numBursts, uint32_t value)
+{
+    uint32_t a = value;
+    uint32_t b = rotateLeft(value, 1);
+    uint32_t c = rotateLeft(value, 2);
+    uint32_t d = rotateLeft(value, 3);
+
+    for (; numBursts > 0; numBursts--)
+    {
+        if (((pMem[0] ^ a) | (pMem[1] ^ b) | (pMem[2] ^ c) | (pMem[3] ^ d)) != 0)
+        {
+            return pMem;
+        }
+        pMem += RAM_TEST_BURST_WORDS;
+        a = rotateLeft(a, RAM_TEST_BURST_WORDS);
+        b = rotateLeft(b, RAM_TEST_BURST_WORDS);
+        c = rotateLeft(c, RAM_TEST_BURST_WORDS);
+        d = rotateLeft(d, RAM_TEST_BURST_WORDS);
+    }
+
+    return NULL;
+}
+
+// The sets of block kernels
+static const RamTestKernels_t gPortableKernels = {"portable",
+                                                  fillBurstsPortable,
+                                                  verifyBurstsPortable,
+                                                  writeWalkingBurstsPortable,
+                                                  verifyWalkingBurstsPortable};
+#ifdef RAM_TEST_ASM_KERNELS
+static const RamTestKernels_t gLdmStmKernels = {"LDM/STM",
+                                                fillBurstsLdmStm,
+                                                verifyBurstsLdmStm,
+                                                writeWalkingBurstsLdmStm,
+                                                verifyWalkingBurstsLdmStm};
+#endif
+
+// The set in use, see ramTestSelectKernels()
+#ifdef RAM_TEST_ASM_KERNELS
+static const RamTestKernels_t * gpKernels = &gLdmStmKernels;
+#else
+static const RamTestKernels_t * gpKernels = &gPortableKernels;
+#endif
+
+// Fill numWords words with value.
+static void fillWords(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    size_t numBursts = numWords / RAM_TEST_BURST_WORDS;
+
+    if (numBursts > 0)
+    {
+        gpKernels->pFillBursts(pMem, numBursts, value);
+        pMem += numBursts * RAM_TEST_BURST_WORDS;
+    }
+
+    for (numWords -= numBursts * RAM_TEST_BURST_WORDS; numWords > 0; numWords--)
+    {
+        *pMem++ = value;
+    }
+}
+
+// Check that numWords words contain value.  Returns a pointer to
+// the first word that does not, else NULL.
+static uint32_t * verifyWords(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    uint32_t * pEnd = pMem + numWords;
+    size_t numBursts = numWords / RAM_TEST_BURST_WORDS;
+    uint32_t * pBad;
+
+    if (numBursts > 0)
+    {
+        pBad = gpKernels->pVerifyBursts(pMem, numBursts, value);
+        if (pBad != NULL)
+        {
+            // Narrow it down to the word
+            pEnd = pBad + RAM_TEST_BURST_WORDS;
+        }
+        else
+        {
+            pMem += numBursts * RAM_TEST_BURST_WORDS;
+        }
+    }
+
+    for (; pMem < pEnd; pMem++)
+    {
+        if (*pMem != value)
+        {
+            return pMem;
+        }
+    }
+
+    return NULL;
+}
+
+// Write the walking pattern, starting with value, to numWords words.
+static void writeWalkingWords(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    size_t numBursts = numWords / RAM_TEST_BURST_WORDS;
+
+    if (numBursts > 0)
+    {
+        gpKernels->pWriteWalkingBursts(pMem, numBursts, value);
+        pMem += numBursts * RAM_TEST_BURST_WORDS;
+        value = rotateLeft(value, numBursts * RAM_TEST_BURST_WORDS);
+    }
+
+    for (numWords -= numBursts * RAM_TEST_BURST_WORDS; numWords > 0; numWords--)
+    {
+        *pMem++ = value;
+        value = rotateLeft(value, 1);
+    }
+}
+
+// Check numWords words of the walking pattern, starting with value.
+// Returns a pointer to the first word that does not match, else NULL.
+static uint32_t * verifyWalkingWords(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    uint32_t * pEnd = pMem + numWords;
+    size_t numBursts = numWords / RAM_TEST_BURST_WORDS;
+    uint32_t * pBad;
+
+    if (numBursts > 0)
+    {
+        pBad = gpKernels->pVerifyWalkingBursts(pMem, numBursts, value);
+        if (pBad != NULL)
+        {
+            pEnd = pBad + RAM_TEST_BURST_WORDS;
+            value = rotateLeft(value, pBad - pMem);
+            pMem = pBad;
+        }
+        else
+        {
+            pMem += numBursts * RAM_TEST_BURST_WORDS;
+            value = rotateLeft(value, numBursts * RAM_TEST_BURST_WORDS);
+        }
+    }
+
+    for (; pMem < pEnd; pMem++)
+    {
+        if (*pMem != value)
+        {
+            return pMem;
+        }
+        value = rotateLeft(value, 1);
+    }
+
+    return NULL;
+}
+
+// Apply a (read, write) march element to numWords words, in ascending
+// or descending order.  Bursts cannot be used here since every word
+// must be read and written before the next is touched, otherwise
+// coupling faults between neighbours would go unseen, but unrolling
+// still removes most of the loop overhead.  Returns a pointer to the
+// first word that did not contain expected, else NULL.
+static uint32_t * readWriteWords(uint32_t *pMem, size_t numWords, uint32_t expected,
+                                 uint32_t written, MarchOrder_t order)
+{
+    uint32_t * pLocation;
+
+    if (order == MARCH_DOWN)
+    {
+        for (pLocation = pMem + numWords; numWords >= 4; numWords -= 4)
+        {
+            pLocation -= 4;
+            if (pLocation[3] != expected)
+            {
+                return pLocation + 3;
+            }
+            pLocation[3] = written;
+            if (pLocation[2] != expected)
+            {
+                return pLocation + 2;
+            }
+            pLocation[2] = written;
+            if (pLocation[1] != expected)
+            {
+                return pLocation + 1;
+            }
+            pLocation[1] = written;
+            if (pLocation[0] != expected)
+            {
+                return pLocation;
+            }
+            pLocation[0] = written;
+        }
+        while (numWords > 0)
+        {
+            pLocation--;
+            numWords--;
+            if (*pLocation != expected)
+            {
+                return pLocation;
+            }
+            *pLocation = written;
+        }
+    }
+    else
+    {
+        for (pLocation = pMem; numWords >= 4; numWords -= 4)
+        {
+            if (pLocation[0] != expected)
+            {
+                return pLocation;
+            }
+            pLocation[0] = written;
+            if (pLocation[1] != expected)
+            {
+                return pLocation + 1;
+            }
+            pLocation[1] = written;
+            if (pLocation[2] != expected)
+            {
+                return pLocation + 2;
+            }
+            pLocation[2] = written;
+            if (pLocation[3] != expected)
+            {
+                return pLocation + 3;
+            }
+            pLocation[3] = written;
+            pLocation += 4;
+        }
+        for (; numWords > 0; numWords--)
+        {
+            if (*pLocation != expected)
+            {
+                return pLocation;
+            }
+            *pLocation = written;
+            pLocation++;
+        }
+    }
+
+    return NULL;
+}
+
+// ----------------------------------------------------------------
+// ALGORITHMS
+// ----------------------------------------------------------------
+
+// Write a walking 1 pattern, or its inverse, and read it back.
+static bool walking(uint32_t *pMem, size_t numWords, uint32_t invert, RamTestResult_t *pResult)
+{
+    uint32_t * pBad;
+
+    writeWalkingWords(pMem, numWords, 1 ^ invert);
+    pBad = verifyWalkingWords(pMem, numWords, 1 ^ invert);
+
+    pResult->passes += 2;
+    pResult->bytesTouched += numWords * sizeof (*pMem);
+    if (pBad != NULL)
+    {
+        pResult->bytesTouched += (pBad - pMem + 1) * sizeof (*pMem);
+        fail(pResult, pBad, rotateLeft(1 ^ invert, pBad - pMem));
+    }
+    else
+    {
+        pResult->bytesTouched += numWords * sizeof (*pMem);
+    }
+
+    return pResult->pFailure == NULL;
+}
+
+// Return the value a march operation reads or writes.
+static inline uint32_t marchValue(MarchOp_t op)
+{
+    return ((op == MARCH_R0) || (op == MARCH_W0)) ? MARCH_BACKGROUND : ~MARCH_BACKGROUND;
+}
+
+// Run one march element over the memory, a word at a time, touching
+// nothing but the words, the element and expected, so that it can run
+// over any part of RAM (see ramTestMarchCMinusWords()).
+// Returns NULL if the words are good, else the failing location, with
+// the value that should have been read there in *pExpected.
+static uint32_t * marchElementWords(const MarchElement_t *pElement, uint32_t *pMem, size_t numWords, uint32_t *pExpected)
+{
+    volatile uint32_t * pLocation;
+    int32_t step = 1;
+
+    pLocation = pMem;
+    if (pElement->order == MARCH_DOWN)
+    {
+        pLocation = pMem + numWords - 1;
+        step = -1;
+    }
+
+    for (size_t x = 0; x < numWords; x++)
+    {
+        for (uint8_t y = 0; y < pElement->numOps; y++)
+        {
+            switch (pElement->ops[y])
+            {
+                case MARCH_R0:
+                case MARCH_R1:
+                    if (*pLocation != marchValue(pElement->ops[y]))
+                    {
+                        *pExpected = marchValue(pElement->ops[y]);
+                        return (uint32_t *) pLocation;
+                    }
+                    break;
+                case MARCH_W0:
+                case MARCH_W1:
+                    *pLocation = marchValue(pElement->ops[y]);
+                    break;
+            }
+        }
+        pLocation += step;
+    }
+
+    return NULL;
+}
+
+// Run one march element over the memory, a word at a time.
+static bool marchElementGeneric(const MarchElement_t *pElement, uint32_t *pMem, size_t numWords, RamTestResult_t *pResult)
+{
+    uint32_t * pBad;
+    uint32_t expected;
+    size_t numWordsDone = numWords;
+
+    pBad = marchElementWords(pElement, pMem, numWords, &expected);
+    if (pBad != NULL)
+    {
+        numWordsDone = (pElement->order == MARCH_DOWN) ? (size_t) (pMem + numWords - pBad) : (size_t) (pBad - pMem + 1);
+        fail(pResult, pBad, expected);
+    }
+    pResult->bytesTouched += numWordsDone * pElement->numOps * sizeof (*pMem);
+    pResult->passes++;
+
+    return pResult->pFailure == NULL;
+}
+
+// Run one march element over the memory, using the block kernels for
+// the common shapes of element and the generic version for the rest.
+static bool marchElement(const MarchElement_t *pElement, uint32_t *pMem, size_t numWords, RamTestResult_t *pResult)
+{
+    MarchOp_t first = pElement->ops[0];
+    uint32_t * pBad = NULL;
+    size_t numWordsDone = numWords;
+
+    if ((pElement->numOps == 1) && ((first == MARCH_W0) || (first == MARCH_W1)))
+    {
+        // The order of a pure write element makes no difference
+        fillWords(pMem, numWords, marchValue(first));
+    }
+    else if ((pElement->numOps == 1) && ((first == MARCH_R0) || (first == MARCH_R1)))
+    {
+        // Neither does that of a pure read element
+        pBad = verifyWords(pMem, numWords, marchValue(first));
+        if (pBad != NULL)
+        {
+            numWordsDone = pBad - pMem + 1;
+        }
+    }
+    else if ((pElement->numOps == 2) && ((first == MARCH_R0) || (first == MARCH_R1)) &&
+             ((pElement->ops[1] == MARCH_W0) || (pElement->ops[1] == MARCH_W1)))
+    {
+        pBad = readWriteWords(pMem, numWords, marchValue(first), marchValue(pElement->ops[1]), pElement->order);
+        if (pBad != NULL)
+        {
+            numWordsDone = (pElement->order == MARCH_DOWN) ? pMem + numWords - pBad : pBad - pMem + 1;
+        }
+    }
+    else
+    {
+        return marchElementGeneric(pElement, pMem, numWords, pResult);
+    }
+
+    pResult->passes++;
+    pResult->bytesTouched += numWordsDone * pElement->numOps * sizeof (*pMem);
+    if (pBad != NULL)
+    {
+        fail(pResult, pBad, marchValue(first));
+    }
+
+    return pResult->pFailure == NULL;
+}
+
+// Walk a 1 across the data bus at pAddress: this finds data lines
+// that are stuck or shorted together with just 32 writes.
+static bool dataBus(volatile uint32_t *pAddress, RamTestResult_t *pResult)
+{
+    for (uint32_t pattern = 1; (pattern != 0) && (pResult->pFailure == NULL); pattern <<= 1)
+    {
+        *pAddress = pattern;
+        if (*pAddress != pattern)
+        {
+            fail(pResult, (uint32_t *) pAddress, pattern);
+        }
+        pResult->bytesTouched += 2 * sizeof (*pAddress);
+    }
+
+    pResult->passes++;
+
+    return pResult->pFailure == NULL;
+}
+
+// Test the address lines that vary across numWords words at pMem by
+// writing only to the power-of-two word offsets: this finds address
+// lines that are stuck high, stuck low or shorted together in
+// O(log n) rather than O(n) accesses.
+static bool addressBus(volatile uint32_t *pMem, size_t numWords, RamTestResult_t *pResult)
+{
+    uint32_t pattern = 0xAAAAAAAA;
+    uint32_t antiPattern = 0x55555555;
+    size_t offset;
+    size_t testOffset;
+
+    // Write the default pattern at each power-of-two offset
+    for (offset = 1; offset < numWords; offset <<= 1)
+    {
+        pMem[offset] = pattern;
+        pResult->bytesTouched += sizeof (*pMem);
+    }
+
+    // Check for address lines stuck high
+    pMem[0] = antiPattern;
+    pResult->bytesTouched += sizeof (*pMem);
+    for (offset = 1; (offset < numWords) && (pResult->pFailure == NULL); offset <<= 1)
+    {
+        if (pMem[offset] != pattern)
+        {
+            fail(pResult, (uint32_t *) &pMem[offset], pattern);
+        }
+        pResult->bytesTouched += sizeof (*pMem);
+    }
+    pMem[0] = pattern;
+    pResult->bytesTouched += sizeof (*pMem);
+
+    // Check for address lines stuck low or shorted
+    for (testOffset = 1; (testOffset < numWords) && (pResult->pFailure == NULL); testOffset <<= 1)
+    {
+        pMem[testOffset] = antiPattern;
+        pResult->bytesTouched += sizeof (*pMem);
+        for (offset = 0; (offset < numWords) && (pResult->pFailure == NULL); offset = (offset == 0) ? 1 : offset << 1)
+        {
+            if ((offset != testOffset) && (pMem[offset] != pattern))
+            {
+                fail(pResult, (uint32_t *) &pMem[offset], pattern);
+            }
+            pResult->bytesTouched += sizeof (*pMem);
+        }
+        pMem[testOffset] = pattern;
+        pResult->bytesTouched += sizeof (*pMem);
+    }
+
+    pResult->passes++;
+
+    return pResult->pFailure == NULL;
+}
+
+// ----------------------------------------------------------------
+// REFERENCE LOOPS FOR BENCHMARKING
+// ----------------------------------------------------------------
+
+// The word-at-a-time walking 1 write loop that checkRam() used to run.
+static void writeWalkingReference(uint32_t *pMem, size_t numWords)
+{
+    uint32_t value = 1;
+
+    for (uint32_t * pLocation = pMem; pLocation < pMem + numWords; pLocation++)
+    {
+        *pLocation = value;
+        value <<= 1;
+        if (value == 0)
+        {
+            value = 1;
+        }
+    }
+}
+
+// The word-at-a-time walking 1 read loop that checkRam() used to run.
+static uint32_t * verifyWalkingReference(uint32_t *pMem, size_t numWords)
+{
+    uint32_t * pLocation;
+    uint32_t value = 1;
+
+    for (pLocation = pMem; (pLocation < pMem + numWords) && (*pLocation == value); pLocation++)
+    {
+        value <<= 1;
+        if (value == 0)
+        {
+            value = 1;
+        }
+    }
+
+    return (pLocation < pMem + numWords) ? pLocation : NULL;
+}
+
+// A word-at-a-time fill loop.
+static void fillReference(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    for (uint32_t * pLocation = pMem; pLocation < pMem + numWords; pLocation++)
+    {
+        *pLocation = value;
+    }
+}
+
+// A word-at-a-time verify loop.
+static uint32_t * verifyReference(uint32_t *pMem, size_t numWords, uint32_t value)
+{
+    uint32_t * pLocation;
+
+    for (pLocation = pMem; (pLocation < pMem + numWords) && (*pLocation == value); pLocation++)
+    {
+    }
+
+    return (pLocation < pMem + numWords) ? pLocation : NULL;
+}
+
+// Print one line of benchmark results.
+static void printBenchmark(const char *pName, size_t numBytes, uint32_t referenceUs, uint32_t kernelUs)
+{
+    printf("    %-14s %8" PRIu32 " us (reference) %8" PRIu32 " us (kernel)", pName, referenceUs, kernelUs);
+    if (kernelUs > 0)
+    {
+        printf(", x%" PRIu32 ".%02" PRIu32, referenceUs / kernelUs, ((referenceUs % kernelUs) * 100) / kernelUs);
+    }
+    if (referenceUs > 0)
+    {
+        printf(", %" PRIu32 " -> %" PRIu32 " kbytes/s", (uint32_t) (((uint64_t) numBytes * 1000) / referenceUs),
+               (kernelUs > 0) ? (uint32_t) (((uint64_t) numBytes * 1000) / kernelUs) : 0);
+    }
+    printf(".\n");
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Return the name of a RAM test algorithm
+const char * ramTestName(RamTestAlgorithm_t algorithm)
+{
+    const char * pName = "unknown";
+
+    if ((uint32_t) algorithm < sizeof (gRamTestNames) / sizeof (gRamTestNames[0]))
+    {
+        pName = gRamTestNames[algorithm];
+    }
+
+    return pName;
+}
+
+// Run a RAM test
+bool ramTest(RamTestAlgorithm_t algorithm, uint32_t *pMem,
+             size_t memorySizeBytes, RamTestResult_t *pResult)
+{
+    size_t numWords = memorySizeBytes / sizeof (*pMem);
+    const MarchTest_t * pTest;
+    uint32_t startUs;
+    bool success = false;
+
+    if (pResult != NULL)
+    {
+        memset(pResult, 0, sizeof (*pResult));
+    }
+
+    if ((pMem != NULL) && (pResult != NULL) && ((uint32_t) algorithm < MAX_NUM_RAM_TESTS))
+    {
+        success = true;
+
+        startUs = us_ticker_read();
+        if (algorithm == RAM_TEST_WALKING)
+        {
+            success = walking(pMem, numWords, 0, pResult) &&
+                      walking(pMem, numWords, 0xFFFFFFFF, pResult);
+        }
+        else
+        {
+            pTest = &gMarchTests[algorithm];
+            for (uint8_t x = 0; (x < pTest->numElements) && success; x++)
+            {
+                success = marchElement(&pTest->pElements[x], pMem, numWords, pResult);
+            }
+        }
+        pResult->elapsedUs = us_ticker_read() - startUs;
+    }
+
+    return success;
+}
+
+// Run the data bus and address bus tests
+bool ramTestBus(uint32_t *pMem, size_t memorySizeBytes, RamTestResult_t *pResult)
+{
+    size_t numWords = memorySizeBytes / sizeof (*pMem);
+    uint32_t startUs;
+    bool success = false;
+
+    if (pResult != NULL)
+    {
+        memset(pResult, 0, sizeof (*pResult));
+    }
+
+    if ((pMem != NULL) && (numWords > 0) && (pResult != NULL))
+    {
+        startUs = us_ticker_read();
+        success = dataBus(pMem, pResult) && addressBus(pMem, numWords, pResult);
+        pResult->elapsedUs = us_ticker_read() - startUs;
+    }
+
+    return success;
+}
+
+// Run March C- a word at a time, touching nothing but the words
+uint32_t * ramTestMarchCMinusWords(uint32_t *pMem, size_t numWords)
+{
+    uint32_t * pBad = NULL;
+    uint32_t expected;
+
+    for (size_t x = 0; (x < sizeof (gMarchCMinus) / sizeof (gMarchCMinus[0])) && (pBad == NULL); x++)
+    {
+        pBad = marchElementWords(&gMarchCMinus[x], pMem, numWords, &expected);
+    }
+
+    return pBad;
+}
+
+// Pick the block kernels for the core
+void ramTestSelectKernels(const CpuInfo_t *pCpu)
+{
+    gpKernels = &gPortableKernels;
+#ifdef RAM_TEST_ASM_KERNELS
+    // LDM/STM moves a burst in one instruction, which is the quickest
+    // way up to the Cortex-M4, but the Cortex-M7 can't dual-issue
+    // them, while it can the loads and stores of the portable kernels
+    if ((pCpu == NULL) || (pCpu->core != CPU_CORE_M7))
+    {
+        gpKernels = &gLdmStmKernels;
+    }
+#else
+    (void) pCpu;
+#endif
+}
+
+// Return the name of the block kernels in use
+const char * ramTestKernelsName()
+{
+    return gpKernels->pName;
+}
+
+// Benchmark the block kernels against the word-at-a-time loops
+void ramTestBenchmark(uint32_t *pMem, size_t memorySizeBytes)
+{
+    size_t numWords = memorySizeBytes / sizeof (*pMem);
+    size_t numBytes = numWords * sizeof (*pMem) * RAM_TEST_BENCHMARK_ITERATIONS;
+    uint32_t referenceUs;
+    uint32_t kernelUs;
+    uint32_t startUs;
+    bool good = true;
+
+    if ((pMem != NULL) && (numWords > 0))
+    {
+        printf("*** Benchmarking RAM test kernels (%s) over %d byte(s), %d iteration(s).\n",
+               gpKernels->pName, (int) (numWords * sizeof (*pMem)), RAM_TEST_BENCHMARK_ITERATIONS);
+
+        // Walking 1 write
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            writeWalkingReference(pMem, numWords);
+        }
+        referenceUs = us_ticker_read() - startUs;
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            writeWalkingWords(pMem, numWords, 1);
+        }
+        kernelUs = us_ticker_read() - startUs;
+        printBenchmark("walking write", numBytes, referenceUs, kernelUs);
+
+        // Walking 1 verify
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            good = (verifyWalkingReference(pMem, numWords) == NULL) && good;
+        }
+        referenceUs = us_ticker_read() - startUs;
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            good = (verifyWalkingWords(pMem, numWords, 1) == NULL) && good;
+        }
+        kernelUs = us_ticker_read() - startUs;
+        printBenchmark("walking verify", numBytes, referenceUs, kernelUs);
+
+        // Solid fill
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            fillReference(pMem, numWords, ~MARCH_BACKGROUND);
+        }
+        referenceUs = us_ticker_read() - startUs;
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            fillWords(pMem, numWords, ~MARCH_BACKGROUND);
+        }
+        kernelUs = us_ticker_read() - startUs;
+        printBenchmark("solid fill", numBytes, referenceUs, kernelUs);
+
+        // Solid verify
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            good = (verifyReference(pMem, numWords, ~MARCH_BACKGROUND) == NULL) && good;
+        }
+        referenceUs = us_ticker_read() - startUs;
+        startUs = us_ticker_read();
+        for (uint32_t x = 0; x < RAM_TEST_BENCHMARK_ITERATIONS; x++)
+        {
+            good = (verifyWords(pMem, numWords, ~MARCH_BACKGROUND) == NULL) && good;
+        }
+        kernelUs = us_ticker_read() - startUs;
+        printBenchmark("solid verify", numBytes, referenceUs, kernelUs);
+
+        if (!good)
+        {
+            printf("!!! RAM changed under the benchmark, results are not valid.\n");
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _RAM_TEST_H_
+#define _RAM_TEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu_info.h"
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The RAM test algorithms available; the number in brackets is the
+// cost in operations per word
+typedef enum
+{
+    RAM_TEST_WALKING,       // Walking 1 then inverted walking 1 (4n),
+                            // finds stuck-at faults only
+    RAM_TEST_MATS_PLUS,     // MATS+ (5n), finds stuck-at and address
+                            // decoder faults
+    RAM_TEST_MARCH_C_MINUS, // March C- (10n), as MATS+ plus transition
+                            // and unlinked coupling faults
+    RAM_TEST_MARCH_B,       // March B (17n), as March C- plus linked
+                            // transition and coupling faults
+    MAX_NUM_RAM_TESTS
+} RamTestAlgorithm_t;
+
+// The outcome of a RAM test
+typedef struct
+{
+    uint32_t passes;          // The number of sweeps through the memory
+    uint32_t bytesTouched;    // The number of bytes read plus written
+    uint32_t elapsedUs;       // How long the test took
+    uint32_t * pFailure;      // The first failing location, NULL if none
+    uint32_t expected;        // What was expected at pFailure
+    uint32_t actual;          // What was read from pFailure
+} RamTestResult_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Return the name of a RAM test algorithm.
+const char * ramTestName(RamTestAlgorithm_t algorithm);
+
+// Run the given RAM test algorithm over memorySizeBytes of RAM
+// starting at pMem, which must be word aligned.  The contents of
+// the RAM are destroyed.  The test stops at the first failure.
+// Returns true if the RAM is good, false if not (or if the
+// parameters were bad), with the details in pResult.
+bool ramTest(RamTestAlgorithm_t algorithm, uint32_t *pMem,
+             size_t memorySizeBytes, RamTestResult_t *pResult);
+
+// Run the quick data bus and address bus tests over memorySizeBytes
+// of RAM starting at pMem, which must be word aligned: a walking 1 on
+// the first word, then a test of the address lines that vary across
+// the block using only the power-of-two word offsets.  This takes
+// O(log n) accesses and finds wiring and decoder faults, so it makes
+// a good pre-filter for ramTest().  The contents of those words are
+// destroyed.  Returns true if the buses are good, false if not (or if
+// the parameters were bad), with the details in pResult.
+bool ramTestBus(uint32_t *pMem, size_t memorySizeBytes, RamTestResult_t *pResult);
+
+// Run March C- ({b(w0); u(r0,w1); u(r1,w0); d(r0,w1); d(r1,w0); b(r0)})
+// over numWords words at pMem, which must be word aligned, a word at a
+// time.  Unlike ramTest() this touches nothing but its arguments, its
+// locals and the constant description of the test (no block kernels,
+// no us_ticker, no result), so the words may be any part of RAM, even
+// the state of this module or of the HAL; the background RAM scrubber
+// relies on this.  The contents of the words are destroyed.
+// Returns NULL if the words are good, else the first failing location.
+uint32_t * ramTestMarchCMinusWords(uint32_t *pMem, size_t numWords);
+
+// Pick the fastest of the block write and verify kernels used by
+// ramTest() for the given core.  Until this is called the LDM/STM
+// kernels are used where the toolchain can build them.
+void ramTestSelectKernels(const CpuInfo_t *pCpu);
+
+// Return the name of the block kernels in use, e.g. "LDM/STM".
+const char * ramTestKernelsName(void);
+
+// Time the block write and verify kernels used by ramTest() against
+// word-at-a-time loops, for each pattern, over memorySizeBytes of RAM
+// starting at pMem, and print the results.  The contents of the RAM
+// are destroyed.
+void ramTestBenchmark(uint32_t *pMem, size_t memorySizeBytes);
+
+#endif // _RAM_TEST_H_
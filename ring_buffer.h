@@ -0,0 +1,130 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _RING_BUFFER_H_
+#define _RING_BUFFER_H_
+
+#include "mbed.h"
+
+// A lock-free single-producer/single-consumer ring buffer of bytes:
+// one context (e.g. an interrupt handler) may call put()/write() while
+// another (e.g. the main loop) calls get()/read() without any locking.
+// The head index is written only by the producer and the tail index
+// only by the consumer; both run freely and wrap naturally, so SIZE
+// must be a power of two.
+template <uint32_t SIZE>
+class RingBuffer
+{
+public:
+    RingBuffer() : _head(0), _tail(0) {}
+
+    // The number of bytes waiting to be read
+    uint32_t used() const
+    {
+        return _head - _tail;
+    }
+
+    // The number of bytes that can be written
+    uint32_t space() const
+    {
+        return SIZE - used();
+    }
+
+    // Producer: add one byte, returns false if the buffer is full
+    bool put(uint8_t c)
+    {
+        uint32_t head = _head;
+
+        if (head - _tail >= SIZE)
+        {
+            return false;
+        }
+        _buf[head & (SIZE - 1)] = c;
+        __DMB();
+        _head = head + 1;
+
+        return true;
+    }
+
+    // Consumer: remove one byte, returns false if the buffer is empty
+    bool get(uint8_t *pC)
+    {
+        uint32_t tail = _tail;
+
+        if (_head == tail)
+        {
+            return false;
+        }
+        *pC = _buf[tail & (SIZE - 1)];
+        __DMB();
+        _tail = tail + 1;
+
+        return true;
+    }
+
+    // Producer: add up to size bytes, publishing them all at once,
+    // returns the number added
+    uint32_t write(const uint8_t *pBuf, uint32_t size)
+    {
+        uint32_t head = _head;
+        uint32_t count = SIZE - (head - _tail);
+
+        if (count > size)
+        {
+            count = size;
+        }
+        for (uint32_t x = 0; x < count; x++)
+        {
+            _buf[(head + x) & (SIZE - 1)] = pBuf[x];
+        }
+        __DMB();
+        _head = head + count;
+
+        return count;
+    }
+
+    // Consumer: remove up to size bytes, releasing the space all at
+    // once, returns the number removed
+    uint32_t read(uint8_t *pBuf, uint32_t size)
+    {
+        uint32_t tail = _tail;
+        uint32_t count = _head - tail;
+
+        if (count > size)
+        {
+            count = size;
+        }
+        for (uint32_t x = 0; x < count; x++)
+        {
+            pBuf[x] = _buf[(tail + x) & (SIZE - 1)];
+        }
+        __DMB();
+        _tail = tail + count;
+
+        return count;
+    }
+
+private:
+    // Fails to compile if SIZE is not a power of two
+    typedef char SizeMustBeAPowerOfTwo[((SIZE != 0) && ((SIZE & (SIZE - 1)) == 0)) ? 1 : -1];
+
+    uint8_t _buf[SIZE];
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+};
+
+#endif // _RING_BUFFER_H_
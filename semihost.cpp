@@ -0,0 +1,91 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "semihost.h"
+
+#include <stdint.h>
+
+#ifdef SEMIHOSTING
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Semihosting operations
+#define SEMIHOST_SYS_WRITE0 0x04
+#define SEMIHOST_SYS_EXIT 0x18
+
+// Reasons passed to SEMIHOST_SYS_EXIT
+#define SEMIHOST_ADP_STOPPED_APPLICATION_EXIT 0x20026
+#define SEMIHOST_ADP_STOPPED_RUN_TIME_ERROR 0x20023
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Make a semihosting call: on M-profile cores this is BKPT 0xAB with
+// the operation in r0 and its parameter in r1, the result coming
+// back in r0
+static int semihostCall(int operation, const void *pParam)
+{
+#if defined(__GNUC__) && defined(__arm__) && !defined(__ARMCC_VERSION)
+    register int r0 asm("r0") = operation;
+    register const void *r1 asm("r1") = pParam;
+
+    asm volatile ("bkpt 0xab"
+                  : "+r" (r0)
+                  : "r" (r1)
+                  : "memory");
+
+    return r0;
+#elif defined(__ARMCC_VERSION)
+    return __semihost(operation, pParam);
+#else
+    (void) operation;
+    (void) pParam;
+    return -1;
+#endif
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Write a string to the host's console
+void semihostWrite(const char *pString)
+{
+    semihostCall(SEMIHOST_SYS_WRITE0, pString);
+}
+
+// Mark the start of a stage
+extern "C" void semihostStageMark(const char *pName)
+{
+    semihostWrite("STAGE ");
+    semihostWrite(pName);
+    semihostWrite("\n");
+}
+
+// Tell the host that we're done
+void semihostExit(bool success)
+{
+    semihostCall(SEMIHOST_SYS_EXIT,
+                 (const void *) (uintptr_t) (success ? SEMIHOST_ADP_STOPPED_APPLICATION_EXIT :
+                                                      SEMIHOST_ADP_STOPPED_RUN_TIME_ERROR));
+    while (1) {}
+}
+
+#endif // SEMIHOSTING
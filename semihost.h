@@ -0,0 +1,46 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SEMIHOST_H_
+#define _SEMIHOST_H_
+
+#include <stdbool.h>
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// ARM semihosting, for running under an emulator (e.g. QEMU with
+// -semihosting) or a debugger; these are only implemented when
+// SEMIHOSTING is defined and will hang (or fault) if nothing is
+// there to service them.
+
+// Write a null-terminated string to the host's console.
+void semihostWrite(const char *pString);
+
+// Mark the start of a stage of the application, writing
+// "STAGE <pName>" to the host's console.  This function is kept
+// out-of-line so that an instruction-counting emulator plugin can
+// find it by address and attribute the instructions executed between
+// marks to the stage that was started.
+extern "C" void semihostStageMark(const char *pName);
+
+// Tell the host that the application has finished, successfully or
+// otherwise; an emulator will exit with a zero or non-zero status.
+void semihostExit(bool success);
+
+#endif // _SEMIHOST_H_
@@ -0,0 +1,198 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "stack_paint.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A stack that has been painted
+typedef struct
+{
+    const char * pName;
+    uint32_t * pBottom;
+    size_t sizeBytes;
+} StackPaintStack_t;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The stacks that have been painted
+static StackPaintStack_t gStacks[STACK_PAINT_MAX_NUM_STACKS];
+
+// The number of entries in gStacks
+static uint32_t gNumStacks = 0;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// If address is inside [pBottom, pTop) and below *ppLimit, move
+// *ppLimit down to STACK_PAINT_MARGIN_BYTES below it; the address is
+// an integer since it need not point into the stack at all
+static void limitTo(uintptr_t address, uint32_t *pBottom, uint32_t *pTop, uint32_t **ppLimit)
+{
+    if ((address >= (uintptr_t) pBottom) && (address < (uintptr_t) pTop) && (address < (uintptr_t) *ppLimit))
+    {
+        *ppLimit = pBottom;
+        if (address - (uintptr_t) pBottom > STACK_PAINT_MARGIN_BYTES)
+        {
+            *ppLimit = pBottom + ((address - (uintptr_t) pBottom - STACK_PAINT_MARGIN_BYTES) / sizeof (uint32_t));
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Add a stack and paint it
+bool stackPaintAdd(const char *pName, uint32_t *pBottom, size_t sizeBytes)
+{
+    uint32_t here;
+    uint32_t *pTop;
+    uint32_t *pLimit;
+    uint32_t primask;
+    bool success = false;
+
+    if ((pBottom != NULL) && (((uintptr_t) pBottom & (sizeof (uint32_t) - 1)) == 0) &&
+        (sizeBytes >= sizeof (uint32_t)) && (gNumStacks < STACK_PAINT_MAX_NUM_STACKS))
+    {
+        pTop = pBottom + (sizeBytes / sizeof (uint32_t));
+
+        // Interrupts could push onto the stack below the stack pointer
+        // while it is being painted, so mask them
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        // Leave alone anything above the current stack pointer, or
+        // the interrupt stack pointer if they are different
+        pLimit = pTop;
+        limitTo((uintptr_t) &here, pBottom, pTop, &pLimit);
+        limitTo(__get_MSP(), pBottom, pTop, &pLimit);
+        for (uint32_t *p = pBottom; p < pLimit; p++)
+        {
+            *p = STACK_PAINT_SENTINEL;
+        }
+
+        __set_PRIMASK(primask);
+
+        gStacks[gNumStacks].pName = pName;
+        gStacks[gNumStacks].pBottom = pBottom;
+        gStacks[gNumStacks].sizeBytes = sizeBytes & ~(sizeof (uint32_t) - 1);
+        gNumStacks++;
+        success = true;
+    }
+
+    return success;
+}
+
+// Return the number of stacks
+uint32_t stackPaintNumStacks()
+{
+    return gNumStacks;
+}
+
+// Measure the high-water mark of a stack
+bool stackPaintMeasure(uint32_t index, StackPaintInfo_t *pInfo)
+{
+    const StackPaintStack_t *pStack;
+    uint32_t *pTop;
+    uint32_t *p;
+    bool success = false;
+
+    if ((index < gNumStacks) && (pInfo != NULL))
+    {
+        pStack = &(gStacks[index]);
+        pTop = pStack->pBottom + (pStack->sizeBytes / sizeof (uint32_t));
+        for (p = pStack->pBottom; (p < pTop) && (*p == STACK_PAINT_SENTINEL); p++)
+        {
+        }
+
+        pInfo->pName = pStack->pName;
+        pInfo->pBottom = pStack->pBottom;
+        pInfo->sizeBytes = pStack->sizeBytes;
+        pInfo->freeBytes = (p - pStack->pBottom) * sizeof (uint32_t);
+        pInfo->peakBytes = pStack->sizeBytes - pInfo->freeBytes;
+        success = true;
+    }
+
+    return success;
+}
+
+// Print the usage of all the stacks
+void stackPaintPrint()
+{
+    StackPaintInfo_t info;
+
+    for (uint32_t x = 0; stackPaintMeasure(x, &info); x++)
+    {
+        printf("    %s stack, 0x%08" PRIx32 " to 0x%08" PRIx32 ": %d byte(s), peak %d byte(s) used (%" PRIu32 "%%), %d byte(s) free.\n",
+               info.pName, (uint32_t) (uintptr_t) info.pBottom, (uint32_t) ((uintptr_t) info.pBottom + info.sizeBytes), (int) info.sizeBytes,
+               (int) info.peakBytes, (uint32_t) (((uint64_t) info.peakBytes * 100) / info.sizeBytes), (int) info.freeBytes);
+    }
+}
+
+// Measure the stack used by a call
+size_t stackPaintMeasureCall(void (*pFunction)(void *pParam), void *pParam, size_t maxBytes)
+{
+    uintptr_t sp;
+    size_t unpaintedBytes = 0;
+    uint32_t *pTop;
+    uint32_t *pBottom;
+    uint32_t *p;
+    uint32_t primask;
+
+    // Paint down from the stack pointer, where the frame of pFunction
+    // will start: nothing of this frame lies below it.  Where it can't
+    // be read, paint from the margin below a local instead, clear of
+    // the rest of this frame, and count the margin as used
+#if defined(__CC_ARM)
+    sp = (uintptr_t) __current_sp();
+#elif defined(__GNUC__) && (defined(__arm__) || defined(__aarch64__))
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+#elif defined(__GNUC__) && defined(__x86_64__)
+    __asm volatile ("mov %%rsp, %0" : "=r" (sp));
+#elif defined(__GNUC__) && defined(__i386__)
+    __asm volatile ("mov %%esp, %0" : "=r" (sp));
+#else
+    uint32_t here;
+    sp = (uintptr_t) &here - STACK_PAINT_MARGIN_BYTES;
+    unpaintedBytes = STACK_PAINT_MARGIN_BYTES;
+#endif
+    pTop = (uint32_t *) (sp & ~(uintptr_t) (sizeof (uint32_t) - 1));
+    pBottom = pTop - (maxBytes / sizeof (uint32_t));
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (p = pBottom; p < pTop; p++)
+    {
+        *p = STACK_PAINT_SENTINEL;
+    }
+    pFunction(pParam);
+    for (p = pBottom; (p < pTop) && (*p == STACK_PAINT_SENTINEL); p++)
+    {
+    }
+    __set_PRIMASK(primask);
+
+    return (pTop - p) * sizeof (uint32_t) + unpaintedBytes;
+}
@@ -0,0 +1,101 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _STACK_PAINT_H_
+#define _STACK_PAINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The value unused stack is painted with; this is the value the mbed
+// RTOS Thread class paints its stacks with, so that the two agree
+#ifndef STACK_PAINT_SENTINEL
+# define STACK_PAINT_SENTINEL 0xE25A2EA5
+#endif
+
+// The maximum number of stacks that can be painted
+#ifndef STACK_PAINT_MAX_NUM_STACKS
+# define STACK_PAINT_MAX_NUM_STACKS 4
+#endif
+
+// The number of bytes left unpainted below the stack pointer when
+// painting a stack that is in use, to allow for the painting
+// function's own frame
+#ifndef STACK_PAINT_MARGIN_BYTES
+# define STACK_PAINT_MARGIN_BYTES 64
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// The usage of a painted stack
+typedef struct
+{
+    const char * pName;
+    uint32_t * pBottom;        // The lowest address of the stack
+    size_t sizeBytes;
+    size_t peakBytes;          // The most that has been used since
+                               // painting, the high-water mark
+    size_t freeBytes;          // The least there has been free
+} StackPaintInfo_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Add a (full-descending) stack and paint the unused part of it with
+// STACK_PAINT_SENTINEL.  If the stack is the one in use, or is the
+// interrupt stack, only the part below the stack pointer is painted,
+// with interrupts masked.  pBottom must be word aligned and pName
+// must remain valid.  Call this as early as possible, e.g. first thing
+// in main().
+// Returns true on success, false if the parameters were bad or
+// STACK_PAINT_MAX_NUM_STACKS stacks have already been added.
+bool stackPaintAdd(const char *pName, uint32_t *pBottom, size_t sizeBytes);
+
+// Return the number of stacks added.
+uint32_t stackPaintNumStacks(void);
+
+// Measure the high-water mark of a stack, scanning word-wise up from
+// the bottom for the first word that is no longer the sentinel; a
+// bisection would be quicker but can be fooled by a local variable
+// that was never written.
+// Returns true on success, false if index is out of range.
+bool stackPaintMeasure(uint32_t index, StackPaintInfo_t *pInfo);
+
+// Measure and print the usage of all the stacks.
+void stackPaintPrint(void);
+
+// Measure how much stack a call of pFunction(pParam) uses: the
+// maxBytes of the current stack below the stack pointer are painted,
+// the call is made and the painted area is scanned as by
+// stackPaintMeasure().  Interrupts are masked throughout, so that they
+// don't add to the answer, and hence pFunction must not wait for one.
+// There must be maxBytes of stack free.  With a compiler whose stack
+// pointer can't be read here, painting starts STACK_PAINT_MARGIN_BYTES
+// below a local instead and the margin is counted as used, so the
+// answer can be high by up to that much.
+// Returns the number of bytes used, which includes the frame of
+// pFunction itself; if it is maxBytes the call may have used more.
+size_t stackPaintMeasureCall(void (*pFunction)(void *pParam), void *pParam, size_t maxBytes);
+
+#endif // _STACK_PAINT_H_
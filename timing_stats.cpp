@@ -0,0 +1,115 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "timing_stats.h"
+
+#include <inttypes.h>
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Clear a set of statistics
+void timingStatsInit(TimingStats_t *pStats, int32_t binWidthUs)
+{
+    if (pStats != NULL)
+    {
+        memset(pStats, 0, sizeof (*pStats));
+        pStats->binWidthUs = (binWidthUs > 0) ? binWidthUs : 1;
+        pStats->minUs = INT32_MAX;
+        pStats->maxUs = INT32_MIN;
+    }
+}
+
+// Add a measurement
+void timingStatsAdd(TimingStats_t *pStats, int32_t valueUs)
+{
+    int32_t bin;
+
+    if (valueUs < pStats->minUs)
+    {
+        pStats->minUs = valueUs;
+    }
+    if (valueUs > pStats->maxUs)
+    {
+        pStats->maxUs = valueUs;
+    }
+    pStats->sumUs += valueUs;
+    pStats->count++;
+
+    // Bin zero covers [0, binWidthUs), with the bins for negative
+    // values below it
+    bin = valueUs / pStats->binWidthUs;
+    if ((valueUs < 0) && (valueUs % pStats->binWidthUs != 0))
+    {
+        bin--;
+    }
+    bin += TIMING_STATS_NUM_BINS / 2;
+    if (bin < 0)
+    {
+        bin = 0;
+    }
+    if (bin >= TIMING_STATS_NUM_BINS)
+    {
+        bin = TIMING_STATS_NUM_BINS - 1;
+    }
+    pStats->bins[bin]++;
+}
+
+// Print the statistics
+void timingStatsPrint(const TimingStats_t *pStats, const char *pName)
+{
+    int32_t lowerUs;
+    int64_t meanTenthsUs;
+
+    if (pStats != NULL)
+    {
+        if (pStats->count == 0)
+        {
+            printf("    %s: no measurements.\n", pName);
+        }
+        else
+        {
+            meanTenthsUs = (pStats->sumUs * 10) / (int64_t) pStats->count;
+            printf("    %s: %" PRIu32 " measurement(s), min %ld us, max %ld us, mean %s%ld.%ld us.\n",
+                   pName, pStats->count, (long) pStats->minUs, (long) pStats->maxUs,
+                   (meanTenthsUs < 0) ? "-" : "",
+                   (long) ((meanTenthsUs < 0 ? -meanTenthsUs : meanTenthsUs) / 10),
+                   (long) ((meanTenthsUs < 0 ? -meanTenthsUs : meanTenthsUs) % 10));
+            for (int32_t x = 0; x < TIMING_STATS_NUM_BINS; x++)
+            {
+                if (pStats->bins[x] > 0)
+                {
+                    lowerUs = (x - (TIMING_STATS_NUM_BINS / 2)) * pStats->binWidthUs;
+                    if (x == 0)
+                    {
+                        printf("             < %6ld us: %" PRIu32 "\n", (long) (lowerUs + pStats->binWidthUs), pStats->bins[x]);
+                    }
+                    else if (x == TIMING_STATS_NUM_BINS - 1)
+                    {
+                        printf("            >= %6ld us: %" PRIu32 "\n", (long) lowerUs, pStats->bins[x]);
+                    }
+                    else
+                    {
+                        printf("      %6ld to %6ld us: %" PRIu32 "\n", (long) lowerUs, (long) (lowerUs + pStats->binWidthUs - 1), pStats->bins[x]);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TIMING_STATS_H_
+#define _TIMING_STATS_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The number of histogram bins; the first and last also catch
+// everything below and above the range of the others
+#ifndef TIMING_STATS_NUM_BINS
+# define TIMING_STATS_NUM_BINS 16
+#endif
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// Statistics on a set of signed timing measurements, e.g. the error
+// in a period, in microseconds
+typedef struct
+{
+    int32_t binWidthUs;    // The width of each histogram bin
+    int32_t minUs;
+    int32_t maxUs;
+    int64_t sumUs;
+    uint32_t count;
+    uint32_t bins[TIMING_STATS_NUM_BINS]; // Centred on zero
+} TimingStats_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Clear a set of statistics, setting the histogram bin width.
+void timingStatsInit(TimingStats_t *pStats, int32_t binWidthUs);
+
+// Add a measurement; this is short enough to call from an interrupt.
+void timingStatsAdd(TimingStats_t *pStats, int32_t valueUs);
+
+// Print the statistics, with pName as a heading.
+void timingStatsPrint(const TimingStats_t *pStats, const char *pName);
+
+#endif // _TIMING_STATS_H_
@@ -0,0 +1,668 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The block layout and algorithms follow the TLSF paper, "TLSF: a New
+// Dynamic Memory Allocator for Real-Time Systems" (Masmano, Ripoll,
+// Crespo and Real), in the form popularised by Matthew Conte's
+// implementation.
+//
+// Every block starts with its size, the bottom two bits of which say
+// whether the block is free and whether the block before it is free,
+// padded out to TLSF_ALIGN_SIZE so that the data after it is aligned.
+// The word before that is a pointer to the previous block, only valid
+// when that block is free (otherwise it is the last word of that
+// block's data).  Free blocks also keep the free list pointers in
+// what would be their data.  The pool ends with a zero-sized, used,
+// sentinel block.
+
+#include "mbed.h"
+#include "tlsf.h"
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The flags in the bottom bits of a block's size
+#define BLOCK_FREE_BIT ((size_t) 1)
+#define BLOCK_PREV_FREE_BIT ((size_t) 2)
+
+// The overhead of an allocated block: the size and its padding
+#define BLOCK_OVERHEAD_BYTES TLSF_ALIGN_SIZE
+
+// The offset from the start of a block to its data
+#define BLOCK_START_OFFSET_BYTES offsetof(TlsfBlock_t, pNextFree)
+
+// The smallest block: enough for the free list pointers and the next
+// block's pPrevPhys, rounded up to the alignment
+#define BLOCK_SIZE_MIN_BYTES ((sizeof (TlsfBlock_t *) * 3 + TLSF_ALIGN_SIZE - 1) & ~((size_t) TLSF_ALIGN_SIZE - 1))
+
+// The limit on the size of a block, which must be less than this so
+// that its first-level index is in range
+#define BLOCK_SIZE_MAX_BYTES ((size_t) 1 << TLSF_FL_INDEX_MAX)
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A block
+struct TlsfBlockTag
+{
+    TlsfBlock_t * pPrevPhys;   // Only valid if the previous block is free
+    size_t size;               // Plus BLOCK_FREE_BIT and BLOCK_PREV_FREE_BIT
+    char pad[TLSF_ALIGN_SIZE - sizeof (size_t)]; // Aligns what follows
+    TlsfBlock_t * pNextFree;   // Only valid if this block is free
+    TlsfBlock_t * pPrevFree;   // Ditto
+};
+
+// Fails to compile if the padding has not made the overhead of a block
+// TLSF_ALIGN_SIZE
+typedef char TlsfBlockOverheadMustBeTheAlignment[(BLOCK_START_OFFSET_BYTES - offsetof(TlsfBlock_t, size) == BLOCK_OVERHEAD_BYTES) ? 1 : -1];
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS: BIT TWIDDLING
+// ----------------------------------------------------------------
+
+// Return the index of the lowest set bit in a non-zero word
+static int findFirstSet(uint32_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(word);
+#else
+    int bit = 0;
+
+    while ((word & 1) == 0)
+    {
+        word >>= 1;
+        bit++;
+    }
+
+    return bit;
+#endif
+}
+
+// Return the index of the highest set bit in a non-zero size
+static int findLastSet(size_t size)
+{
+#if defined(__GNUC__)
+    return (int) (sizeof (unsigned long) * 8) - 1 - __builtin_clzl((unsigned long) size);
+#else
+    int bit = -1;
+
+    while (size != 0)
+    {
+        size >>= 1;
+        bit++;
+    }
+
+    return bit;
+#endif
+}
+
+// Round a size up to the alignment
+static size_t alignUp(size_t size)
+{
+    return (size + (TLSF_ALIGN_SIZE - 1)) & ~((size_t) TLSF_ALIGN_SIZE - 1);
+}
+
+// Round a size down to the alignment
+static size_t alignDown(size_t size)
+{
+    return size & ~((size_t) TLSF_ALIGN_SIZE - 1);
+}
+
+// Turn a requested size into a block size, zero if it is impossible
+static size_t adjustRequestSize(size_t size)
+{
+    size_t adjusted = 0;
+
+    if ((size > 0) && (size < BLOCK_SIZE_MAX_BYTES))
+    {
+        adjusted = alignUp(size);
+        if (adjusted < BLOCK_SIZE_MIN_BYTES)
+        {
+            adjusted = BLOCK_SIZE_MIN_BYTES;
+        }
+    }
+
+    return adjusted;
+}
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS: BLOCKS
+// ----------------------------------------------------------------
+
+static size_t blockSize(const TlsfBlock_t *pBlock)
+{
+    return pBlock->size & ~(BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT);
+}
+
+static void blockSetSize(TlsfBlock_t *pBlock, size_t size)
+{
+    pBlock->size = size | (pBlock->size & (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT));
+}
+
+static bool blockIsFree(const TlsfBlock_t *pBlock)
+{
+    return (pBlock->size & BLOCK_FREE_BIT) != 0;
+}
+
+static void blockSetFree(TlsfBlock_t *pBlock, bool isFree)
+{
+    pBlock->size = isFree ? (pBlock->size | BLOCK_FREE_BIT) : (pBlock->size & ~BLOCK_FREE_BIT);
+}
+
+static bool blockIsPrevFree(const TlsfBlock_t *pBlock)
+{
+    return (pBlock->size & BLOCK_PREV_FREE_BIT) != 0;
+}
+
+static void blockSetPrevFree(TlsfBlock_t *pBlock, bool isFree)
+{
+    pBlock->size = isFree ? (pBlock->size | BLOCK_PREV_FREE_BIT) : (pBlock->size & ~BLOCK_PREV_FREE_BIT);
+}
+
+static TlsfBlock_t * blockFromPtr(const void *pMem)
+{
+    return (TlsfBlock_t *) ((char *) pMem - BLOCK_START_OFFSET_BYTES);
+}
+
+static void * blockToPtr(const TlsfBlock_t *pBlock)
+{
+    return (char *) pBlock + BLOCK_START_OFFSET_BYTES;
+}
+
+// Return the block that starts after size bytes of a block's data,
+// its pPrevPhys overlapping the last word of that data
+static TlsfBlock_t * blockAfter(const TlsfBlock_t *pBlock, size_t size)
+{
+    return (TlsfBlock_t *) ((char *) blockToPtr(pBlock) + size + BLOCK_OVERHEAD_BYTES - BLOCK_START_OFFSET_BYTES);
+}
+
+// Return the next block in the pool; not valid for the sentinel
+static TlsfBlock_t * blockNext(const TlsfBlock_t *pBlock)
+{
+    return blockAfter(pBlock, blockSize(pBlock));
+}
+
+// Return the next block, pointing it back at this one
+static TlsfBlock_t * blockLinkNext(TlsfBlock_t *pBlock)
+{
+    TlsfBlock_t *pNext = blockNext(pBlock);
+
+    pNext->pPrevPhys = pBlock;
+
+    return pNext;
+}
+
+static void blockMarkAsFree(TlsfBlock_t *pBlock)
+{
+    blockSetPrevFree(blockLinkNext(pBlock), true);
+    blockSetFree(pBlock, true);
+}
+
+static void blockMarkAsUsed(TlsfBlock_t *pBlock)
+{
+    blockSetPrevFree(blockNext(pBlock), false);
+    blockSetFree(pBlock, false);
+}
+
+// Whether a block is big enough to split off a block of size
+static bool blockCanSplit(const TlsfBlock_t *pBlock, size_t size)
+{
+    return blockSize(pBlock) >= size + BLOCK_OVERHEAD_BYTES + BLOCK_SIZE_MIN_BYTES;
+}
+
+// Split a block at size, returning the (free) remainder
+static TlsfBlock_t * blockSplit(TlsfBlock_t *pBlock, size_t size)
+{
+    TlsfBlock_t *pRemaining = blockAfter(pBlock, size);
+    size_t remainingSize = blockSize(pBlock) - (size + BLOCK_OVERHEAD_BYTES);
+
+    blockSetSize(pRemaining, remainingSize);
+    blockSetSize(pBlock, size);
+    blockMarkAsFree(pRemaining);
+
+    return pRemaining;
+}
+
+// Absorb a block into the one before it, returning the combination
+static TlsfBlock_t * blockAbsorb(TlsfBlock_t *pPrev, TlsfBlock_t *pBlock)
+{
+    pPrev->size += blockSize(pBlock) + BLOCK_OVERHEAD_BYTES;
+    blockLinkNext(pPrev);
+
+    return pPrev;
+}
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS: FREE LISTS
+// ----------------------------------------------------------------
+
+// Find the lists a block of size belongs in
+static void mappingInsert(size_t size, int *pFl, int *pSl)
+{
+    int fl;
+    int sl;
+
+    if (size < TLSF_SMALL_BLOCK_SIZE)
+    {
+        // Small blocks are spread linearly over the first list
+        fl = 0;
+        sl = (int) size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT);
+    }
+    else
+    {
+        fl = findLastSet(size);
+        sl = (int) (size >> (fl - TLSF_SL_INDEX_COUNT_LOG2)) ^ (1 << TLSF_SL_INDEX_COUNT_LOG2);
+        fl -= (TLSF_FL_INDEX_SHIFT - 1);
+    }
+
+    *pFl = fl;
+    *pSl = sl;
+}
+
+// Find the lists to search for a block of size: rounding up to the
+// next list means that any block found is big enough
+static void mappingSearch(size_t size, int *pFl, int *pSl)
+{
+    if (size >= TLSF_SMALL_BLOCK_SIZE)
+    {
+        size += ((size_t) 1 << (findLastSet(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+
+    mappingInsert(size, pFl, pSl);
+}
+
+// Find a non-empty list at or above fl/sl, updating them
+static TlsfBlock_t * searchSuitableBlock(Tlsf_t *pTlsf, int *pFl, int *pSl)
+{
+    int fl = *pFl;
+    int sl;
+    uint32_t slMap;
+    uint32_t flMap;
+
+    if (fl >= TLSF_FL_INDEX_COUNT)
+    {
+        return NULL;
+    }
+
+    slMap = pTlsf->slBitmap[fl] & (~0U << *pSl);
+    if (slMap == 0)
+    {
+        // Nothing in this first-level list, go up one
+        flMap = (fl + 1 < 32) ? (pTlsf->flBitmap & (~0U << (fl + 1))) : 0;
+        if (flMap == 0)
+        {
+            return NULL;
+        }
+        fl = findFirstSet(flMap);
+        slMap = pTlsf->slBitmap[fl];
+    }
+    sl = findFirstSet(slMap);
+
+    *pFl = fl;
+    *pSl = sl;
+
+    return pTlsf->pBlocks[fl][sl];
+}
+
+static void removeFreeBlock(Tlsf_t *pTlsf, TlsfBlock_t *pBlock, int fl, int sl)
+{
+    TlsfBlock_t *pPrev = pBlock->pPrevFree;
+    TlsfBlock_t *pNext = pBlock->pNextFree;
+
+    if (pNext != NULL)
+    {
+        pNext->pPrevFree = pPrev;
+    }
+    if (pPrev != NULL)
+    {
+        pPrev->pNextFree = pNext;
+    }
+
+    if (pTlsf->pBlocks[fl][sl] == pBlock)
+    {
+        pTlsf->pBlocks[fl][sl] = pNext;
+        if (pNext == NULL)
+        {
+            pTlsf->slBitmap[fl] &= ~(1U << sl);
+            if (pTlsf->slBitmap[fl] == 0)
+            {
+                pTlsf->flBitmap &= ~(1U << fl);
+            }
+        }
+    }
+}
+
+static void insertFreeBlock(Tlsf_t *pTlsf, TlsfBlock_t *pBlock, int fl, int sl)
+{
+    TlsfBlock_t *pCurrent = pTlsf->pBlocks[fl][sl];
+
+    pBlock->pNextFree = pCurrent;
+    pBlock->pPrevFree = NULL;
+    if (pCurrent != NULL)
+    {
+        pCurrent->pPrevFree = pBlock;
+    }
+
+    pTlsf->pBlocks[fl][sl] = pBlock;
+    pTlsf->flBitmap |= 1U << fl;
+    pTlsf->slBitmap[fl] |= 1U << sl;
+}
+
+static void blockRemove(Tlsf_t *pTlsf, TlsfBlock_t *pBlock)
+{
+    int fl;
+    int sl;
+
+    mappingInsert(blockSize(pBlock), &fl, &sl);
+    removeFreeBlock(pTlsf, pBlock, fl, sl);
+}
+
+static void blockInsert(Tlsf_t *pTlsf, TlsfBlock_t *pBlock)
+{
+    int fl;
+    int sl;
+
+    mappingInsert(blockSize(pBlock), &fl, &sl);
+    insertFreeBlock(pTlsf, pBlock, fl, sl);
+}
+
+// Merge a free block with the previous block, if that is free
+static TlsfBlock_t * blockMergePrev(Tlsf_t *pTlsf, TlsfBlock_t *pBlock)
+{
+    TlsfBlock_t *pPrev;
+
+    if (blockIsPrevFree(pBlock))
+    {
+        pPrev = pBlock->pPrevPhys;
+        blockRemove(pTlsf, pPrev);
+        pBlock = blockAbsorb(pPrev, pBlock);
+    }
+
+    return pBlock;
+}
+
+// Merge a block with the next block, if that is free
+static TlsfBlock_t * blockMergeNext(Tlsf_t *pTlsf, TlsfBlock_t *pBlock)
+{
+    TlsfBlock_t *pNext = blockNext(pBlock);
+
+    if (blockIsFree(pNext))
+    {
+        blockRemove(pTlsf, pNext);
+        pBlock = blockAbsorb(pBlock, pNext);
+    }
+
+    return pBlock;
+}
+
+// Trim a free block down to size, returning the rest to the lists
+static void blockTrimFree(Tlsf_t *pTlsf, TlsfBlock_t *pBlock, size_t size)
+{
+    TlsfBlock_t *pRemaining;
+
+    if (blockCanSplit(pBlock, size))
+    {
+        pRemaining = blockSplit(pBlock, size);
+        blockLinkNext(pBlock);
+        blockSetPrevFree(pRemaining, true);
+        blockInsert(pTlsf, pRemaining);
+    }
+}
+
+// Trim a used block down to size, returning the rest to the lists
+static void blockTrimUsed(Tlsf_t *pTlsf, TlsfBlock_t *pBlock, size_t size)
+{
+    TlsfBlock_t *pRemaining;
+
+    if (blockCanSplit(pBlock, size))
+    {
+        pRemaining = blockSplit(pBlock, size);
+        blockSetPrevFree(pRemaining, false);
+        pRemaining = blockMergeNext(pTlsf, pRemaining);
+        blockInsert(pTlsf, pRemaining);
+    }
+}
+
+// Find a free block of at least size and take it off its list
+static TlsfBlock_t * blockLocateFree(Tlsf_t *pTlsf, size_t size)
+{
+    TlsfBlock_t *pBlock;
+    int fl;
+    int sl;
+
+    mappingSearch(size, &fl, &sl);
+    pBlock = searchSuitableBlock(pTlsf, &fl, &sl);
+    if (pBlock != NULL)
+    {
+        removeFreeBlock(pTlsf, pBlock, fl, sl);
+    }
+
+    return pBlock;
+}
+
+// Account for a change in the bytes in use
+static void addUsed(Tlsf_t *pTlsf, size_t addBytes, size_t subtractBytes)
+{
+    pTlsf->stats.usedBytes += addBytes;
+    pTlsf->stats.usedBytes -= subtractBytes;
+    if (pTlsf->stats.usedBytes > pTlsf->stats.peakUsedBytes)
+    {
+        pTlsf->stats.peakUsedBytes = pTlsf->stats.usedBytes;
+    }
+}
+
+// Add a free block to the free block statistics
+static void addFreeStats(void *pParam, void *pMem, size_t sizeBytes, bool used)
+{
+    TlsfStats_t *pStats = (TlsfStats_t *) pParam;
+
+    (void) pMem;
+    if (!used)
+    {
+        pStats->freeBytes += sizeBytes;
+        pStats->numFreeBlocks++;
+        if (sizeBytes > pStats->largestFreeBytes)
+        {
+            pStats->largestFreeBytes = sizeBytes;
+        }
+    }
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up an allocator
+bool tlsfInit(Tlsf_t *pTlsf, void *pPool, size_t sizeBytes)
+{
+    TlsfBlock_t *pBlock;
+    TlsfBlock_t *pSentinel;
+    size_t poolBytes;
+    bool success = false;
+
+    if ((pTlsf != NULL) && (pPool != NULL) && (((uintptr_t) pPool & (TLSF_ALIGN_SIZE - 1)) == 0) &&
+        (sizeBytes > BLOCK_OVERHEAD_BYTES * 2))
+    {
+        poolBytes = alignDown(sizeBytes - (BLOCK_OVERHEAD_BYTES * 2));
+        if ((poolBytes >= BLOCK_SIZE_MIN_BYTES) && (poolBytes < BLOCK_SIZE_MAX_BYTES))
+        {
+            memset(pTlsf, 0, sizeof (*pTlsf));
+
+            // The first block's size starts the pool, so its data is
+            // aligned; its pPrevPhys is just before the pool, but it is
+            // never used since there is no previous free block
+            pBlock = (TlsfBlock_t *) ((char *) pPool - offsetof(TlsfBlock_t, size));
+            pBlock->size = poolBytes;
+            blockSetFree(pBlock, true);
+            blockSetPrevFree(pBlock, false);
+            blockInsert(pTlsf, pBlock);
+
+            pSentinel = blockLinkNext(pBlock);
+            pSentinel->size = 0;
+            blockSetFree(pSentinel, false);
+            blockSetPrevFree(pSentinel, true);
+
+            pTlsf->pFirst = pBlock;
+            pTlsf->stats.poolBytes = sizeBytes;
+            success = true;
+        }
+    }
+
+    return success;
+}
+
+// Allocate a block
+void * tlsfMalloc(Tlsf_t *pTlsf, size_t sizeBytes)
+{
+    size_t adjusted = adjustRequestSize(sizeBytes);
+    TlsfBlock_t *pBlock = NULL;
+    void *pMem = NULL;
+
+    if (pTlsf != NULL)
+    {
+        if (adjusted > 0)
+        {
+            pBlock = blockLocateFree(pTlsf, adjusted);
+        }
+        if (pBlock != NULL)
+        {
+            blockTrimFree(pTlsf, pBlock, adjusted);
+            blockMarkAsUsed(pBlock);
+            addUsed(pTlsf, blockSize(pBlock), 0);
+            pTlsf->stats.numMallocs++;
+            pMem = blockToPtr(pBlock);
+        }
+        else
+        {
+            pTlsf->stats.numFailures++;
+        }
+    }
+
+    return pMem;
+}
+
+// Free a block
+void tlsfFree(Tlsf_t *pTlsf, void *pMem)
+{
+    TlsfBlock_t *pBlock;
+
+    if ((pTlsf != NULL) && (pMem != NULL))
+    {
+        pBlock = blockFromPtr(pMem);
+        addUsed(pTlsf, 0, blockSize(pBlock));
+        pTlsf->stats.numFrees++;
+        blockMarkAsFree(pBlock);
+        pBlock = blockMergePrev(pTlsf, pBlock);
+        pBlock = blockMergeNext(pTlsf, pBlock);
+        blockInsert(pTlsf, pBlock);
+    }
+}
+
+// Resize a block
+void * tlsfRealloc(Tlsf_t *pTlsf, void *pMem, size_t sizeBytes)
+{
+    TlsfBlock_t *pBlock;
+    TlsfBlock_t *pNext;
+    size_t currentSize;
+    size_t combinedSize;
+    size_t adjusted;
+    void *pNewMem = NULL;
+
+    if (pMem == NULL)
+    {
+        pNewMem = tlsfMalloc(pTlsf, sizeBytes);
+    }
+    else if (sizeBytes == 0)
+    {
+        tlsfFree(pTlsf, pMem);
+    }
+    else if (pTlsf != NULL)
+    {
+        pBlock = blockFromPtr(pMem);
+        pNext = blockNext(pBlock);
+        currentSize = blockSize(pBlock);
+        combinedSize = currentSize + blockSize(pNext) + BLOCK_OVERHEAD_BYTES;
+        adjusted = adjustRequestSize(sizeBytes);
+
+        if ((adjusted == 0) || ((adjusted > currentSize) && (!blockIsFree(pNext) || (adjusted > combinedSize))))
+        {
+            // Can't be done in place
+            pNewMem = tlsfMalloc(pTlsf, sizeBytes);
+            if (pNewMem != NULL)
+            {
+                memcpy(pNewMem, pMem, (currentSize < sizeBytes) ? currentSize : sizeBytes);
+                tlsfFree(pTlsf, pMem);
+            }
+        }
+        else
+        {
+            if (adjusted > currentSize)
+            {
+                blockMergeNext(pTlsf, pBlock);
+                blockMarkAsUsed(pBlock);
+            }
+            blockTrimUsed(pTlsf, pBlock, adjusted);
+            addUsed(pTlsf, blockSize(pBlock), currentSize);
+            pNewMem = pMem;
+        }
+    }
+
+    return pNewMem;
+}
+
+// Return the usable size of a block
+size_t tlsfBlockSize(const void *pMem)
+{
+    size_t sizeBytes = 0;
+
+    if (pMem != NULL)
+    {
+        sizeBytes = blockSize(blockFromPtr(pMem));
+    }
+
+    return sizeBytes;
+}
+
+// Walk the pool
+void tlsfWalk(Tlsf_t *pTlsf, void (*pCallback)(void *pParam, void *pMem, size_t sizeBytes, bool used),
+              void *pParam)
+{
+    TlsfBlock_t *pBlock;
+
+    if ((pTlsf != NULL) && (pCallback != NULL))
+    {
+        for (pBlock = pTlsf->pFirst; (pBlock != NULL) && (blockSize(pBlock) > 0); pBlock = blockNext(pBlock))
+        {
+            pCallback(pParam, blockToPtr(pBlock), blockSize(pBlock), !blockIsFree(pBlock));
+        }
+    }
+}
+
+// Get the statistics
+void tlsfGetStats(Tlsf_t *pTlsf, TlsfStats_t *pStats)
+{
+    if ((pTlsf != NULL) && (pStats != NULL))
+    {
+        *pStats = pTlsf->stats;
+        pStats->freeBytes = 0;
+        pStats->largestFreeBytes = 0;
+        pStats->numFreeBlocks = 0;
+        tlsfWalk(pTlsf, addFreeStats, pStats);
+    }
+}
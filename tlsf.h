@@ -0,0 +1,133 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TLSF_H_
+#define _TLSF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A two-level segregated-fit (TLSF) allocator: malloc and free take
+// bounded, O(1), time whatever the state of the pool, and fragmentation
+// stays low, since free blocks are kept in lists segregated by size
+// (a first level of powers of two, each split into
+// TLSF_SL_INDEX_COUNT second-level ranges) found through bitmaps, and
+// neighbouring free blocks are always merged.  An allocator has no
+// locking of its own.  Define HEAP_TLSF to have malloc() and friends
+// use one (see tlsf_heap.cpp).
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// log2 of the number of second-level ranges per power of two
+#ifndef TLSF_SL_INDEX_COUNT_LOG2
+# define TLSF_SL_INDEX_COUNT_LOG2 4
+#endif
+
+// log2 of the largest pool (and so block) that can be managed; this
+// sets the size of Tlsf_t
+#ifndef TLSF_FL_INDEX_MAX
+# define TLSF_FL_INDEX_MAX 18
+#endif
+
+// The alignment of every block handed out, which is what malloc()
+// guarantees (max_align_t): two words, i.e. 8 bytes on the target
+// and 16 on a 64-bit host; a block's header is padded out to this
+#if UINTPTR_MAX > 0xffffffff
+# define TLSF_ALIGN_SIZE_LOG2 4
+#else
+# define TLSF_ALIGN_SIZE_LOG2 3
+#endif
+#define TLSF_ALIGN_SIZE (1 << TLSF_ALIGN_SIZE_LOG2)
+
+#define TLSF_SL_INDEX_COUNT (1 << TLSF_SL_INDEX_COUNT_LOG2)
+#define TLSF_FL_INDEX_SHIFT (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_FL_INDEX_COUNT (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+#define TLSF_SMALL_BLOCK_SIZE (1 << TLSF_FL_INDEX_SHIFT)
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A block, as laid out in the pool; opaque
+typedef struct TlsfBlockTag TlsfBlock_t;
+
+// Statistics on an allocator
+typedef struct
+{
+    size_t poolBytes;          // The size of the pool
+    size_t usedBytes;          // The bytes in allocated blocks
+    size_t peakUsedBytes;      // The most usedBytes has been
+    size_t freeBytes;          // The bytes in free blocks
+    size_t largestFreeBytes;   // The largest free block
+    uint32_t numFreeBlocks;
+    uint32_t numMallocs;       // Successful calls to tlsfMalloc()
+    uint32_t numFrees;
+    uint32_t numFailures;      // Calls to tlsfMalloc() that failed
+} TlsfStats_t;
+
+// An allocator
+typedef struct
+{
+    uint32_t flBitmap;         // Which first-level lists are non-empty
+    uint32_t slBitmap[TLSF_FL_INDEX_COUNT]; // ...and second-level ones
+    TlsfBlock_t *pBlocks[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT]; // The free lists
+    TlsfBlock_t *pFirst;       // The first block in the pool
+    TlsfStats_t stats;         // The free block figures are only
+                               // filled in by tlsfGetStats()
+} Tlsf_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up an allocator to manage the memory at pPool, which must be
+// TLSF_ALIGN_SIZE aligned; less a block's overhead at each end it must
+// be less than 2^TLSF_FL_INDEX_MAX bytes.
+// Returns true on success, false if the parameters were bad.
+bool tlsfInit(Tlsf_t *pTlsf, void *pPool, size_t sizeBytes);
+
+// Allocate a block of at least sizeBytes.
+// Returns a pointer to the block, NULL if there is no room.
+void * tlsfMalloc(Tlsf_t *pTlsf, size_t sizeBytes);
+
+// Free a block; pMem may be NULL.
+void tlsfFree(Tlsf_t *pTlsf, void *pMem);
+
+// Resize a block, in place where possible, as realloc() would.
+// Returns a pointer to the block, NULL (leaving pMem alone) if there
+// is no room.
+void * tlsfRealloc(Tlsf_t *pTlsf, void *pMem, size_t sizeBytes);
+
+// Return the usable size of an allocated block.
+size_t tlsfBlockSize(const void *pMem);
+
+// Call pCallback for every block in the pool, in address order,
+// with the usable size of the block and whether it is in use.
+void tlsfWalk(Tlsf_t *pTlsf, void (*pCallback)(void *pParam, void *pMem, size_t sizeBytes, bool used),
+              void *pParam);
+
+// Get the statistics of an allocator; this walks the pool to find
+// the free block figures.
+void tlsfGetStats(Tlsf_t *pTlsf, TlsfStats_t *pStats);
+
+// The allocator behind malloc() when HEAP_TLSF is defined, NULL
+// until the first call to malloc().
+Tlsf_t * tlsfHeap(void);
+
+#endif // _TLSF_H_
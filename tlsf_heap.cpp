@@ -0,0 +1,254 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replaces the C library's malloc() and friends with a TLSF allocator
+// (see tlsf.h) when HEAP_TLSF is defined, so that allocation time is
+// bounded and fragmentation stays low.  The allocator is set up on the
+// first call, taking as much memory as the C library's sbrk() will
+// give (GCC_ARM) or the heap region from the linker (ARM and IAR).
+// Interrupts are masked for the duration of each call, which is short
+// and bounded, rather than taking a lock.  The host build does the
+// same in host/host_heap.cpp.
+
+#include "mbed.h"
+#include "tlsf.h"
+#include "memory_map.h"
+#include "heap_trace.h"
+
+#if defined(HEAP_TLSF) && !defined(MBED_HOST_BUILD)
+
+#if defined(TOOLCHAIN_GCC_ARM)
+#include <reent.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// The smallest step by which the pool is grown from sbrk()
+#define TLSF_HEAP_MIN_STEP_BYTES 64
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The allocator
+static Tlsf_t gTlsf;
+
+// Whether gTlsf has been set up
+static bool gInitialised = false;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Set up the allocator, once; call with interrupts masked
+static void heapInit()
+{
+    char *pPool = NULL;
+    size_t poolBytes = 0;
+
+    if (!gInitialised)
+    {
+#if defined(TOOLCHAIN_GCC_ARM)
+        char *pBreak = (char *) sbrk(0);
+        size_t stepBytes;
+
+        // Align the break, then take the largest contiguous run that
+        // sbrk() will give, halving the step each time it refuses
+        if (pBreak != (char *) -1)
+        {
+            stepBytes = (TLSF_ALIGN_SIZE - ((uintptr_t) pBreak & (TLSF_ALIGN_SIZE - 1))) & (TLSF_ALIGN_SIZE - 1);
+            if ((stepBytes == 0) || (sbrk(stepBytes) != (void *) -1))
+            {
+                pPool = pBreak + stepBytes;
+                for (stepBytes = (size_t) 1 << TLSF_FL_INDEX_MAX; stepBytes >= TLSF_HEAP_MIN_STEP_BYTES; stepBytes >>= 1)
+                {
+                    if ((poolBytes + stepBytes <= ((size_t) 1 << TLSF_FL_INDEX_MAX)) &&
+                        (sbrk(stepBytes) != (void *) -1))
+                    {
+                        poolBytes += stepBytes;
+                    }
+                }
+            }
+        }
+#else
+        MemoryMap_t memoryMap;
+        size_t alignBytes;
+
+        // Align the start of the linker's heap region and take no more
+        // of it than an allocator can manage
+        if (memoryMapGet(&memoryMap))
+        {
+            pPool = memoryMap.regions[MEMORY_MAP_HEAP].pStart;
+            poolBytes = memoryMapRegionSize(&memoryMap, MEMORY_MAP_HEAP);
+            alignBytes = (TLSF_ALIGN_SIZE - ((uintptr_t) pPool & (TLSF_ALIGN_SIZE - 1))) & (TLSF_ALIGN_SIZE - 1);
+            if (poolBytes > alignBytes)
+            {
+                pPool += alignBytes;
+                poolBytes -= alignBytes;
+                if (poolBytes > ((size_t) 1 << TLSF_FL_INDEX_MAX))
+                {
+                    poolBytes = (size_t) 1 << TLSF_FL_INDEX_MAX;
+                }
+            }
+        }
+#endif
+        gInitialised = tlsfInit(&gTlsf, pPool, poolBytes);
+    }
+}
+
+// Allocate, free and reallocate with interrupts masked
+static void * heapMalloc(size_t sizeBytes)
+{
+    uint32_t primask = __get_PRIMASK();
+    void *pMem;
+
+    __disable_irq();
+    heapInit();
+    pMem = tlsfMalloc(tlsfHeap(), sizeBytes);
+    __set_PRIMASK(primask);
+
+    return pMem;
+}
+
+static void heapFree(void *pMem)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    tlsfFree(tlsfHeap(), pMem);
+    __set_PRIMASK(primask);
+}
+
+static void * heapRealloc(void *pMem, size_t sizeBytes)
+{
+    uint32_t primask = __get_PRIMASK();
+    void *pNewMem;
+
+    __disable_irq();
+    heapInit();
+    pNewMem = tlsfRealloc(tlsfHeap(), pMem, sizeBytes);
+    __set_PRIMASK(primask);
+
+    return pNewMem;
+}
+
+static void * heapCalloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = NULL;
+
+    if ((itemSizeBytes == 0) || (numItems <= ((size_t) -1) / itemSizeBytes))
+    {
+        pMem = heapMalloc(numItems * itemSizeBytes);
+        if (pMem != NULL)
+        {
+            memset(pMem, 0, numItems * itemSizeBytes);
+        }
+    }
+
+    return pMem;
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// The allocator behind malloc()
+Tlsf_t * tlsfHeap()
+{
+    return gInitialised ? &gTlsf : NULL;
+}
+
+// The public functions call the hooks of heap_trace.h, which are
+// empty unless HEAP_TRACE is defined
+extern "C" void * malloc(size_t sizeBytes)
+{
+    void *pMem = heapMalloc(sizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void free(void *pMem)
+{
+    HEAP_TRACE_FREE(pMem);
+    heapFree(pMem);
+}
+
+extern "C" void * realloc(void *pMem, size_t sizeBytes)
+{
+    void *pNewMem = heapRealloc(pMem, sizeBytes);
+
+    HEAP_TRACE_REALLOC(pMem, pNewMem, sizeBytes);
+
+    return pNewMem;
+}
+
+extern "C" void * calloc(size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = heapCalloc(numItems, itemSizeBytes);
+
+    HEAP_TRACE_MALLOC(pMem, numItems * itemSizeBytes);
+
+    return pMem;
+}
+
+#if defined(TOOLCHAIN_GCC_ARM)
+// newlib calls these internally (e.g. from stdio), so they have to be
+// replaced too or its own allocator would be linked in alongside
+extern "C" void * _malloc_r(struct _reent *pReent, size_t sizeBytes)
+{
+    void *pMem = heapMalloc(sizeBytes);
+
+    (void) pReent;
+    HEAP_TRACE_MALLOC(pMem, sizeBytes);
+
+    return pMem;
+}
+
+extern "C" void _free_r(struct _reent *pReent, void *pMem)
+{
+    (void) pReent;
+    HEAP_TRACE_FREE(pMem);
+    heapFree(pMem);
+}
+
+extern "C" void * _realloc_r(struct _reent *pReent, void *pMem, size_t sizeBytes)
+{
+    void *pNewMem = heapRealloc(pMem, sizeBytes);
+
+    (void) pReent;
+    HEAP_TRACE_REALLOC(pMem, pNewMem, sizeBytes);
+
+    return pNewMem;
+}
+
+extern "C" void * _calloc_r(struct _reent *pReent, size_t numItems, size_t itemSizeBytes)
+{
+    void *pMem = heapCalloc(numItems, itemSizeBytes);
+
+    (void) pReent;
+    HEAP_TRACE_MALLOC(pMem, numItems * itemSizeBytes);
+
+    return pMem;
+}
+#endif
+
+#endif // HEAP_TLSF && !MBED_HOST_BUILD
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Decode an event trace dumped by the application into a timeline
+and the statistics of each event.
+
+The application must have been built with EVENT_TRACE defined; it
+writes a binary dump (see event_trace.h) among its normal output at
+the end of the self-tests and when sent Ctrl-E in the echo loop.
+Capture that output to a file (e.g. with "cat" of the serial port)
+and pass it here, or pipe it in; the last dump in it is decoded.
+For each event the interval between occurrences is given; for those
+recorded as a begin and an end, the duration from one to the other
+is given too.
+"""
+
+import argparse
+import collections
+import os
+import sys
+
+# The dump reader shared with the other trace decoder
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "trace_dump"))
+import trace_dump
+
+MAGIC = b"ETRC"
+VERSION = 1
+RECORD_FORMAT = "<III"
+FLAG_BEGIN = 0x8000
+FLAG_END = 0x4000
+ID_MASK = 0x3fff
+
+Record = collections.namedtuple("Record", "time id flags argument")
+
+class Dump:
+    """A decoded dump: its header fields, the event names and the
+    records, oldest first, with timestamps unwrapped and converted to
+    microseconds from the first."""
+
+    def __init__(self, data, offset):
+        header, offset = trace_dump.read_header(data, offset, VERSION)
+        self.num_events = header.num_events
+        self.num_dropped = header.num_dropped
+        self.names = []
+        for _ in range(header.detail):
+            end = data.find(b"\0", offset)
+            if end < 0:
+                raise ValueError("truncated names")
+            self.names.append(data[offset:end].decode("ascii", "replace"))
+            offset = end + 1
+        records, self.end = trace_dump.read_records(data, offset, header, RECORD_FORMAT)
+        self.records = [Record(time, event & ID_MASK, event & (FLAG_BEGIN | FLAG_END), argument)
+                        for time, event, argument in records]
+
+    def name(self, event_id):
+        """Return the name of an event."""
+        if event_id < len(self.names):
+            return self.names[event_id]
+        return "event %d" % event_id
+
+def percentile(values, fraction):
+    """Return the value below which the given fraction of the sorted
+    values lie."""
+    return values[min(int(len(values) * fraction), len(values) - 1)]
+
+def timeline(dump, limit):
+    """Print the last limit records, with the time since the one before
+    and, for an end, the time since its begin."""
+    begins = {}
+    previous = None
+    print("%12s %10s  %-20s %10s  %s" % ("time (us)", "+ (us)", "event", "argument", ""))
+    for x, record in enumerate(dump.records):
+        note = ""
+        if record.flags == FLAG_BEGIN:
+            begins[record.id] = record.time
+            suffix = " begin"
+        elif record.flags == FLAG_END:
+            suffix = " end"
+            if record.id in begins:
+                note = "took %.1f us" % (record.time - begins.pop(record.id))
+        else:
+            suffix = ""
+        if x >= len(dump.records) - limit:
+            print("%12.1f %10.1f  %-20s %10d  %s" %
+                  (record.time, record.time - previous if previous is not None else 0,
+                   dump.name(record.id) + suffix, record.argument, note))
+        previous = record.time
+
+def statistics(dump):
+    """Print, for each event, how often it came and, for begin/end
+    pairs, how long it took."""
+    last = {}
+    begins = {}
+    intervals = collections.defaultdict(list)
+    durations = collections.defaultdict(list)
+    counts = collections.Counter()
+    for record in dump.records:
+        if record.flags != FLAG_END:
+            counts[record.id] += 1
+            if record.id in last:
+                intervals[record.id].append(record.time - last[record.id])
+            last[record.id] = record.time
+            if record.flags == FLAG_BEGIN:
+                begins[record.id] = record.time
+        elif record.id in begins:
+            durations[record.id].append(record.time - begins.pop(record.id))
+
+    print("%-20s %6s  %-36s  %s" % ("event", "count", "interval (us) min/p50/p99/max",
+                                    "duration (us) min/p50/p99/max"))
+    for event_id in sorted(counts):
+        columns = []
+        for values in (sorted(intervals[event_id]), sorted(durations[event_id])):
+            if values:
+                columns.append("%.1f/%.1f/%.1f/%.1f" %
+                               (values[0], percentile(values, 0.5),
+                                percentile(values, 0.99), values[-1]))
+            else:
+                columns.append("-")
+        print("%-20s %6d  %-36s  %s" % (dump.name(event_id), counts[event_id],
+                                        columns[0], columns[1]))
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="captured output of the application, "
+                        "or - for stdin")
+    parser.add_argument("--all", action="store_true",
+                        help="decode every dump found, not just the last")
+    parser.add_argument("--timeline", type=int, default=50,
+                        help="the number of records to list, latest last "
+                        "(default %(default)s, 0 for none)")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as file:
+            data = file.read()
+    dumps = trace_dump.find_dumps(data, MAGIC, Dump)
+    if not dumps:
+        print("No event trace dump found.")
+        return 1
+    for x, dump in enumerate(dumps if args.all else dumps[-1:]):
+        if x > 0:
+            print()
+        span = dump.records[-1].time if dump.records else 0
+        print("%d event(s) recorded, the last %d of them dumped (%d overwritten, "
+              "%d dropped during a dump), covering %.0f us." %
+              (dump.num_events, len(dump.records), dump.num_events - len(dump.records),
+               dump.num_dropped, span))
+        if args.timeline > 0:
+            print()
+            timeline(dump, args.timeline)
+        print()
+        statistics(dump)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Decode a heap trace dumped by the application and report the blocks
+still allocated, grouped by the code that allocated them.
+
+The application must have been built with HEAP_TRACE defined; sending
+it Ctrl-T in the echo loop makes it write a binary dump (see
+heap_trace.h) among its normal output.  Capture that output to a file
+(e.g. with "cat" of the serial port) and pass it here, or pipe it in;
+the last dump in it is decoded.  Blocks allocated and not
+freed are leak candidates, the oldest being the most suspicious; with
+--elf the callers are resolved to functions and lines with addr2line.
+"""
+
+import argparse
+import collections
+import os
+import subprocess
+import sys
+
+# The dump reader shared with the other trace decoder
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "trace_dump"))
+import trace_dump
+
+MAGIC = b"HTRC"
+VERSION = 1
+POINTER_FORMATS = {4: "I", 8: "Q"}
+EVENT_SHIFT = 28
+SIZE_MASK = (1 << EVENT_SHIFT) - 1
+EVENT_MALLOC = 1
+EVENT_FREE = 2
+
+Record = collections.namedtuple("Record", "time event size caller pointer")
+
+class Dump:
+    """A decoded dump: its header fields and its records, oldest
+    first, with timestamps unwrapped and converted to microseconds."""
+
+    def __init__(self, data, offset):
+        header, offset = trace_dump.read_header(data, offset, VERSION)
+        self.num_events = header.num_events
+        self.num_dropped = header.num_dropped
+        if header.detail not in POINTER_FORMATS:
+            raise ValueError("unexpected pointer size %d" % header.detail)
+        pointer_format = POINTER_FORMATS[header.detail]
+        records, self.end = trace_dump.read_records(data, offset, header,
+                                                    "<II" + pointer_format * 2)
+        self.records = [Record(time, size_and_event >> EVENT_SHIFT,
+                               size_and_event & SIZE_MASK, caller, pointer)
+                        for time, size_and_event, caller, pointer in records]
+
+def resolve(addr2line, elf, addresses):
+    """Return a dictionary of address to "function at file:line"."""
+    names = {}
+    if elf and addresses:
+        # The return address is just after the call, so look up the
+        # instruction before it; Thumb addresses have bit 0 set
+        lookups = [(address & ~1) - 2 if address > 2 else address
+                   for address in addresses]
+        output = subprocess.run([addr2line, "-f", "-C", "-e", elf] +
+                                ["0x%x" % x for x in lookups], check=True,
+                                stdout=subprocess.PIPE,
+                                universal_newlines=True).stdout.splitlines()
+        for x, address in enumerate(addresses):
+            function = output[x * 2] if x * 2 < len(output) else "??"
+            location = output[x * 2 + 1] if x * 2 + 1 < len(output) else "??"
+            names[address] = "%s at %s" % (function, location)
+    return names
+
+def analyse(dump, addr2line, elf, top):
+    """Replay a dump and print what it shows."""
+    live = {}
+    unmatched_frees = 0
+    failures = 0
+    live_bytes = 0
+    peak_bytes = 0
+    num_mallocs = collections.Counter()
+    for record in dump.records:
+        if record.event == EVENT_MALLOC:
+            num_mallocs[record.caller] += 1
+            if record.pointer == 0:
+                failures += 1
+            else:
+                live[record.pointer] = record
+                live_bytes += record.size
+                peak_bytes = max(peak_bytes, live_bytes)
+        elif record.event == EVENT_FREE:
+            freed = live.pop(record.pointer, None)
+            if freed is None:
+                unmatched_frees += 1
+            else:
+                live_bytes -= freed.size
+
+    span = dump.records[-1].time if dump.records else 0
+    overwritten = dump.num_events - len(dump.records)
+    print("%d event(s) recorded, the last %d of them dumped (%d overwritten, "
+          "%d dropped during the dump), covering %.0f us." %
+          (dump.num_events, len(dump.records), overwritten, dump.num_dropped, span))
+    print("%d malloc() failure(s); %d free(s) of blocks allocated before "
+          "the first record." % (failures, unmatched_frees))
+    print("%d block(s), %d byte(s), allocated in the trace and not freed "
+          "(peak %d byte(s) at once)." % (len(live), live_bytes, peak_bytes))
+    if not live:
+        return
+
+    callers = collections.defaultdict(list)
+    for record in live.values():
+        callers[record.caller].append(record)
+    names = resolve(addr2line, elf, sorted(callers))
+    ranked = sorted(callers.items(),
+                    key=lambda item: (-sum(r.size for r in item[1]),
+                                      min(r.time for r in item[1])))
+    print()
+    print("Leak candidates, by bytes still allocated:")
+    print("%10s %7s %9s %12s  %s" % ("caller", "blocks", "bytes", "oldest (us)", ""))
+    for caller, records in ranked[:top]:
+        oldest = min(record.time for record in records)
+        print("%10s %3d/%-3d %9d %12.0f  %s" %
+              ("0x%x" % caller, len(records), num_mallocs[caller],
+               sum(record.size for record in records), span - oldest,
+               names.get(caller, "")))
+    print("(blocks is those still allocated out of all allocated by the caller in the trace)")
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="captured output of the application, "
+                        "or - for stdin")
+    parser.add_argument("--elf", help="the application's ELF file, to resolve callers")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line",
+                        help="the addr2line to use (default %(default)s)")
+    parser.add_argument("--all", action="store_true",
+                        help="decode every dump found, not just the last")
+    parser.add_argument("--top", type=int, default=20,
+                        help="the number of callers to list (default %(default)s)")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as file:
+            data = file.read()
+    dumps = trace_dump.find_dumps(data, MAGIC, Dump)
+    if not dumps:
+        print("No heap trace dump found.")
+        return 1
+    for dump in dumps if args.all else dumps[-1:]:
+        analyse(dump, args.addr2line, args.elf, args.top)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
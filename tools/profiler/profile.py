@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Resolve a profile printed by the application against its ELF file
+and list where the time went, by function.
+
+The application must have been built with PROFILER defined; it prints
+the profile of checkRam() at start-up and that of the echo loop when
+sent Ctrl-P (see profiler.h).  Capture its output to a file (e.g. with
+"cat" of the serial port) and pass it here, or pipe it in; the last
+profile in it is resolved.  Each bucket of the profile is credited to
+the function its first address falls in, so with large buckets a hot
+spot at the very start of a function may be credited to the function
+before it; --buckets lists the buckets themselves, with source lines
+if --addr2line can be run.
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+HEADER = re.compile(r"\*\*\* Profile of (.*): (\d+) sample\(s\) every (\d+) us, "
+                    r"(\d+) in handlers, (\d+) unknown, (\d+) dropped, "
+                    r"\d+ bucket\(s\) of (\d+) byte\(s\)\.")
+BUCKET = re.compile(r"^\s*PROFILE (0x[0-9a-fA-F]+) (\d+)\s*$")
+
+# The e_machine of ARM in an ELF header, whose Thumb function
+# symbols may have bit 0 set
+ELF_MACHINE_ARM = 40
+
+Profile = collections.namedtuple("Profile",
+                                 "name samples period_us in_handlers unknown dropped "
+                                 "bucket_bytes buckets")
+
+def find_profiles(lines):
+    """Return every profile in the lines, in order."""
+    profiles = []
+    for line in lines:
+        match = HEADER.search(line)
+        if match:
+            profiles.append(Profile(match.group(1), int(match.group(2)),
+                                    int(match.group(3)), int(match.group(4)),
+                                    int(match.group(5)), int(match.group(6)),
+                                    int(match.group(7)), {}))
+            continue
+        match = BUCKET.match(line)
+        if match and profiles:
+            address = int(match.group(1), 16)
+            buckets = profiles[-1].buckets
+            buckets[address] = buckets.get(address, 0) + int(match.group(2))
+    return profiles
+
+class Symbols:
+    """The functions of an ELF file, looked up by address."""
+
+    def __init__(self, nm, elf):
+        with open(elf, "rb") as file:
+            header = file.read(20)
+        thumb = (header[:4] == b"\x7fELF" and
+                 int.from_bytes(header[18:20], "big" if header[5] == 2 else "little")
+                 == ELF_MACHINE_ARM)
+        output = subprocess.run([nm, "--defined-only", "--print-size", "--demangle", elf],
+                                check=True, stdout=subprocess.PIPE,
+                                universal_newlines=True).stdout
+        functions = {}
+        for line in output.splitlines():
+            fields = line.split(None, 3)
+            if len(fields) == 4 and fields[2] in "tTwW":
+                start = int(fields[0], 16) & (~1 if thumb else ~0)
+                functions[start] = (int(fields[1], 16), fields[3])
+        self.starts = sorted(functions)
+        self.functions = [functions[start] for start in self.starts]
+
+    def lookup(self, address, size):
+        """Return the name of the function that the given range of
+        addresses starts in, or else the first that starts in it,
+        or None."""
+        x = bisect.bisect_right(self.starts, address) - 1
+        if x >= 0 and address < self.starts[x] + max(self.functions[x][0], 1):
+            return self.functions[x][1]
+        if x + 1 < len(self.starts) and self.starts[x + 1] < address + size:
+            return self.functions[x + 1][1]
+        return None
+
+def lines_of(addr2line, elf, addresses):
+    """Return a dictionary of address to "file:line"."""
+    names = {}
+    if addresses:
+        try:
+            output = subprocess.run([addr2line, "-e", elf] + ["0x%x" % x for x in addresses],
+                                    check=True, stdout=subprocess.PIPE,
+                                    universal_newlines=True).stdout.splitlines()
+            names = dict(zip(addresses, output))
+        except (OSError, subprocess.CalledProcessError) as error:
+            print("Unable to run %s: %s" % (addr2line, error), file=sys.stderr)
+    return names
+
+def report(profile, symbols, addr2line, elf, top, list_buckets):
+    """Print the profile by function and, optionally, by bucket."""
+    total = sum(profile.buckets.values())
+    print("Profile of %s: %d sample(s), one every %d us, %d in handlers, "
+          "%d unknown, %d dropped." %
+          (profile.name, profile.samples, profile.period_us,
+           profile.in_handlers, profile.unknown, profile.dropped))
+    if total == 0:
+        return
+
+    by_function = collections.Counter()
+    names = {}
+    for address, count in profile.buckets.items():
+        name = symbols.lookup(address, profile.bucket_bytes) if symbols else None
+        names[address] = (name or "[outside the ELF]") if symbols else "0x%x" % address
+        by_function[names[address]] += count
+
+    print()
+    print("%8s %6s  %s" % ("samples", "%", "function"))
+    for name, count in by_function.most_common(top):
+        print("%8d %6.1f  %s" % (count, count * 100.0 / total, name))
+
+    if list_buckets:
+        ranked = sorted(profile.buckets.items(), key=lambda item: -item[1])[:top]
+        lines = lines_of(addr2line, elf, [address for address, _ in ranked]) if elf else {}
+        print()
+        print("%8s %6s  %-18s %s" % ("samples", "%", "bucket", "function"))
+        for address, count in ranked:
+            print("%8d %6.1f  0x%-16x %s %s" % (count, count * 100.0 / total, address,
+                                               names[address], lines.get(address, "")))
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="captured output of the application, "
+                        "or - for stdin")
+    parser.add_argument("--elf", help="the application's ELF file, to resolve addresses")
+    parser.add_argument("--nm", default="arm-none-eabi-nm",
+                        help="the nm to use (default %(default)s)")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line",
+                        help="the addr2line to use with --buckets (default %(default)s)")
+    parser.add_argument("--all", action="store_true",
+                        help="report every profile found, not just the last")
+    parser.add_argument("--buckets", action="store_true",
+                        help="also list the busiest buckets")
+    parser.add_argument("--top", type=int, default=20,
+                        help="the number of functions or buckets to list "
+                        "(default %(default)s)")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        lines = sys.stdin.read().splitlines()
+    else:
+        with open(args.input, errors="replace") as file:
+            lines = file.read().splitlines()
+    profiles = find_profiles(lines)
+    if not profiles:
+        print("No profile found.")
+        return 1
+    symbols = Symbols(args.nm, args.elf) if args.elf else None
+    for x, profile in enumerate(profiles if args.all else profiles[-1:]):
+        if x > 0:
+            print()
+        report(profile, symbols, args.addr2line, args.elf, args.top, args.buckets)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
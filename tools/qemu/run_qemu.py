@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Run the application's self-tests under QEMU and report the number
+of instructions executed in each stage.
+
+The application must have been built for ARM_MPS2_M3 with SEMIHOSTING
+defined, so that it marks each stage by calling semihostStageMark()
+and exits when the self-tests are done.  The stage_insns plugin counts
+the instructions between calls to semihostStageMark(); QEMU runs with
+-icount so that the ticker test, which is timed, costs the same number
+of instructions on every run.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+MARKER_SYMBOL = "semihostStageMark"
+
+def symbol_address(nm, elf, name):
+    """Return the address of a symbol in an ELF file."""
+    output = subprocess.run([nm, elf], check=True, stdout=subprocess.PIPE,
+                            universal_newlines=True).stdout
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[2] == name:
+            return int(fields[0], 16) & ~1
+    raise LookupError("%s not found in %s: was it built with -DSEMIHOSTING?" %
+                      (name, elf))
+
+def run(args):
+    """Run QEMU, returning its exit status, its output and the plugin's."""
+    address = symbol_address(args.nm, args.elf, MARKER_SYMBOL)
+    with tempfile.TemporaryDirectory() as directory:
+        log = os.path.join(directory, "plugin.log")
+        command = [args.qemu, "-M", args.machine, "-nographic",
+                   "-semihosting-config", "enable=on,target=native",
+                   "-icount", "shift=%d,align=off,sleep=off" % args.icount_shift,
+                   "-plugin", "%s,mark=0x%x" % (args.plugin, address),
+                   "-d", "plugin", "-D", log,
+                   "-kernel", args.elf]
+        try:
+            completed = subprocess.run(command, stdin=subprocess.DEVNULL,
+                                       stdout=subprocess.PIPE,
+                                       stderr=subprocess.STDOUT,
+                                       timeout=args.timeout)
+            status = completed.returncode
+            output = completed.stdout
+        except subprocess.TimeoutExpired as error:
+            status = None
+            output = error.stdout or b""
+        with open(log, "rb") as file:
+            plugin_output = file.read()
+    return (status, output.decode("utf-8", "replace"),
+            plugin_output.decode("utf-8", "replace"))
+
+def stage_costs(output, plugin_output):
+    """Pair the STAGE lines written by the application with the MARK
+    lines written by the plugin: the first MARK is the cost of start-up,
+    each subsequent one is the cost of the stage before it and the cost
+    of the last stage comes with END.  Costs of stages that are entered
+    more than once are summed, in order of first appearance."""
+    stages = [line[len("STAGE "):].strip() for line in output.splitlines()
+              if line.startswith("STAGE ")]
+    marks = []
+    total = None
+    for line in plugin_output.splitlines():
+        fields = line.split()
+        if len(fields) == 2 and fields[0] == "MARK":
+            marks.append(int(fields[1]))
+        elif len(fields) == 3 and fields[0] == "END":
+            marks.append(int(fields[1]))
+            total = int(fields[2])
+    if len(marks) != len(stages) + 1:
+        raise ValueError("%d stage(s) but %d mark(s)" % (len(stages), len(marks) - 1))
+    costs = {"start-up": marks[0]} if marks else {}
+    for (name, cost) in zip(stages, marks[1:]):
+        costs[name] = costs.get(name, 0) + cost
+    return (costs, total)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="the application, built with -DSEMIHOSTING")
+    parser.add_argument("--plugin", default=os.path.join(os.path.dirname(
+                            os.path.abspath(__file__)), "stage_insns.so"),
+                        help="the stage_insns plugin (default %(default)s)")
+    parser.add_argument("--qemu", default="qemu-system-arm",
+                        help="QEMU executable (default %(default)s)")
+    parser.add_argument("--machine", default="mps2-an385",
+                        help="QEMU machine (default %(default)s)")
+    parser.add_argument("--nm", default="arm-none-eabi-nm",
+                        help="nm executable (default %(default)s)")
+    parser.add_argument("--icount-shift", type=int, default=0,
+                        help="QEMU -icount shift (default %(default)s)")
+    parser.add_argument("--timeout", type=float, default=600,
+                        help="seconds to allow QEMU to run (default %(default)s)")
+    parser.add_argument("--csv", action="store_true",
+                        help="print stage,instructions lines for tracking per commit")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="show the application's output")
+    args = parser.parse_args()
+
+    (status, output, plugin_output) = run(args)
+    if args.verbose:
+        print(output)
+    if status is None:
+        print("FAILED: QEMU timed out.")
+        return 1
+    try:
+        (costs, total) = stage_costs(output, plugin_output)
+    except ValueError as error:
+        print("FAILED: %s." % error)
+        return 1
+
+    # "end" is the exit itself, not a stage worth reporting
+    costs.pop("end", None)
+    if args.csv:
+        for (name, cost) in costs.items():
+            print("%s,%d" % (name, cost))
+        if total is not None:
+            print("total,%d" % total)
+    else:
+        for (name, cost) in costs.items():
+            print("%14d  %s" % (cost, name))
+        if total is not None:
+            print("%14d  total" % total)
+    if status != 0:
+        print("FAILED: the self-tests reported failure (QEMU exit status %d)." % status)
+    return 0 if status == 0 else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,136 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A QEMU TCG plugin that counts the instructions executed between
+// calls to a marker function, at the address given by the plugin
+// argument "mark=<address>", writing a line of the form:
+//
+//   MARK <instructions since the previous mark>
+//
+// ...to the QEMU log each time the marker is reached, and:
+//
+//   END <instructions since the last mark> <total instructions>
+//
+// ...when QEMU exits.  Run QEMU with "-d plugin" to see them.  Only
+// one vCPU is expected, as on a Cortex-M machine.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+// ----------------------------------------------------------------
+// STATIC VARIABLES
+// ----------------------------------------------------------------
+
+// The address of the marker function, Thumb bit removed
+static uint64_t gMarkAddress = 0;
+
+// Instructions executed so far
+static uint64_t gInsnCount = 0;
+
+// The instruction count at the last mark
+static uint64_t gLastMarkCount = 0;
+
+// ----------------------------------------------------------------
+// STATIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Count the instructions of a translation block as it starts
+static void tbExec(unsigned int cpuIndex, void *pUserData)
+{
+    (void) cpuIndex;
+    gInsnCount += (uintptr_t) pUserData;
+}
+
+// The marker has been reached; pUserData is the number of
+// instructions in its block from the marker onwards, which have been
+// counted already but not yet executed
+static void markExec(unsigned int cpuIndex, void *pUserData)
+{
+    uint64_t count = gInsnCount - (uintptr_t) pUserData;
+    char buffer[64];
+
+    (void) cpuIndex;
+    snprintf(buffer, sizeof (buffer), "MARK %" PRIu64 "\n", count - gLastMarkCount);
+    qemu_plugin_outs(buffer);
+    gLastMarkCount = count;
+}
+
+// Instrument each translation block as it is translated
+static void tbTranslate(qemu_plugin_id_t id, struct qemu_plugin_tb *pTb)
+{
+    size_t numInsns = qemu_plugin_tb_n_insns(pTb);
+    struct qemu_plugin_insn *pInsn;
+
+    (void) id;
+    qemu_plugin_register_vcpu_tb_exec_cb(pTb, tbExec, QEMU_PLUGIN_CB_NO_REGS,
+                                         (void *) (uintptr_t) numInsns);
+    for (size_t x = 0; x < numInsns; x++)
+    {
+        pInsn = qemu_plugin_tb_get_insn(pTb, x);
+        if (qemu_plugin_insn_vaddr(pInsn) == gMarkAddress)
+        {
+            qemu_plugin_register_vcpu_insn_exec_cb(pInsn, markExec, QEMU_PLUGIN_CB_NO_REGS,
+                                                   (void *) (uintptr_t) (numInsns - x));
+        }
+    }
+}
+
+// Report what's left at exit
+static void atExit(qemu_plugin_id_t id, void *pUserData)
+{
+    char buffer[64];
+
+    (void) id;
+    (void) pUserData;
+    snprintf(buffer, sizeof (buffer), "END %" PRIu64 " %" PRIu64 "\n",
+             gInsnCount - gLastMarkCount, gInsnCount);
+    qemu_plugin_outs(buffer);
+}
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *pInfo,
+                                           int argc, char **argv)
+{
+    (void) pInfo;
+
+    for (int x = 0; x < argc; x++)
+    {
+        if (strncmp(argv[x], "mark=", 5) == 0)
+        {
+            gMarkAddress = strtoull(argv[x] + 5, NULL, 0) & ~1ULL;
+        }
+    }
+    if (gMarkAddress == 0)
+    {
+        fprintf(stderr, "stage_insns: no mark=<address> argument given.\n");
+        return -1;
+    }
+
+    qemu_plugin_register_vcpu_tb_trans_cb(id, tbTranslate);
+    qemu_plugin_register_atexit_cb(id, atExit, NULL);
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measure the echo loop's throughput, latency and losses at each baud rate.
+
+The application must have been built with SERIAL_BENCHMARK defined, so
+that Ctrl-B and a digit in the echo loop report what has been echoed
+and switch baud rate (see main.cpp).  For each baud rate this times
+single-byte round trips, then streams fixed and random patterns through
+the echo loop, keeping no more than --window bytes in flight, and
+reports the sustained throughput and the bytes dropped or corrupted,
+along with the receive overflows the application counted.  Give the
+serial port of the board, or --app and the host build of the
+application, which is then run on a pseudo-terminal.
+"""
+
+import argparse
+import difflib
+import os
+import random
+import re
+import select
+import subprocess
+import sys
+import termios
+import time
+import tty
+
+# The command characters of the echo loop (main.cpp), which the
+# patterns must not contain: the serial benchmark, the event trace
+# dump, the profile and the heap trace dump
+COMMAND_CHAR = 0x02
+RESERVED = {COMMAND_CHAR, 0x05, 0x10, 0x14}
+ALLOWED = bytes(x for x in range(256) if x not in RESERVED)
+
+REPORT = re.compile(rb"\*\*\* Serial benchmark: (\d+) byte\(s\) echoed, "
+                    rb"(\d+) receive overflow\(s\)"
+                    rb"(?:, now (\d+) baud\.|, baud rates ([ 0-9*]+)\.)\r?\n")
+
+class Port:
+    """A serial port or pseudo-terminal, in raw mode."""
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        tty.setraw(self.fd)
+
+    def set_baud(self, baud):
+        """Set the baud rate, if the port has one (a pty need not)."""
+        speed = getattr(termios, "B%d" % baud, None)
+        if speed is None:
+            print("Warning: no termios setting for %d baud." % baud, file=sys.stderr)
+            return
+        try:
+            attributes = termios.tcgetattr(self.fd)
+            attributes[4] = attributes[5] = speed
+            termios.tcsetattr(self.fd, termios.TCSADRAIN, attributes)
+        except termios.error:
+            pass
+
+    def write(self, data):
+        while data:
+            select.select([], [self.fd], [])
+            written = os.write(self.fd, data)
+            data = data[written:]
+
+    def read(self, timeout):
+        """Return what has arrived within timeout seconds, maybe b""."""
+        readable, _, _ = select.select([self.fd], [], [], max(timeout, 0))
+        if readable:
+            try:
+                return os.read(self.fd, 4096)
+            except BlockingIOError:
+                pass
+        return b""
+
+    def close(self):
+        os.close(self.fd)
+
+def launch(app, timeout):
+    """Run the host build on a pseudo-terminal, returning the process
+    and the name of the pseudo-terminal."""
+    env = dict(os.environ, MBED_HOST_PTY="1")
+    process = subprocess.Popen([app], stdout=subprocess.DEVNULL,
+                               stderr=subprocess.PIPE, env=env)
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = process.stderr.readline()
+        if not line:
+            break
+        if line.startswith(b"pty: "):
+            return process, line[5:].strip().decode()
+    process.kill()
+    raise RuntimeError("the application did not open a pseudo-terminal")
+
+def command(port, argument, timeout):
+    """Send a serial benchmark command and return its report: the bytes
+    echoed, the receive overflows, the new baud rate or None, and the
+    list of baud rates with the one in use or None."""
+    port.write(bytes([COMMAND_CHAR]) + argument)
+    output = b""
+    deadline = time.monotonic() + timeout
+    while True:
+        match = REPORT.search(output)
+        if match:
+            break
+        if time.monotonic() > deadline:
+            raise TimeoutError("no response to the serial benchmark command; "
+                               "was the application built with SERIAL_BENCHMARK?")
+        output += port.read(deadline - time.monotonic())
+    rates = None
+    if match.group(4):
+        rates = [(int(x.rstrip(b"*")), x.endswith(b"*")) for x in match.group(4).split()]
+    baud = int(match.group(3)) if match.group(3) else None
+    return int(match.group(1)), int(match.group(2)), baud, rates
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))]
+
+def measure_latency(port, samples, rng, timeout):
+    """Time single-byte round trips, returning them in seconds, or None
+    for a byte that did not come back."""
+    times = []
+    for _ in range(samples):
+        byte = bytes([rng.choice(ALLOWED)])
+        start = time.monotonic()
+        port.write(byte)
+        received = b""
+        while not received and time.monotonic() - start < timeout:
+            received = port.read(timeout - (time.monotonic() - start))
+        times.append(time.monotonic() - start if received == byte else None)
+    return times
+
+def make_patterns(size, rng):
+    """Return the patterns to stream, by name."""
+    counting = bytes(ALLOWED[x % len(ALLOWED)] for x in range(size))
+    return [("0x55", b"\x55" * size),
+            ("0xaa", b"\xaa" * size),
+            ("0x00", b"\x00" * size),
+            ("0xff", b"\xff" * size),
+            ("counting", counting),
+            ("random", bytes(rng.choice(ALLOWED) for _ in range(size)))]
+
+def stream(port, payload, window, idle_timeout):
+    """Send payload, keeping at most window bytes unechoed, and collect
+    the echo; bytes still unechoed after idle_timeout are written off
+    as lost so that sending can go on.  Returns what came back and the
+    time from the first byte sent to the last byte received."""
+    received = bytearray()
+    sent = 0
+    written_off = 0
+    start = time.monotonic()
+    last = start
+    while True:
+        in_flight = sent - len(received) - written_off
+        if (sent < len(payload)) and (in_flight < window):
+            size = min(window - in_flight, len(payload) - sent)
+            port.write(payload[sent:sent + size])
+            sent += size
+            continue
+        data = port.read(idle_timeout - (time.monotonic() - last))
+        now = time.monotonic()
+        if data:
+            received += data
+            last = now
+        elif now - last >= idle_timeout:
+            if sent >= len(payload):
+                break
+            written_off += max(in_flight, 0)
+            last = now
+        if len(received) >= len(payload):
+            break
+    return bytes(received), last - start
+
+def compare(sent, received):
+    """Return the number of bytes dropped and corrupted (changed or
+    extra) between what was sent and what came back."""
+    dropped = 0
+    corrupted = 0
+    matcher = difflib.SequenceMatcher(None, sent, received, autojunk=False)
+    for tag, i1, i2, j1, j2 in matcher.get_opcodes():
+        if tag == "delete":
+            dropped += i2 - i1
+        elif tag == "insert":
+            corrupted += j2 - j1
+        elif tag == "replace":
+            corrupted += max(i2 - i1, j2 - j1) - max((i2 - i1) - (j2 - j1), 0)
+            dropped += max((i2 - i1) - (j2 - j1), 0)
+    return dropped, corrupted
+
+def benchmark_rate(port, index, baud, args, rng):
+    """Switch to a baud rate, run the tests at it and print the results.
+    Returns True if nothing was lost."""
+    _, _, now, _ = command(port, str(index).encode(), args.timeout)
+    if now != baud:
+        raise RuntimeError("asked for %d baud, the application went to %s" % (baud, now))
+    port.set_baud(baud)
+    time.sleep(args.settle)
+    # Anything received while the two ends were at different rates
+    while port.read(0.05):
+        pass
+
+    clean = True
+    times = measure_latency(port, args.latency_samples, rng, args.timeout)
+    good = [x for x in times if x is not None]
+    if good:
+        print("%8d  %-9s p50 %.2f ms, p99 %.2f ms, max %.2f ms (%d sample(s), %d lost)" %
+              (baud, "latency", percentile(good, 0.5) * 1000, percentile(good, 0.99) * 1000,
+               max(good) * 1000, len(times), len(times) - len(good)))
+    else:
+        print("%8d  %-9s no bytes came back" % (baud, "latency"))
+    clean = clean and (len(good) == len(times))
+
+    idle_timeout = max(0.2, 200.0 / baud)
+    for name, payload in make_patterns(args.bytes, rng):
+        received, elapsed = stream(port, payload, args.window, idle_timeout)
+        dropped, corrupted = compare(payload, received)
+        rate = len(received) / elapsed if elapsed > 0 else 0
+        print("%8d  %-9s %8d %8d %8d %10.0f %8.0f%%" %
+              (baud, name, len(payload), dropped, corrupted, rate, rate * 1000 / baud))
+        clean = clean and (dropped == 0) and (corrupted == 0)
+
+    echoed, overflows, _, _ = command(port, str(index).encode(), args.timeout)
+    print("%8d  %-9s %d byte(s) echoed, %d receive overflow(s)" % (baud, "device", echoed, overflows))
+    return clean and (overflows == 0)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?", help="the serial port of the board")
+    parser.add_argument("--app", help="the host build of the application, to run on a pty instead")
+    parser.add_argument("--bauds", help="comma-separated baud rates to test "
+                        "(default all those the application offers)")
+    parser.add_argument("-n", "--bytes", type=int, default=2048,
+                        help="bytes in each pattern (default %(default)s)")
+    parser.add_argument("-w", "--window", type=int, default=128,
+                        help="most bytes sent ahead of the echo; above the application's "
+                        "receive buffer (256) it may overflow (default %(default)s)")
+    parser.add_argument("-l", "--latency-samples", type=int, default=100,
+                        help="round trips to time (default %(default)s)")
+    parser.add_argument("--seed", type=int, default=0x1ceb00da,
+                        help="seed for the random pattern (default %(default)s)")
+    parser.add_argument("--settle", type=float, default=0.1,
+                        help="seconds to wait after changing baud rate (default %(default)s)")
+    parser.add_argument("-t", "--timeout", type=float, default=30,
+                        help="seconds to wait for the application (default %(default)s)")
+    args = parser.parse_args()
+    if bool(args.port) == bool(args.app):
+        parser.error("give either a serial port or --app")
+
+    process = None
+    if args.app:
+        process, path = launch(args.app, args.timeout)
+    else:
+        path = args.port
+    port = Port(path)
+    rng = random.Random(args.seed)
+    try:
+        # The application starts at the first of its rates
+        _, _, _, rates = command(port, b"?", args.timeout)
+        bauds = [baud for baud, _ in rates]
+        start_index = next(x for x, (_, current) in enumerate(rates) if current)
+        print("Baud rates offered: %s." % " ".join(str(x) for x in bauds))
+        wanted = [int(x) for x in args.bauds.split(",")] if args.bauds else bauds
+        print("%8s  %-9s %8s %8s %8s %10s %9s" %
+              ("baud", "test", "bytes", "dropped", "corrupt", "bytes/s", "of line"))
+        reliable = []
+        for baud in wanted:
+            if baud not in bauds:
+                print("%8d  not offered by the application" % baud)
+                continue
+            if benchmark_rate(port, bauds.index(baud), baud, args, rng):
+                reliable.append(baud)
+        command(port, str(start_index).encode(), args.timeout)
+        port.set_baud(bauds[start_index])
+        if reliable:
+            print("Highest baud rate with nothing lost: %d." % max(reliable))
+        else:
+            print("Something was lost at every baud rate tested.")
+    except (TimeoutError, RuntimeError) as error:
+        print("FAILED: %s" % error)
+        return 1
+    finally:
+        port.close()
+        if process:
+            process.kill()
+            process.wait()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,85 @@
+# PackageLicenseDeclared: Apache-2.0
+# Copyright (c) 2015 ARM Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Find and read the binary dumps of the application's trace ring
+buffers (see trace_ring.h), shared by the event trace and heap trace
+decoders.
+
+A dump is a header, "<4sBBHIIII": the magic, the version, a byte whose
+meaning is up to the format, the record size, the timestamp counts per
+microsecond, the events recorded since start-up, those dropped during
+a dump and the number of records that follow; then anything the
+format puts before its records; then the records, oldest first, each
+starting with a 32-bit timestamp.
+"""
+
+import collections
+import struct
+import sys
+
+HEADER_FORMAT = "<4sBBHIIII"
+
+Header = collections.namedtuple("Header", "detail record_size counts_per_us "
+                                "num_events num_dropped num_records")
+
+def read_header(data, offset, version):
+    """Return the header of the dump at offset and the offset after it;
+    raises ValueError if it is truncated or of another version."""
+    size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < offset + size:
+        raise ValueError("truncated header at offset %d" % offset)
+    fields = struct.unpack_from(HEADER_FORMAT, data, offset)
+    if fields[1] != version:
+        raise ValueError("unknown version %d at offset %d" % (fields[1], offset))
+    return Header(*fields[2:]), offset + size
+
+def read_records(data, offset, header, record_format):
+    """Return the records of a dump, starting at offset, as tuples of
+    their fields with the timestamp unwrapped and converted to
+    microseconds from the first, and the offset after them; raises
+    ValueError if they don't match record_format or are truncated."""
+    record_size = struct.calcsize(record_format)
+    if record_size != header.record_size:
+        raise ValueError("unexpected record size %d" % header.record_size)
+    if len(data) < offset + header.num_records * record_size:
+        raise ValueError("truncated dump: %d record(s) expected" % header.num_records)
+    records = []
+    previous = None
+    counts = 0
+    for _ in range(header.num_records):
+        fields = struct.unpack_from(record_format, data, offset)
+        offset += record_size
+        if previous is not None:
+            counts += (fields[0] - previous) & 0xffffffff
+        previous = fields[0]
+        records.append((counts / max(header.counts_per_us, 1),) + fields[1:])
+    return records, offset
+
+def find_dumps(data, magic, decode):
+    """Return every dump in the data starting with magic, in order, as
+    decoded by decode(data, offset), which must give an object with the
+    offset after the dump in its end attribute and raise ValueError if
+    the dump can't be decoded; such dumps are skipped."""
+    dumps = []
+    offset = data.find(magic)
+    while offset >= 0:
+        try:
+            dump = decode(data, offset)
+            dumps.append(dump)
+            offset = data.find(magic, dump.end)
+        except ValueError as error:
+            print("Skipping a dump: %s" % error, file=sys.stderr)
+            offset = data.find(magic, offset + len(magic))
+    return dumps
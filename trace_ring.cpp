@@ -0,0 +1,93 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "trace_ring.h"
+#include "cycle_counter.h"
+
+#if defined(EVENT_TRACE) || defined(HEAP_TRACE)
+
+// ----------------------------------------------------------------
+// PUBLIC FUNCTIONS
+// ----------------------------------------------------------------
+
+// Claim a slot
+void * traceRingClaim(TraceRing_t *pRing)
+{
+    void *pRecord = NULL;
+
+    if (pRing->dumping)
+    {
+        pRing->numDropped++;
+    }
+    else
+    {
+        pRecord = (char *) pRing->pRecords +
+                  (pRing->numEvents & (pRing->numRecords - 1)) * pRing->recordSizeBytes;
+        pRing->numEvents++;
+    }
+
+    return pRecord;
+}
+
+// Dump the ring buffer
+uint32_t traceRingDump(TraceRing_t *pRing, const char *pMagic, uint8_t version, uint8_t detail,
+                       const char * const *ppStrings, uint32_t numStrings,
+                       int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam)
+{
+    TraceRingHeader_t header;
+    uint32_t numEvents;
+    uint32_t primask;
+
+    if (pWrite == NULL)
+    {
+        return 0;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pRing->dumping = true;
+    numEvents = pRing->numEvents;
+    __set_PRIMASK(primask);
+
+    memcpy(header.magic, pMagic, sizeof (header.magic));
+    header.version = version;
+    header.detail = detail;
+    header.recordSizeBytes = pRing->recordSizeBytes;
+    header.countsPerUs = cycleCounterPerUs();
+    header.numEvents = numEvents;
+    header.numDropped = pRing->numDropped;
+    header.numRecords = (numEvents < pRing->numRecords) ? numEvents : pRing->numRecords;
+    pWrite(pParam, (const char *) &header, sizeof (header));
+
+    for (uint32_t x = 0; x < numStrings; x++)
+    {
+        pWrite(pParam, ppStrings[x], strlen(ppStrings[x]) + 1);
+    }
+
+    for (uint32_t x = numEvents - header.numRecords; x != numEvents; x++)
+    {
+        pWrite(pParam, (const char *) pRing->pRecords + (x & (pRing->numRecords - 1)) * pRing->recordSizeBytes,
+               pRing->recordSizeBytes);
+    }
+
+    pRing->dumping = false;
+
+    return header.numRecords;
+}
+
+#endif // EVENT_TRACE || HEAP_TRACE
@@ -0,0 +1,90 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2015 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TRACE_RING_H_
+#define _TRACE_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The ring buffer of fixed-size records and the binary dump of it that
+// the event trace (event_trace.h) and the heap trace (heap_trace.h)
+// share: recording masks interrupts for the few instructions of
+// claiming a slot and filling it, and records that come while the
+// buffer is being dumped are counted as dropped rather than written
+// over the records on their way out.  tools/trace_dump/trace_dump.py
+// finds and reads the dumps for the decoders.
+
+// ----------------------------------------------------------------
+// COMPILE-TIME CONSTANTS
+// ----------------------------------------------------------------
+
+// Set up a TraceRing_t over an array of records, whose number must be
+// a power of two
+#define TRACE_RING_INIT(records) {(records), sizeof ((records)[0]),   \
+                                  sizeof (records) / sizeof ((records)[0]), 0, 0, false}
+
+// ----------------------------------------------------------------
+// TYPES
+// ----------------------------------------------------------------
+
+// A ring buffer of records
+typedef struct
+{
+    void * pRecords;
+    uint16_t recordSizeBytes;
+    uint32_t numRecords;       // A power of two
+    volatile uint32_t numEvents;  // Recorded, which also gives the next slot
+    volatile uint32_t numDropped; // Not recorded as they came during a dump
+    volatile bool dumping;
+} TraceRing_t;
+
+// The header of a dump, all little-endian, which is followed by
+// whatever the format puts before its records and then by numRecords
+// records, oldest first, each starting with a timestamp
+typedef struct
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t detail;            // Up to the format
+    uint16_t recordSizeBytes;
+    uint32_t countsPerUs;      // Of the timestamps
+    uint32_t numEvents;        // Recorded since start-up
+    uint32_t numDropped;       // Not recorded as they came during a dump
+    uint32_t numRecords;
+} TraceRingHeader_t;
+
+// ----------------------------------------------------------------
+// FUNCTIONS
+// ----------------------------------------------------------------
+
+// Return the slot for the next record, to be filled in before
+// interrupts are unmasked, or NULL, counting the record as dropped,
+// if the ring is being dumped.  Call with interrupts masked.
+void * traceRingClaim(TraceRing_t *pRing);
+
+// Write a dump of pRing through pWrite, which should return the number
+// of bytes written, blocking as necessary: the header, with magic (four
+// characters), version and detail, then numStrings NUL-terminated
+// strings from ppStrings, then the records.  Records are not added
+// during the dump.
+// Returns the number of records dumped.
+uint32_t traceRingDump(TraceRing_t *pRing, const char *pMagic, uint8_t version, uint8_t detail,
+                       const char * const *ppStrings, uint32_t numStrings,
+                       int (*pWrite)(void *pParam, const char *pBuf, int size), void *pParam);
+
+#endif // _TRACE_RING_H_